@@ -0,0 +1,152 @@
+#include <errno.h>
+#include <stdarg.h>
+#include "P528Drvr.h"
+
+#ifdef DRVR_ZLIB
+#include <zlib.h>
+#ifdef _WIN32
+#include <io.h>
+#define dup _dup
+#else
+#include <unistd.h>
+#endif
+#endif
+
+OutputWriter::OutputWriter() : buffer(OUTPUT_BUFFER_SIZE) {}
+
+OutputWriter::~OutputWriter() {
+    if (fp != NULL || gz != NULL)
+        Close();
+}
+
+/*=============================================================================
+ |
+ |  Description:  Opens the output of the writer
+ |
+ |        Input:  filename      - Output file, or stdout if empty
+ |                gzip          - Compress the output with gzip.  Requires a
+ |                                driver built with DRVR_ZLIB
+ |
+ |      Returns:  SUCCESS, or the error of opening the file
+ |
+ *===========================================================================*/
+int OutputWriter::Open(const char* filename, bool gzip) {
+    used = 0;
+    ok = true;
+
+    if (gzip) {
+#ifdef DRVR_ZLIB
+        gzFile file;
+        if (strlen(filename) > 0)
+            file = gzopen(filename, OUTPUT_GZIP_MODE);
+        else {
+            // compress onto a copy of stdout, so closing leaves stdout open
+            fflush(stdout);
+            file = gzdopen(dup(fileno(stdout)), OUTPUT_GZIP_MODE);
+        }
+
+        if (file == NULL)
+            return (errno != 0) ? errno : DRVRERR__OUTPUT_WRITE;
+
+        gzbuffer(file, OUTPUT_BUFFER_SIZE);
+        gz = file;
+        return SUCCESS;
+#else
+        return DRVRERR__OUTPUT_UNSUPPORTED;
+#endif
+    }
+
+    if (strlen(filename) == 0) {
+        fp = stdout;
+        return SUCCESS;
+    }
+
+    return fopen_s(&fp, filename, "w");
+}
+
+/*=============================================================================
+ |
+ |  Description:  Writes out what is left in the buffer and closes the
+ |                output.  stdout is flushed but left open
+ |
+ |      Returns:  False if any write failed
+ |
+ *===========================================================================*/
+bool OutputWriter::Close() {
+    Flush();
+
+#ifdef DRVR_ZLIB
+    if (gz != NULL) {
+        if (gzclose((gzFile)gz) != Z_OK)
+            ok = false;
+        gz = NULL;
+    }
+#endif
+
+    if (fp != NULL) {
+        if (fflush(fp) != 0 || ferror(fp))
+            ok = false;
+        if (fp != stdout && fclose(fp) != 0)
+            ok = false;
+        fp = NULL;
+    }
+
+    return ok;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Writes printf formatted text, for the few lines that are
+ |                not plain numbers
+ |
+ |        Input:  format        - printf format, then its arguments
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void OutputWriter::Format(const char* format, ...) {
+    char line[BATCH_LINE_SIZE];
+
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+
+    if (length < (int)sizeof(line)) {
+        Text(line);
+        return;
+    }
+
+    std::vector<char> long_line(length + 1);
+    va_start(args, format);
+    vsnprintf(long_line.data(), long_line.size(), format, args);
+    va_end(args);
+
+    Text(long_line.data());
+}
+
+/*=============================================================================
+ |
+ |  Description:  Writes out the buffer as one block
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void OutputWriter::Flush() {
+    Write(buffer.data(), used);
+    used = 0;
+}
+
+void OutputWriter::Write(const char* data, size_t size) {
+    if (size == 0 || !ok)
+        return;
+
+#ifdef DRVR_ZLIB
+    if (gz != NULL) {
+        ok = gzwrite((gzFile)gz, data, (unsigned int)size) == (int)size;
+        return;
+    }
+#endif
+
+    ok = fp != NULL && fwrite(data, 1, size, fp) == size;
+}
@@ -1,7 +1,9 @@
 #include <ctime>
+#include <ctype.h>
 #include <iostream>
+#include <math.h>
 #include <string.h>
-#include <Windows.h>
+#include <thread>
 #include "P528Drvr.h"
 
 /*=============================================================================
@@ -13,7 +15,9 @@
  *===========================================================================*/
 
  // Local globals
+#ifdef _WIN32
 HINSTANCE hLib;
+#endif
 p528func dllP528;
 
 int dllVerMajor = NOT_SET;
@@ -21,7 +25,17 @@ int dllVerMinor = NOT_SET;
 int drvrVerMajor = NOT_SET;
 int drvrVerMinor = NOT_SET;
 
-wchar_t buf[TIME_SIZE];
+char buf[TIME_SIZE];
+
+// Columns of the data tables, in order
+const double TABLE_H_1__METER[TABLE_COLUMNS] = { 1.5, 15, 30, 60, 1000, 1.5, 15, 30, 60, 1000, 10000,
+    1.5, 15, 30, 60, 1000, 10000, 20000 };
+const double TABLE_H_2__METER[TABLE_COLUMNS] = { 1000, 1000, 1000, 1000, 1000, 10000, 10000, 10000, 10000, 10000,
+    10000, 20000, 20000, 20000, 20000, 20000, 20000, 20000 };
+
+// Frequencies and time percentages of the data set distributed from the Study Group 3 website
+const double DATASET_F__MHZ[DATASET_FREQUENCIES] = { 125, 300, 600, 1200, 2400, 5100, 9400, 15500 };
+const double DATASET_P[DATASET_PERCENTAGES] = { 1, 5, 10, 50, 95 };
 
 /*=============================================================================
  |
@@ -34,7 +48,11 @@ int main(int argc, char** argv) {
 
     // Get the time
     time_t t = time(NULL);
-    _wctime_s(buf, TIME_SIZE, &t);
+#ifdef _WIN32
+    ctime_s(buf, TIME_SIZE, &t);
+#else
+    ctime_r(&t, buf);
+#endif
 
     rtn = ParseArguments(argc, argv, &params);
     if (rtn == DRVR__RETURN_SUCCESS)
@@ -68,19 +86,42 @@ int main(int argc, char** argv) {
     case MODE_TABLE:
         rtn = CallP528_TABLE(&params);
         break;
+    case MODE_PACK:
+        rtn = CallP528_PACK(&params);
+        break;
+    case MODE_BATCH:
+        rtn = CallP528_BATCH(&params);
+        break;
+    case MODE_DATASET:
+        rtn = CallP528_DATASET(&params);
+        break;
+    case MODE_MERGE:
+        rtn = CallP528_MERGE(&params);
+        break;
+    case MODE_SERVE:
+        rtn = CallP528_SERVE(&params);
+        break;
+    case MODE_QUERY:
+        rtn = CallP528_QUERY(&params);
+        break;
+    case MODE_TRACK:
+        rtn = CallP528_TRACK(&params);
+        break;
     case MODE_VERSION:
         printf_s("*******************************************************\n");
         printf_s("Institute for Telecommunications Sciences - Boulder, CO\n");
         printf_s("\tP.528 Driver Version: %i.%i\n", drvrVerMajor, drvrVerMinor);
         printf_s("\tP.528 DLL Version: %i.%i\n", dllVerMajor, dllVerMinor);
-        wprintf_s(L"Time: %s", buf);
+        printf_s("Time: %s", buf);
         printf_s("*******************************************************\n");
         break;
     default:
         Help();
     }
 
+#ifdef _WIN32
     FreeModule(hLib);
+#endif
 
     return rtn;
 }
@@ -89,7 +130,10 @@ int main(int argc, char** argv) {
  |
  |  Description:  Generates a data table of P.528 values, per the format of
  |                the data files currently distributed from the Study
- |                Group 3 website.
+ |                Group 3 website.  Each (h_1, h_2) column is a loss-vs-
+ |                distance curve over one path context, evaluated on a
+ |                worker thread.  The contexts share the geometry of the
+ |                terminal heights common to several columns
  |
  |        Input:  params        - Structure with user input parameters
  |
@@ -97,83 +141,444 @@ int main(int argc, char** argv) {
  |
  *===========================================================================*/
 int CallP528_TABLE(DrvrParams* params) {
-    Result result;
+    initpathcontextsfunc dllP528_InitPathContexts = GET_FUNCTION(initpathcontextsfunc, P528_InitPathContexts);
+    contextfunc dllP528_Context = GET_FUNCTION(contextfunc, P528_Context);
+    if (dllP528_InitPathContexts == nullptr || dllP528_Context == nullptr)
+        return DRVRERR__GETP528_FUNC_LOADING;
 
-    FILE* fp;
-    int err = fopen_s(&fp, params->out_file, "w");
+    OutputWriter out;
+    int err = out.Open(params->out_file, params->gzip);
     if (err != 0) {
         printf_s("Error opening output file.  Exiting.\n");
         return err;
     }
-    else {
-        fprintf_s(fp, "%fMHz / Lb(%f) dB\n", params->f__mhz, params->p);
-        fprintf_s(fp, ",h2(m),1000,1000,1000,1000,1000,10000,10000,10000,10000,10000,10000,20000,20000,20000,20000,20000,20000,20000\n");
-        fprintf_s(fp, ",h1(m),1.5,15,30,60,1000,1.5,15,30,60,1000,10000,1.5,15,30,60,1000,10000,20000\n");
-        fprintf_s(fp, "D (km),FSL\n");
 
+    PathContext contexts[TABLE_COLUMNS];
+    int rtn = dllP528_InitPathContexts(TABLE_H_1__METER, TABLE_H_2__METER, TABLE_COLUMNS, params->f__mhz,
+        params->T_pol, contexts);
+    if (rtn != SUCCESS) {
+        printf_s("P.528 returned error %i.  Exiting.\n", rtn);
+        out.Close();
+        return rtn;
+    }
+
+    std::vector<double> A__db(TABLE_COLUMNS * CURVE_POINTS);
+    std::vector<double> A_fs__db(CURVE_POINTS);
+
+    int threads = params->threads;
+    if (threads == NOT_SET)
+        threads = (std::thread::hardware_concurrency() > 0) ? (int)std::thread::hardware_concurrency() : 1;
+    if (threads > TABLE_COLUMNS)
+        threads = TABLE_COLUMNS;
+
+    std::atomic<int> next(0);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; i++)
+        workers.push_back(std::thread(EvaluateTableColumns, dllP528_Context, contexts, params->p, &next,
+            A__db.data(), A_fs__db.data()));
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+
+    WriteTable(&out, params->f__mhz, params->p, A_fs__db.data(), A__db.data());
+    if (!out.Close()) {
+        printf_s("Error writing output file.  Exiting.\n");
+        return DRVRERR__OUTPUT_WRITE;
+    }
+
+    return SUCCESS;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Writes a data table, per the format of the data files
+ |                distributed from the Study Group 3 website
+ |
+ |        Input:  out           - Output file
+ |                f__mhz        - Frequency, in MHz
+ |                p             - Time percentage
+ |                A_fs__db      - Free space loss over the 1 km grid
+ |                A__db         - Basic transmission loss of each column
+ |                                over the 1 km grid, column-major
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void WriteTable(OutputWriter* out, double f__mhz, double p, const double* A_fs__db, const double* A__db) {
+    out->Format("%fMHz / Lb(%f) dB\n", f__mhz, p);
+    out->Text(",h2(m),1000,1000,1000,1000,1000,10000,10000,10000,10000,10000,10000,20000,20000,20000,20000,20000,20000,20000\n");
+    out->Text(",h1(m),1.5,15,30,60,1000,1.5,15,30,60,1000,10000,1.5,15,30,60,1000,10000,20000\n");
+    out->Text("D (km),FSL\n");
+
+    for (int d__km = 0; d__km < CURVE_POINTS; d__km++) {
+        out->Int(d__km);
+        out->Char(',');
+        out->Fixed(A_fs__db[d__km]);
+        for (int column = 0; column < TABLE_COLUMNS; column++) {
+            out->Char(',');
+            out->Fixed(A__db[column * CURVE_POINTS + d__km]);
+        }
+        out->Char('\n');
+    }
+}
+
+/*=============================================================================
+ |
+ |  Description:  Worker thread of TABLE mode.  Claims columns until none
+ |                are left, and evaluates each over the 1 km grid
+ |
+ |        Input:  context_func  - P528_Context() of the DLL
+ |                contexts      - Path context of each column
+ |                p             - Time percentage
+ |                next          - First column not yet claimed
+ |
+ |      Outputs:  A__db         - Basic transmission loss, column-major
+ |                A_fs__db      - Free space loss of the first column
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void EvaluateTableColumns(contextfunc context_func, const PathContext* contexts, double p, std::atomic<int>* next,
+    double* A__db, double* A_fs__db) {
+    Result result;
+
+    for (int column = next->fetch_add(1); column < TABLE_COLUMNS; column = next->fetch_add(1)) {
         for (int d__km = 0; d__km < CURVE_POINTS; d__km++) {
-            fprintf_s(fp, "%i", d__km);
+            context_func(&contexts[column], d__km, p, &result);
+            A__db[column * CURVE_POINTS + d__km] = result.A__db;
+            if (column == 0)
+                A_fs__db[d__km] = result.A_fs__db;
+        }
+    }
+}
 
-            dllP528(d__km, 1.5, 1000, params->f__mhz, params->T_pol, params->p, &result);    // FSL
-            fprintf_s(fp, ",%.3f", result.A_fs__db);
-            fprintf_s(fp, ",%.3f", result.A__db);
+/*=============================================================================
+ |
+ |  Description:  Generates the complete data set distributed from the Study
+ |                Group 3 website: one data table for every frequency and
+ |                time percentage.  The contexts of every frequency and
+ |                column are built first, then the (f, p, column) tasks are
+ |                evaluated by a pool of worker threads.
+ |
+ |                With -shards N, the tasks are dealt round-robin to N
+ |                shards, which run as separate processes.  Shard k
+ |                evaluates only its tasks, and writes them to
+ |                shard_k_of_N.bin in task order, so rerunning a shard gives
+ |                the same file.  MERGE mode assembles the tables.  Each
+ |                shard file holds a header followed by its tasks:
+ |
+ |                   0  char[8]   magic, "P528SHRD"
+ |                   8  int32     shard
+ |                  12  int32     number of shards
+ |                  16  int32     T_pol
+ |                  20  int32     number of tasks in the whole data set
+ |                  24  double[]  loss of each task over the 1 km grid, with
+ |                                the free space loss after it for column 0
+ |
+ |                Values are in the host byte order
+ |
+ |        Input:  params        - Structure with user input parameters
+ |
+ |      Returns:  SUCCESS or error code
+ |
+ *===========================================================================*/
+int CallP528_DATASET(DrvrParams* params) {
+    initpathcontextsfunc dllP528_InitPathContexts = GET_FUNCTION(initpathcontextsfunc, P528_InitPathContexts);
+    contextfunc dllP528_Context = GET_FUNCTION(contextfunc, P528_Context);
+    if (dllP528_InitPathContexts == nullptr || dllP528_Context == nullptr)
+        return DRVRERR__GETP528_FUNC_LOADING;
 
-            dllP528(d__km, 15, 1000, params->f__mhz, params->T_pol, params->p, &result);
-            fprintf_s(fp, ",%.3f", result.A__db);
+    int shards = (params->shards == NOT_SET) ? 1 : params->shards;
+    int shard = (params->shard == NOT_SET) ? 0 : params->shard;
+
+    // Tasks of this shard, in increasing order
+    std::vector<int> tasks;
+    for (int task = shard; task < DATASET_TASKS; task += shards)
+        tasks.push_back(task);
+
+    int threads = params->threads;
+    if (threads == NOT_SET)
+        threads = (std::thread::hardware_concurrency() > 0) ? (int)std::thread::hardware_concurrency() : 1;
+
+    /////////////////////////////////////////////
+    // Path contexts of every frequency and column
+    //
+
+    std::vector<PathContext> contexts(DATASET_FREQUENCIES * TABLE_COLUMNS);
+    std::vector<int> init_rtn(DATASET_FREQUENCIES);
+    std::atomic<int> next(0);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads && i < DATASET_FREQUENCIES; i++)
+        workers.push_back(std::thread(InitDatasetContexts, dllP528_InitPathContexts, params->T_pol, &next,
+            contexts.data(), init_rtn.data()));
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+
+    for (int i_f = 0; i_f < DATASET_FREQUENCIES; i_f++) {
+        if (init_rtn[i_f] != SUCCESS) {
+            printf_s("P.528 returned error %i.  Exiting.\n", init_rtn[i_f]);
+            return init_rtn[i_f];
+        }
+    }
 
-            dllP528(d__km, 30, 1000, params->f__mhz, params->T_pol, params->p, &result);
-            fprintf_s(fp, ",%.3f", result.A__db);
+    //
+    // Path contexts of every frequency and column
+    /////////////////////////////////////////////
 
-            dllP528(d__km, 60, 1000, params->f__mhz, params->T_pol, params->p, &result);
-            fprintf_s(fp, ",%.3f", result.A__db);
+    /////////////////////////////////////////////
+    // Evaluate the tasks
+    //
 
-            dllP528(d__km, 1000, 1000, params->f__mhz, params->T_pol, params->p, &result);
-            fprintf_s(fp, ",%.3f", result.A__db);
+    // Results of the whole data set, indexed by task; only this shard's are filled
+    std::vector<double> A__db((size_t)DATASET_TASKS * CURVE_POINTS);
+    std::vector<double> A_fs__db((size_t)DATASET_FREQUENCIES * DATASET_PERCENTAGES * CURVE_POINTS);
 
-            dllP528(d__km, 1.5, 10000, params->f__mhz, params->T_pol, params->p, &result);
-            fprintf_s(fp, ",%.3f", result.A__db);
+    next = 0;
+    workers.clear();
+    for (int i = 0; i < threads; i++)
+        workers.push_back(std::thread(EvaluateDatasetTasks, dllP528_Context, contexts.data(), tasks.data(),
+            (int)tasks.size(), &next, A__db.data(), A_fs__db.data()));
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
 
-            dllP528(d__km, 15, 10000, params->f__mhz, params->T_pol, params->p, &result);
-            fprintf_s(fp, ",%.3f", result.A__db);
+    //
+    // Evaluate the tasks
+    /////////////////////////////////////////////
 
-            dllP528(d__km, 30, 10000, params->f__mhz, params->T_pol, params->p, &result);
-            fprintf_s(fp, ",%.3f", result.A__db);
+    if (params->shards == NOT_SET)
+        return WriteDatasetTables(params->out_file, params->gzip, params->T_pol, A__db.data(), A_fs__db.data());
 
-            dllP528(d__km, 60, 10000, params->f__mhz, params->T_pol, params->p, &result);
-            fprintf_s(fp, ",%.3f", result.A__db);
+    char filename[512];
+    snprintf(filename, sizeof(filename), "%s/shard_%i_of_%i.bin", params->out_file, shard, shards);
 
-            dllP528(d__km, 1000, 10000, params->f__mhz, params->T_pol, params->p, &result);
-            fprintf_s(fp, ",%.3f", result.A__db);
+    FILE* fp;
+    int err = fopen_s(&fp, filename, "wb");
+    if (err != 0) {
+        printf_s("Error opening shard file.  Exiting.\n");
+        return DRVRERR__SHARD_FILE;
+    }
 
-            dllP528(d__km, 10000, 10000, params->f__mhz, params->T_pol, params->p, &result);
-            fprintf_s(fp, ",%.3f", result.A__db);
+    int header[4] = { shard, shards, params->T_pol, DATASET_TASKS };
+    bool ok = fwrite(SHARD_MAGIC, 1, 8, fp) == 8 && fwrite(header, sizeof(int), 4, fp) == 4;
+    for (size_t i = 0; ok && i < tasks.size(); i++) {
+        int task = tasks[i];
+        ok = fwrite(&A__db[(size_t)task * CURVE_POINTS], sizeof(double), CURVE_POINTS, fp) == CURVE_POINTS;
+        if (ok && task % TABLE_COLUMNS == 0)
+            ok = fwrite(&A_fs__db[(size_t)(task / TABLE_COLUMNS) * CURVE_POINTS], sizeof(double), CURVE_POINTS,
+                fp) == CURVE_POINTS;
+    }
 
-            dllP528(d__km, 1.5, 20000, params->f__mhz, params->T_pol, params->p, &result);
-            fprintf_s(fp, ",%.3f", result.A__db);
+    if (fclose(fp) != 0 || !ok) {
+        printf_s("Error writing shard file.  Exiting.\n");
+        return DRVRERR__SHARD_FILE;
+    }
 
-            dllP528(d__km, 15, 20000, params->f__mhz, params->T_pol, params->p, &result);
-            fprintf_s(fp, ",%.3f", result.A__db);
+    return SUCCESS;
+}
 
-            dllP528(d__km, 30, 20000, params->f__mhz, params->T_pol, params->p, &result);
-            fprintf_s(fp, ",%.3f", result.A__db);
+/*=============================================================================
+ |
+ |  Description:  Merges the shard files of a data set into its data tables.
+ |                Every shard must hold the same polarization, and the one
+ |                given with -tpol, if any
+ |
+ |        Input:  params        - Structure with user input parameters
+ |
+ |      Returns:  SUCCESS or error code
+ |
+ *===========================================================================*/
+int CallP528_MERGE(DrvrParams* params) {
+    std::vector<double> A__db((size_t)DATASET_TASKS * CURVE_POINTS);
+    std::vector<double> A_fs__db((size_t)DATASET_FREQUENCIES * DATASET_PERCENTAGES * CURVE_POINTS);
 
-            dllP528(d__km, 60, 20000, params->f__mhz, params->T_pol, params->p, &result);
-            fprintf_s(fp, ",%.3f", result.A__db);
+    int T_pol = params->T_pol;
+    for (int shard = 0; shard < params->shards; shard++) {
+        char filename[512];
+        snprintf(filename, sizeof(filename), "%s/shard_%i_of_%i.bin", params->out_file, shard, params->shards);
 
-            dllP528(d__km, 1000, 20000, params->f__mhz, params->T_pol, params->p, &result);
-            fprintf_s(fp, ",%.3f", result.A__db);
+        FILE* fp;
+        int err = fopen_s(&fp, filename, "rb");
+        if (err != 0) {
+            printf_s("Error opening shard file %s.  Exiting.\n", filename);
+            return DRVRERR__SHARD_FILE;
+        }
 
-            dllP528(d__km, 10000, 20000, params->f__mhz, params->T_pol, params->p, &result);
-            fprintf_s(fp, ",%.3f", result.A__db);
+        char magic[8];
+        int header[4];
+        if (fread(magic, 1, 8, fp) != 8 || memcmp(magic, SHARD_MAGIC, 8) != 0 ||
+            fread(header, sizeof(int), 4, fp) != 4 || header[0] != shard || header[1] != params->shards ||
+            header[3] != DATASET_TASKS || (T_pol != NOT_SET && header[2] != T_pol)) {
+            printf_s("Shard file %s does not belong to this data set.  Exiting.\n", filename);
+            fclose(fp);
+            return DRVRERR__SHARD_MISMATCH;
+        }
+        T_pol = header[2];
+
+        bool ok = true;
+        for (int task = shard; ok && task < DATASET_TASKS; task += params->shards) {
+            ok = fread(&A__db[(size_t)task * CURVE_POINTS], sizeof(double), CURVE_POINTS, fp) == CURVE_POINTS;
+            if (ok && task % TABLE_COLUMNS == 0)
+                ok = fread(&A_fs__db[(size_t)(task / TABLE_COLUMNS) * CURVE_POINTS], sizeof(double), CURVE_POINTS,
+                    fp) == CURVE_POINTS;
+        }
+        ok = ok && fgetc(fp) == EOF;
+        fclose(fp);
 
-            dllP528(d__km, 20000, 20000, params->f__mhz, params->T_pol, params->p, &result);
-            fprintf_s(fp, ",%.3f\n", result.A__db);
+        if (!ok) {
+            printf_s("Shard file %s is incomplete.  Exiting.\n", filename);
+            return DRVRERR__SHARD_FILE;
+        }
+    }
+
+    return WriteDatasetTables(params->out_file, params->gzip, T_pol, A__db.data(), A_fs__db.data());
+}
+
+/*=============================================================================
+ |
+ |  Description:  Worker thread of DATASET mode that builds the path
+ |                contexts.  Claims frequencies until none are left
+ |
+ |        Input:  init_func     - P528_InitPathContexts() of the DLL
+ |                T_pol         - Polarization
+ |                next          - First frequency not yet claimed
+ |
+ |      Outputs:  contexts      - Path context of each column, by frequency
+ |                rtn           - Return code of each frequency
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void InitDatasetContexts(initpathcontextsfunc init_func, int T_pol, std::atomic<int>* next, PathContext* contexts,
+    int* rtn) {
+    for (int i_f = next->fetch_add(1); i_f < DATASET_FREQUENCIES; i_f = next->fetch_add(1))
+        rtn[i_f] = init_func(TABLE_H_1__METER, TABLE_H_2__METER, TABLE_COLUMNS, DATASET_F__MHZ[i_f], T_pol,
+            &contexts[i_f * TABLE_COLUMNS]);
+}
+
+/*=============================================================================
+ |
+ |  Description:  Worker thread of DATASET mode that evaluates the tasks.
+ |                Task (i_f * DATASET_PERCENTAGES + i_p) * TABLE_COLUMNS +
+ |                column is one column of one data table
+ |
+ |        Input:  context_func  - P528_Context() of the DLL
+ |                contexts      - Path context of each column, by frequency
+ |                tasks         - Tasks to evaluate
+ |                n_tasks       - Number of tasks
+ |                next          - First task not yet claimed
+ |
+ |      Outputs:  A__db         - Basic transmission loss, by task
+ |                A_fs__db      - Free space loss, by data table
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void EvaluateDatasetTasks(contextfunc context_func, const PathContext* contexts, const int* tasks, int n_tasks,
+    std::atomic<int>* next, double* A__db, double* A_fs__db) {
+    Result result;
+
+    for (int i = next->fetch_add(1); i < n_tasks; i = next->fetch_add(1)) {
+        int task = tasks[i];
+        int table = task / TABLE_COLUMNS;
+        int column = task % TABLE_COLUMNS;
+        int i_f = table / DATASET_PERCENTAGES;
+        double p = DATASET_P[table % DATASET_PERCENTAGES];
+
+        for (int d__km = 0; d__km < CURVE_POINTS; d__km++) {
+            context_func(&contexts[i_f * TABLE_COLUMNS + column], d__km, p, &result);
+            A__db[(size_t)task * CURVE_POINTS + d__km] = result.A__db;
+            if (column == 0)
+                A_fs__db[(size_t)table * CURVE_POINTS + d__km] = result.A_fs__db;
+        }
+    }
+}
+
+/*=============================================================================
+ |
+ |  Description:  Writes every data table of the data set, one file per
+ |                frequency and time percentage.  The file names carry the
+ |                polarization, so data sets of both polarizations can share
+ |                a directory
+ |
+ |        Input:  dir           - Output directory
+ |                gzip          - Compress the tables, as .csv.gz files
+ |                T_pol         - Polarization
+ |                A__db         - Basic transmission loss, by task
+ |                A_fs__db      - Free space loss, by data table
+ |
+ |      Returns:  SUCCESS or error code
+ |
+ *===========================================================================*/
+int WriteDatasetTables(const char* dir, bool gzip, int T_pol, const double* A__db, const double* A_fs__db) {
+    for (int i_f = 0; i_f < DATASET_FREQUENCIES; i_f++) {
+        for (int i_p = 0; i_p < DATASET_PERCENTAGES; i_p++) {
+            int table = i_f * DATASET_PERCENTAGES + i_p;
+
+            char filename[512];
+            snprintf(filename, sizeof(filename), "%s/%gMHz_p%g_tpol%i.csv%s", dir, DATASET_F__MHZ[i_f],
+                DATASET_P[i_p], T_pol, gzip ? ".gz" : "");
+
+            OutputWriter out;
+            int err = out.Open(filename, gzip);
+            if (err != 0) {
+                printf_s("Error opening output file %s.  Exiting.\n", filename);
+                return err;
+            }
+
+            WriteTable(&out, DATASET_F__MHZ[i_f], DATASET_P[i_p], &A_fs__db[(size_t)table * CURVE_POINTS],
+                &A__db[(size_t)table * TABLE_COLUMNS * CURVE_POINTS]);
+            if (!out.Close()) {
+                printf_s("Error writing output file %s.  Exiting.\n", filename);
+                return DRVRERR__OUTPUT_WRITE;
+            }
         }
     }
 
     return SUCCESS;
 }
 
+/*=============================================================================
+ |
+ |  Description:  Builds a loss tensor over the frequencies, terminal
+ |                heights, distances and time percentages of the data files
+ |                distributed from the Study Group 3 website, and writes it
+ |                to a binary data pack that workers can map read-only
+ |
+ |        Input:  params        - Structure with user input parameters
+ |
+ |      Returns:  P.528 DLL return code
+ |
+ *===========================================================================*/
+int CallP528_PACK(DrvrParams* params) {
+    losstensorbuildfunc dllLossTensor_Build = GET_FUNCTION(losstensorbuildfunc, LossTensor_Build);
+    losstensorwritepackfunc dllLossTensor_WritePack = GET_FUNCTION(losstensorwritepackfunc, LossTensor_WritePack);
+    losstensorfreefunc dllLossTensor_Free = GET_FUNCTION(losstensorfreefunc, LossTensor_Free);
+    if (dllLossTensor_Build == nullptr || dllLossTensor_WritePack == nullptr || dllLossTensor_Free == nullptr)
+        return DRVRERR__GETPACK_FUNC_LOADING;
+
+    double h_1__meter[] = { 1.5, 15, 30, 60, 1000, 10000, 20000 };
+    double h_2__meter[] = { 1000, 10000, 20000 };
+
+    double d__km[CURVE_POINTS];
+    for (int i = 0; i < CURVE_POINTS; i++)
+        d__km[i] = i;
+
+    LossTensor tensor;
+    int rtn = dllLossTensor_Build(d__km, CURVE_POINTS, h_1__meter, 7, h_2__meter, 3, DATASET_F__MHZ,
+        DATASET_FREQUENCIES, DATASET_P, DATASET_PERCENTAGES, params->T_pol, &tensor);
+    if (rtn != SUCCESS) {
+        printf_s("P.528 returned error %i building the loss tensor.  Exiting.\n", rtn);
+        return rtn;
+    }
+
+    rtn = dllLossTensor_WritePack(&tensor, params->out_file);
+    if (rtn != SUCCESS)
+        printf_s("Error writing data pack.  Exiting.\n");
+
+    dllLossTensor_Free(&tensor);
+
+    return rtn;
+}
+
 /*=============================================================================
  |
  |  Description:  Generates data points for a P.528 loss-vs-distance curve
@@ -187,70 +592,119 @@ int CallP528_CURVE(DrvrParams* params) {
     Result result;
     int rtn;
 
+    double d__kms[CURVE_POINTS];
     double A__dbs[CURVE_POINTS];
     double A_fs__dbs[CURVE_POINTS];
     int warnings[CURVE_POINTS];
+    int points = CURVE_POINTS;
+    bool on_grid = true;
 
-    // Gather data points
-    for (int d__km = 0; d__km < CURVE_POINTS; d__km++) {
-        rtn = dllP528(d__km, params->h_1__meter, params->h_2__meter, params->f__mhz, params->T_pol, params->p, &result);
+    if (params->tolerance__db == NOT_SET) {
+        // Gather data points
+        for (int d__km = 0; d__km < CURVE_POINTS; d__km++) {
+            rtn = dllP528(d__km, params->h_1__meter, params->h_2__meter, params->f__mhz, params->T_pol, params->p, &result);
 
-        A__dbs[d__km] = result.A__db;
-        A_fs__dbs[d__km] = result.A_fs__db;
-        warnings[d__km] = result.warnings;
+            d__kms[d__km] = d__km;
+            A__dbs[d__km] = result.A__db;
+            A_fs__dbs[d__km] = result.A_fs__db;
+            warnings[d__km] = result.warnings;
 
-        if (rtn != SUCCESS && rtn != SUCCESS_WITH_WARNINGS)
-            break;
+            if (rtn != SUCCESS && rtn != SUCCESS_WITH_WARNINGS)
+                break;
+        }
+    }
+    else {
+        adaptivecurvefunc dllP528_AdaptiveCurve = GET_FUNCTION(adaptivecurvefunc, P528_AdaptiveCurve);
+        resamplecurvefunc dllP528_ResampleCurve = GET_FUNCTION(resamplecurvefunc, P528_ResampleCurve);
+        if (dllP528_AdaptiveCurve == nullptr || dllP528_ResampleCurve == nullptr)
+            return DRVRERR__GETCURVE_FUNC_LOADING;
+
+        // Gather data points where the curve needs them, in no more calls than the 1 km grid
+        Result results[CURVE_POINTS];
+        double d_samples__km[CURVE_POINTS];
+        rtn = dllP528_AdaptiveCurve(params->h_1__meter, params->h_2__meter, params->f__mhz, params->T_pol, params->p,
+            CURVE_POINTS - 1, params->tolerance__db, CURVE_POINTS, d_samples__km, results, &points);
+
+        // a curve that ran out of samples before reaching tolerance is still written
+        if ((rtn == SUCCESS || rtn == ERROR_CURVE__TOLERANCE) && params->resample) {
+            for (int d__km = 0; d__km < CURVE_POINTS; d__km++)
+                d__kms[d__km] = d__km;
+
+            Result resampled[CURVE_POINTS];
+            dllP528_ResampleCurve(d_samples__km, results, points, d__kms, CURVE_POINTS, resampled);
+            for (int i = 0; i < CURVE_POINTS; i++) {
+                A__dbs[i] = resampled[i].A__db;
+                A_fs__dbs[i] = resampled[i].A_fs__db;
+                warnings[i] = resampled[i].warnings;
+            }
+            points = CURVE_POINTS;
+        }
+        else {
+            for (int i = 0; i < points; i++) {
+                d__kms[i] = d_samples__km[i];
+                A__dbs[i] = results[i].A__db;
+                A_fs__dbs[i] = results[i].A_fs__db;
+                warnings[i] = results[i].warnings;
+            }
+            on_grid = false;
+        }
     }
 
     // Print results to file
-    FILE* fp;
-    int err = fopen_s(&fp, params->out_file, "w");
+    OutputWriter out;
+    int err = out.Open(params->out_file, params->gzip);
     if (err != 0) {
         printf("Error opening output file.  Exiting.\n");
         return err;
     }
     else {
-        fprintf_s(fp, "p528_x86.dll Version,%i.%i\n", dllVerMajor, dllVerMinor);
-        fprintf_s(fp, "P528Drvr_x86.exe Version,%i.%i\n", drvrVerMajor, drvrVerMinor);
-        fwprintf_s(fp, L"Date Generated,%s", buf);
-        fprintf_s(fp, "\n");
-        fprintf_s(fp, "Inputs\n");
-        fprintf_s(fp, "h_1__meter,%f\n", params->h_1__meter);
-        fprintf_s(fp, "h_2__meter,%f\n", params->h_2__meter);
-        fprintf_s(fp, "f__mhz,%f\n", params->f__mhz);
-        fprintf_s(fp, "p,%f\n", params->p);
-        fprintf_s(fp, "T_pol,%i\n", params->T_pol);
-        fprintf_s(fp, "\n");
+        WriteFileHeader(&out, params);
 
-        if (rtn != SUCCESS && rtn != SUCCESS_WITH_WARNINGS) {
-            fprintf_s(fp, "P.528 returned error,%i\n", rtn);
+        if (rtn != SUCCESS && rtn != SUCCESS_WITH_WARNINGS && rtn != ERROR_CURVE__TOLERANCE) {
+            out.Format("P.528 returned error,%i\n", rtn);
         }
         else {
-            fprintf_s(fp, "Results\n");
-
-            fprintf_s(fp, "Distance (km)");
-            for (int d__km = 0; d__km < CURVE_POINTS; d__km++)
-                fprintf_s(fp, ",%i", d__km);
-            fprintf_s(fp, "\n");
+            if (rtn == ERROR_CURVE__TOLERANCE)
+                out.Format("P.528 returned error,%i,Samples ran out before the curve was within tolerance\n", rtn);
+
+            out.Text("Results\n");
+
+            out.Text("Distance (km)");
+            for (int i = 0; i < points; i++) {
+                out.Char(',');
+                if (on_grid)
+                    out.Int((int)d__kms[i]);
+                else
+                    out.Fixed(d__kms[i]);
+            }
+            out.Char('\n');
 
-            fprintf_s(fp, "Free Space Loss (dB),%.3f", A_fs__dbs[0]);
-            for (int i = 1; i < CURVE_POINTS; i++)
-                fprintf_s(fp, ",%.3f", A_fs__dbs[i]);
-            fprintf_s(fp, "\n");
+            out.Text("Free Space Loss (dB)");
+            for (int i = 0; i < points; i++) {
+                out.Char(',');
+                out.Fixed(A_fs__dbs[i]);
+            }
+            out.Char('\n');
 
-            fprintf_s(fp, "Basic Transmission Loss (dB),%.3f", A__dbs[0]);
-            for (int i = 1; i < CURVE_POINTS; i++)
-                fprintf_s(fp, ",%.3f", A__dbs[i]);
-            fprintf_s(fp, "\n");
+            out.Text("Basic Transmission Loss (dB)");
+            for (int i = 0; i < points; i++) {
+                out.Char(',');
+                out.Fixed(A__dbs[i]);
+            }
+            out.Char('\n');
 
-            fprintf_s(fp, "Warnings,0x%x", warnings[0]);
-            for (int i = 1; i < CURVE_POINTS; i++)
-                fprintf_s(fp, ",0x%x", warnings[i]);
-            fprintf_s(fp, "\n");
+            out.Text("Warnings");
+            for (int i = 0; i < points; i++) {
+                out.Char(',');
+                out.Hex(warnings[i]);
+            }
+            out.Char('\n');
         }
 
-        fclose(fp);
+        if (!out.Close()) {
+            printf_s("Error writing output file.  Exiting.\n");
+            return DRVRERR__OUTPUT_WRITE;
+        }
     }
 
     return rtn;
@@ -284,44 +738,519 @@ int CallP528_POINT(DrvrParams* params) {
     }
     else {
         // Print results to file
-        FILE* fp;
-        int err = fopen_s(&fp, params->out_file, "w");
+        OutputWriter out;
+        int err = out.Open(params->out_file, params->gzip);
         if (err != 0) {
             printf_s("Error opening output file.  Exiting.\n");
             return err;
         }
         else {
-            fprintf_s(fp, "p528_x86.dll Version,%i.%i\n", dllVerMajor, dllVerMinor);
-            fprintf_s(fp, "P528Drvr_x86.exe Version,%i.%i\n", drvrVerMajor, drvrVerMinor);
-            fwprintf_s(fp, L"Date Generated,%s", buf);
-            fprintf_s(fp, "\n");
-            fprintf_s(fp, "Inputs\n");
-            fprintf_s(fp, "h_1__meter,%f\n", params->h_1__meter);
-            fprintf_s(fp, "h_2__meter,%f\n", params->h_2__meter);
-            fprintf_s(fp, "f__mhz,%f\n", params->f__mhz);
-            fprintf_s(fp, "d__km,%f\n", params->d__km);
-            fprintf_s(fp, "p,%f\n", params->p);
-            fprintf_s(fp, "T_pol,%i\n", params->T_pol);
-            fprintf_s(fp, "\n");
+            WriteFileHeader(&out, params);
 
             if (rtn != SUCCESS && rtn != SUCCESS_WITH_WARNINGS) {
-                fprintf_s(fp, "P.528 returned error,%i\n", rtn);
+                out.Format("P.528 returned error,%i\n", rtn);
             }
             else {
-                fprintf_s(fp, "Results\n");
-                fprintf_s(fp, "Free Space Loss (dB),%.3f\n", result.A_fs__db);
-                fprintf_s(fp, "Basic Transmission Loss (dB),%.3f\n", result.A__db);
-                fprintf_s(fp, "DLL Return Code,%i\n", rtn);
-                fprintf_s(fp, "Warning Flags,0x%x\n", result.warnings);
+                out.Text("Results\n");
+                out.Text("Free Space Loss (dB),");
+                out.Fixed(result.A_fs__db);
+                out.Text("\nBasic Transmission Loss (dB),");
+                out.Fixed(result.A__db);
+                out.Text("\nDLL Return Code,");
+                out.Int(rtn);
+                out.Text("\nWarning Flags,");
+                out.Hex(result.warnings);
+                out.Char('\n');
             }
 
-            fclose(fp);
+            if (!out.Close()) {
+                printf_s("Error writing output file.  Exiting.\n");
+                return DRVRERR__OUTPUT_WRITE;
+            }
+        }
+    }
+
+    return rtn;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Executes P.528 for every query row of a CSV stream.  The
+ |                rows are read on this thread in chunks, evaluated by a pool
+ |                of worker threads, and written in input order by a writer
+ |                thread.  A fixed pool of chunks circulates between the
+ |                stages, so reading, computing and writing overlap, and
+ |                memory does not grow with the size of the input
+ |
+ |        Input:  params        - Structure with user input parameters
+ |
+ |      Returns:  SUCCESS or driver error code.  P.528 return codes are
+ |                written per row
+ |
+ *===========================================================================*/
+int CallP528_BATCH(DrvrParams* params) {
+    int threads = params->threads;
+    if (threads == NOT_SET)
+        threads = (std::thread::hardware_concurrency() > 0) ? (int)std::thread::hardware_concurrency() : 1;
+
+    if (params->binary)
+        return CallP528_BATCH_BINARY(params, threads);
+
+    FILE* fp_in = stdin;
+    if (strlen(params->in_file) > 0) {
+        int err = fopen_s(&fp_in, params->in_file, "r");
+        if (err != 0) {
+            printf_s("Error opening input file.  Exiting.\n");
+            return err;
+        }
+    }
+
+    OutputWriter out;
+    int err = out.Open(params->out_file, params->gzip);
+    if (err != 0) {
+        printf_s("Error opening output file.  Exiting.\n");
+        if (fp_in != stdin)
+            fclose(fp_in);
+        return err;
+    }
+
+    std::vector<BatchChunk> pool(threads * BATCH_CHUNKS_PER_THREAD + 2);
+    ChunkQueue free, work, done;
+    for (size_t i = 0; i < pool.size(); i++)
+        free.Push(&pool[i]);
+
+    out.Text("Return Code,Free Space Loss (dB),Basic Transmission Loss (dB),Warning Flags\n");
+
+    std::thread writer(WriteBatchChunks, &out, &done, &free);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; i++)
+        workers.push_back(std::thread(EvaluateBatchChunks, &work, &done));
+
+    // Read until the end of the input, waiting whenever every chunk is in flight
+    bool more = true;
+    for (long long index = 0; more; index++) {
+        BatchChunk* chunk = free.Pop();
+        more = ReadBatchChunk(fp_in, index == 0, chunk);
+        chunk->index = index;
+
+        if (chunk->count > 0)
+            work.Push(chunk);
+        else
+            free.Push(chunk);
+    }
+
+    work.Close();
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+    done.Close();
+    writer.join();
+
+    int rtn = SUCCESS;
+    if (!out.Close())
+        rtn = DRVRERR__BATCH_WRITE;
+
+    if (fp_in != stdin)
+        fclose(fp_in);
+
+    return rtn;
+}
+
+/*=============================================================================
+ |
+ |  Description:  BATCH mode over columnar files.  The query file is mapped
+ |                rather than parsed, and each worker claims the next block
+ |                of rows, evaluates it and writes its result columns in
+ |                place, so no row is formatted or reordered
+ |
+ |        Input:  params        - Structure with user input parameters
+ |                threads       - Number of worker threads
+ |
+ |      Returns:  SUCCESS or error code.  P.528 return codes are written per
+ |                row
+ |
+ *===========================================================================*/
+int CallP528_BATCH_BINARY(DrvrParams* params, int threads) {
+    querycolumnsopenfunc dllQueryColumns_Open = GET_FUNCTION(querycolumnsopenfunc, QueryColumns_Open);
+    querycolumnsfreefunc dllQueryColumns_Free = GET_FUNCTION(querycolumnsfreefunc, QueryColumns_Free);
+    resultcolumnscreatefunc dllResultColumns_Create = GET_FUNCTION(resultcolumnscreatefunc, ResultColumns_Create);
+    resultcolumnswriterowsfunc dllResultColumns_WriteRows = GET_FUNCTION(resultcolumnswriterowsfunc, ResultColumns_WriteRows);
+    resultcolumnsclosefunc dllResultColumns_Close = GET_FUNCTION(resultcolumnsclosefunc, ResultColumns_Close);
+    if (dllQueryColumns_Open == nullptr || dllQueryColumns_Free == nullptr || dllResultColumns_Create == nullptr ||
+        dllResultColumns_WriteRows == nullptr || dllResultColumns_Close == nullptr)
+        return DRVRERR__GETCOLUMNS_FUNC_LOADING;
+
+    QueryColumns queries;
+    int rtn = dllQueryColumns_Open(params->in_file, &queries);
+    if (rtn != SUCCESS) {
+        printf_s("Error opening input file.  Exiting.\n");
+        return rtn;
+    }
+
+    ResultColumnsWriter writer;
+    rtn = dllResultColumns_Create(params->out_file, queries.n, &writer);
+    if (rtn != SUCCESS) {
+        printf_s("Error opening output file.  Exiting.\n");
+        dllQueryColumns_Free(&queries);
+        return rtn;
+    }
+
+    std::atomic<long long> next(0);
+    std::mutex write_lock;
+    std::vector<int> rtns(threads, SUCCESS);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; i++)
+        workers.push_back(std::thread(EvaluateBatchRows, &queries, &next, &writer, dllResultColumns_WriteRows,
+            &write_lock, &rtns[i]));
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+
+    for (int i = 0; i < threads; i++)
+        if (rtns[i] != SUCCESS)
+            rtn = rtns[i];
+
+    if (dllResultColumns_Close(&writer) != SUCCESS || rtn != SUCCESS) {
+        printf_s("Error writing output file.  Exiting.\n");
+        rtn = DRVRERR__BATCH_WRITE;
+    }
+
+    dllQueryColumns_Free(&queries);
+
+    return rtn;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Worker thread of binary BATCH mode.  Claims blocks of rows
+ |                until none are left
+ |
+ |        Input:  queries       - Query columns
+ |                next          - First row not yet claimed
+ |                writer        - Open result file
+ |                write_rows    - ResultColumns_WriteRows() of the DLL
+ |                write_lock    - Serializes writes to the result file
+ |
+ |      Outputs:  rtn           - SUCCESS, or the error of a failed write
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void EvaluateBatchRows(const QueryColumns* queries, std::atomic<long long>* next, ResultColumnsWriter* writer,
+    resultcolumnswriterowsfunc write_rows, std::mutex* write_lock, int* rtn) {
+    std::vector<int> rtns(BATCH_CHUNK_ROWS);
+    std::vector<Result> results(BATCH_CHUNK_ROWS);
+
+    while (*rtn == SUCCESS) {
+        long long first = next->fetch_add(BATCH_CHUNK_ROWS);
+        if (first >= queries->n)
+            break;
+
+        int count = (int)((queries->n - first < BATCH_CHUNK_ROWS) ? queries->n - first : BATCH_CHUNK_ROWS);
+        for (int i = 0; i < count; i++) {
+            long long row = first + i;
+            rtns[i] = dllP528(queries->d__km[row], queries->h_1__meter[row], queries->h_2__meter[row],
+                queries->f__mhz[row], queries->T_pol[row], queries->p[row], &results[i]);
+        }
+
+        std::lock_guard<std::mutex> lock(*write_lock);
+        *rtn = write_rows(writer, first, count, rtns.data(), results.data());
+    }
+}
+
+/*=============================================================================
+ |
+ |  Description:  Replays flight tracks against a fixed ground terminal.
+ |                Each row is one sample of a track, in time order.  Each
+ |                track keeps a trajectory between its samples, so the
+ |                terminal geometry and path contexts are reused and the
+ |                line-of-sight search starts from the previous sample.
+ |                Results are written in the BATCH format, one row per
+ |                sample, in input order
+ |
+ |        Input:  params        - Structure with user input parameters
+ |
+ |      Returns:  SUCCESS or driver error code
+ |
+ *===========================================================================*/
+int CallP528_TRACK(DrvrParams* params) {
+    inittrajectoryfunc dllP528_InitTrajectory = GET_FUNCTION(inittrajectoryfunc, P528_InitTrajectory);
+    trajectoryfunc dllP528_Trajectory = GET_FUNCTION(trajectoryfunc, P528_Trajectory);
+    freetrajectoryfunc dllP528_FreeTrajectory = GET_FUNCTION(freetrajectoryfunc, P528_FreeTrajectory);
+    if (dllP528_InitTrajectory == nullptr || dllP528_Trajectory == nullptr || dllP528_FreeTrajectory == nullptr)
+        return DRVRERR__GETP528_FUNC_LOADING;
+
+    FILE* fp_in = stdin;
+    if (strlen(params->in_file) > 0) {
+        int err = fopen_s(&fp_in, params->in_file, "r");
+        if (err != 0) {
+            printf_s("Error opening input file.  Exiting.\n");
+            return err;
+        }
+    }
+
+    OutputWriter out;
+    int err = out.Open(params->out_file, params->gzip);
+    if (err != 0) {
+        printf_s("Error opening output file.  Exiting.\n");
+        if (fp_in != stdin)
+            fclose(fp_in);
+        return err;
+    }
+
+    out.Text("Return Code,Free Space Loss (dB),Basic Transmission Loss (dB),Warning Flags\n");
+
+    // Trajectory of each track, and the error if it could not be started
+    std::map<int, Trajectory> trajectories;
+    std::map<int, int> init_rtn;
+
+    char line[BATCH_LINE_SIZE];
+    bool first_line = true;
+    while (fgets(line, BATCH_LINE_SIZE, fp_in) != NULL) {
+        // Drop the rest of a row that is too long to be valid
+        size_t length = strlen(line);
+        bool truncated = (length == BATCH_LINE_SIZE - 1 && line[length - 1] != '\n');
+        if (truncated) {
+            int c;
+            while ((c = fgetc(fp_in)) != '\n' && c != EOF);
+        }
+
+        bool header_allowed = first_line;
+        first_line = false;
+
+        const char* row = line;
+        while (*row == ' ' || *row == '\t')
+            row++;
+        if (*row == '\0' || *row == '\n' || *row == '\r' || *row == '#')
+            continue;
+
+        int track;
+        double d__km, h_2__meter;
+        Result result;
+        if (truncated || sscanf_s(row, "%i ,%lf ,%lf", &track, &d__km, &h_2__meter) != 3 ||
+            !isfinite(d__km) || !isfinite(h_2__meter)) {
+            // The first line of the input may be a header
+            if (!(header_allowed && isalpha((unsigned char)*row)))
+                WriteBatchRow(&out, DRVRERR__PARSE_BATCH_ROW, &result);
+            continue;
+        }
+
+        std::map<int, Trajectory>::iterator it = trajectories.find(track);
+        if (it == trajectories.end()) {
+            std::map<int, int>::iterator failed = init_rtn.find(track);
+            if (failed != init_rtn.end()) {
+                WriteBatchRow(&out, failed->second, &result);
+                continue;
+            }
+
+            Trajectory trajectory;
+            int rtn = dllP528_InitTrajectory(params->h_1__meter, params->f__mhz, params->T_pol,
+                params->h_quantum__meter, &trajectory);
+            if (rtn != SUCCESS) {
+                init_rtn[track] = rtn;
+                WriteBatchRow(&out, rtn, &result);
+                continue;
+            }
+
+            it = trajectories.insert(std::make_pair(track, trajectory)).first;
         }
+
+        int rtn = dllP528_Trajectory(&it->second, d__km, h_2__meter, params->p, &result);
+        WriteBatchRow(&out, rtn, &result);
     }
 
+    for (std::map<int, Trajectory>::iterator it = trajectories.begin(); it != trajectories.end(); it++)
+        dllP528_FreeTrajectory(&it->second);
+
+    int rtn = SUCCESS;
+    if (!out.Close())
+        rtn = DRVRERR__BATCH_WRITE;
+
+    if (fp_in != stdin)
+        fclose(fp_in);
+
     return rtn;
 }
 
+/*=============================================================================
+ |
+ |  Description:  Parses the next chunk of query rows from a CSV stream.
+ |                Rows that cannot be parsed, or that hold non-finite
+ |                values, are kept, flagged with DRVRERR__PARSE_BATCH_ROW,
+ |                so the output stays aligned with the input.  Only the
+ |                first line of the stream is skipped if it does not parse
+ |                and starts with a letter, as a header
+ |
+ |        Input:  fp            - Input stream
+ |                first         - True if the chunk starts the stream
+ |
+ |      Outputs:  chunk         - Query rows, and their count
+ |
+ |      Returns:  False once the end of the stream is reached
+ |
+ *===========================================================================*/
+bool ReadBatchChunk(FILE* fp, bool first, BatchChunk* chunk) {
+    char line[BATCH_LINE_SIZE];
+    bool first_line = first;
+
+    chunk->count = 0;
+    while (chunk->count < BATCH_CHUNK_ROWS) {
+        if (fgets(line, BATCH_LINE_SIZE, fp) == NULL)
+            return false;
+
+        // Drop the rest of a row that is too long to be valid
+        size_t length = strlen(line);
+        bool truncated = (length == BATCH_LINE_SIZE - 1 && line[length - 1] != '\n');
+        if (truncated) {
+            int c;
+            while ((c = fgetc(fp)) != '\n' && c != EOF);
+        }
+
+        bool header_allowed = first_line;
+        first_line = false;
+
+        const char* row = line;
+        while (*row == ' ' || *row == '\t')
+            row++;
+        if (*row == '\0' || *row == '\n' || *row == '\r' || *row == '#')
+            continue;
+
+        BatchQuery* query = &chunk->queries[chunk->count];
+        query->rtn = SUCCESS;
+        if (truncated || sscanf_s(row, "%lf ,%lf ,%lf ,%lf ,%i ,%lf", &query->d__km, &query->h_1__meter,
+            &query->h_2__meter, &query->f__mhz, &query->T_pol, &query->p) != 6 ||
+            !isfinite(query->d__km) || !isfinite(query->h_1__meter) || !isfinite(query->h_2__meter) ||
+            !isfinite(query->f__mhz) || !isfinite(query->p)) {
+            // The first line of the stream may be a header
+            if (header_allowed && isalpha((unsigned char)*row))
+                continue;
+            query->rtn = DRVRERR__PARSE_BATCH_ROW;
+        }
+
+        chunk->count++;
+    }
+
+    return true;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Worker thread of BATCH mode.  Evaluates chunks until the
+ |                work queue is closed
+ |
+ |        Input:  work          - Chunks of parsed query rows
+ |
+ |      Outputs:  done          - Chunks with results
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void EvaluateBatchChunks(ChunkQueue* work, ChunkQueue* done) {
+    BatchChunk* chunk;
+    while ((chunk = work->Pop()) != NULL) {
+        for (int i = 0; i < chunk->count; i++) {
+            BatchQuery* query = &chunk->queries[i];
+            if (query->rtn == SUCCESS)
+                query->rtn = dllP528(query->d__km, query->h_1__meter, query->h_2__meter, query->f__mhz,
+                    query->T_pol, query->p, &query->result);
+        }
+
+        done->Push(chunk);
+    }
+}
+
+/*=============================================================================
+ |
+ |  Description:  Writer thread of BATCH mode.  Chunks finish in any order;
+ |                each is held until the chunks before it are written, then
+ |                returned to the pool
+ |
+ |        Input:  out           - Output stream
+ |                done          - Chunks with results
+ |
+ |      Outputs:  free          - Chunks that can be reused
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void WriteBatchChunks(OutputWriter* out, ChunkQueue* done, ChunkQueue* free) {
+    std::vector<BatchChunk*> pending;
+    long long next = 0;
+
+    BatchChunk* chunk;
+    while ((chunk = done->Pop()) != NULL) {
+        pending.push_back(chunk);
+
+        for (size_t k = 0; k < pending.size();) {
+            if (pending[k]->index != next) {
+                k++;
+                continue;
+            }
+
+            for (int i = 0; i < pending[k]->count; i++)
+                WriteBatchRow(out, pending[k]->queries[i].rtn, &pending[k]->queries[i].result);
+
+            free->Push(pending[k]);
+            pending.erase(pending.begin() + k);
+            next++;
+            k = 0;
+        }
+    }
+}
+
+/*=============================================================================
+ |
+ |  Description:  Writes the result row of one BATCH query
+ |
+ |        Input:  out           - Output stream
+ |                rtn           - Return code of the query
+ |                result        - Result of the query
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void WriteBatchRow(OutputWriter* out, int rtn, const Result* result) {
+    out->Int(rtn);
+    if (rtn == SUCCESS || rtn == SUCCESS_WITH_WARNINGS) {
+        out->Char(',');
+        out->Fixed(result->A_fs__db);
+        out->Char(',');
+        out->Fixed(result->A__db);
+        out->Char(',');
+        out->Hex(result->warnings);
+        out->Char('\n');
+    }
+    else
+        out->Text(",,,\n");
+}
+
+/*=============================================================================
+ |
+ |  Description:  Writes the version and input lines that start the output
+ |                files of POINT and CURVE modes
+ |
+ |        Input:  out           - Output file
+ |                params        - Structure with user input parameters
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void WriteFileHeader(OutputWriter* out, const DrvrParams* params) {
+    out->Format("p528_x86.dll Version,%i.%i\n", dllVerMajor, dllVerMinor);
+    out->Format("P528Drvr_x86.exe Version,%i.%i\n", drvrVerMajor, drvrVerMinor);
+    out->Format("Date Generated,%s", buf);
+    out->Text("\n");
+    out->Text("Inputs\n");
+    out->Format("h_1__meter,%f\n", params->h_1__meter);
+    out->Format("h_2__meter,%f\n", params->h_2__meter);
+    out->Format("f__mhz,%f\n", params->f__mhz);
+    if (params->mode == MODE_POINT)
+        out->Format("d__km,%f\n", params->d__km);
+    out->Format("p,%f\n", params->p);
+    out->Format("T_pol,%i\n", params->T_pol);
+    if (params->mode == MODE_CURVE && params->tolerance__db != NOT_SET)
+        out->Format("Tolerance (dB),%f\n", params->tolerance__db);
+    out->Text("\n");
+}
+
 /*=============================================================================
  |
  |  Description:  Loads the P.528 DLL
@@ -332,10 +1261,12 @@ int CallP528_POINT(DrvrParams* params) {
  |
  *===========================================================================*/
 int LoadDLL() {
+#ifdef _WIN32
     hLib = LoadLibrary(TEXT("p528_x86.dll"));
 
     if (hLib == NULL)
         return DRVRERR__DLL_LOADING;
+#endif
 
     GetDLLVersionInfo();
     GetDrvrVersionInfo();
@@ -343,13 +1274,31 @@ int LoadDLL() {
         return DRVRERR__MAJOR_VERSION_MISMATCH;
 
     // Grab the functions in the DLL
-    dllP528 = (p528func)GetProcAddress((HMODULE)hLib, "P528");
+    dllP528 = GET_FUNCTION(p528func, P528);
     if (dllP528 == nullptr)
         return DRVRERR__GETP528_FUNC_LOADING;
 
     return SUCCESS;
 }
 
+#ifdef _WIN32
+/*=============================================================================
+ |
+ |  Description:  Looks up a function exported by the P.528 DLL.  Only
+ |                Windows loads the library at run time; elsewhere the
+ |                driver links to it, and GET_FUNCTION() takes the address
+ |                of the export directly
+ |
+ |        Input:  name          - Name of the function
+ |
+ |      Returns:  Address of the function, or NULL if not found
+ |
+ *===========================================================================*/
+void* GetFunction(const char* name) {
+    return (void*)GetProcAddress((HMODULE)hLib, name);
+}
+#endif
+
 /*=============================================================================
  |
  |  Description:  Get the version information of the P.528 DLL
@@ -360,6 +1309,9 @@ int LoadDLL() {
  |
  *===========================================================================*/
 void GetDLLVersionInfo() {
+#ifndef _WIN32
+    P528_GetVersion(&dllVerMajor, &dllVerMinor);
+#else
     DWORD  verHandle = NULL;
     UINT   size = 0;
     LPBYTE lpBuffer = NULL;
@@ -384,6 +1336,7 @@ void GetDLLVersionInfo() {
 
         delete[] verData;
     }
+#endif
 
     return;
 }
@@ -399,6 +1352,10 @@ void GetDLLVersionInfo() {
  *===========================================================================*/
 void GetDrvrVersionInfo()
 {
+#ifndef _WIN32
+    drvrVerMajor = DRVR_VERSION_MAJOR;
+    drvrVerMinor = DRVR_VERSION_MINOR;
+#else
     DWORD  verHandle = NULL;
     UINT   size = 0;
     LPBYTE lpBuffer = NULL;
@@ -429,6 +1386,7 @@ void GetDrvrVersionInfo()
 
         delete[] verData;
     }
+#endif
 
     return;
 }
@@ -497,6 +1455,48 @@ int ParseArguments(int argc, char** argv, DrvrParams* params)
                 return ParseErrorMsgHelper("-tpol [polarization]", DRVRERR__PARSE_TPOL_POLARIZATION);
             i++;
         }
+        else if (Match("-tol", argv[i])) {
+            if (sscanf_s(argv[i + 1], "%lf", &(params->tolerance__db)) != 1)
+                return ParseErrorMsgHelper("-tol [tolerance]", DRVRERR__PARSE_TOLERANCE);
+            i++;
+        }
+        else if (Match("-resample", argv[i])) {
+            params->resample = true;
+        }
+        else if (Match("-threads", argv[i])) {
+            if (sscanf_s(argv[i + 1], "%i", &(params->threads)) != 1 || params->threads < 1)
+                return ParseErrorMsgHelper("-threads [count]", DRVRERR__PARSE_THREADS);
+            i++;
+        }
+        else if (Match("-shards", argv[i])) {
+            if (sscanf_s(argv[i + 1], "%i", &(params->shards)) != 1 || params->shards < 1)
+                return ParseErrorMsgHelper("-shards [count]", DRVRERR__PARSE_SHARDS);
+            i++;
+        }
+        else if (Match("-shard", argv[i])) {
+            if (sscanf_s(argv[i + 1], "%i", &(params->shard)) != 1 || params->shard < 0)
+                return ParseErrorMsgHelper("-shard [index]", DRVRERR__PARSE_SHARD);
+            i++;
+        }
+        else if (Match("-hq", argv[i])) {
+            if (sscanf_s(argv[i + 1], "%lf", &(params->h_quantum__meter)) != 1 || params->h_quantum__meter < 0)
+                return ParseErrorMsgHelper("-hq [meters]", DRVRERR__PARSE_H_QUANTUM);
+            i++;
+        }
+        else if (Match("-socket", argv[i])) {
+            sprintf_s(params->socket_path, "%s", argv[i + 1]);
+            i++;
+        }
+        else if (Match("-binary", argv[i])) {
+            params->binary = true;
+        }
+        else if (Match("-gzip", argv[i])) {
+            params->gzip = true;
+        }
+        else if (Match("-i", argv[i])) {
+            sprintf_s(params->in_file, "%s", argv[i + 1]);
+            i++;
+        }
         else if (Match("-o", argv[i])) {
             sprintf_s(params->out_file, "%s", argv[i + 1]);
             i++;
@@ -511,6 +1511,20 @@ int ParseArguments(int argc, char** argv, DrvrParams* params)
                 params->mode = MODE_CURVE;
             else if (Match("table", argv[i + 1]))
                 params->mode = MODE_TABLE;
+            else if (Match("pack", argv[i + 1]))
+                params->mode = MODE_PACK;
+            else if (Match("batch", argv[i + 1]))
+                params->mode = MODE_BATCH;
+            else if (Match("dataset", argv[i + 1]))
+                params->mode = MODE_DATASET;
+            else if (Match("merge", argv[i + 1]))
+                params->mode = MODE_MERGE;
+            else if (Match("serve", argv[i + 1]))
+                params->mode = MODE_SERVE;
+            else if (Match("query", argv[i + 1]))
+                params->mode = MODE_QUERY;
+            else if (Match("track", argv[i + 1]))
+                params->mode = MODE_TRACK;
             else
                 return ParseErrorMsgHelper("-mode [mode]", DRVRERR__PARSE_MODE_VALUE);
 
@@ -546,11 +1560,60 @@ int ParseArguments(int argc, char** argv, DrvrParams* params)
  |
  *===========================================================================*/
 int ValidateInputs(DrvrParams* params) {
-    if (params->f__mhz == NOT_SET)
-        return Validate_RequiredErrMsgHelper("-f", DRVRERR__VALIDATION_F);
+#ifndef DRVR_ZLIB
+    if (params->gzip) {
+        printf_s("DrvrError %i: Option -gzip is not supported by this build of the driver\n",
+            DRVRERR__OUTPUT_UNSUPPORTED);
+        return DRVRERR__OUTPUT_UNSUPPORTED;
+    }
+#endif
+
+    // BATCH mode reads the inputs from each query row
+    if (params->mode == MODE_BATCH) {
+        if (params->binary && strlen(params->in_file) == 0)
+            return Validate_RequiredErrMsgHelper("-i", DRVRERR__VALIDATION_IN_FILE);
+
+        if (params->binary && strlen(params->out_file) == 0)
+            return Validate_RequiredErrMsgHelper("-o", DRVRERR__VALIDATION_OUT_FILE);
 
-    if (params->p == NOT_SET)
-        return Validate_RequiredErrMsgHelper("-p", DRVRERR__VALIDATION_P);
+        return SUCCESS;
+    }
+
+    // SERVE and QUERY modes read the inputs from each query
+    if (params->mode == MODE_SERVE || params->mode == MODE_QUERY) {
+        if (strlen(params->socket_path) == 0)
+            return Validate_RequiredErrMsgHelper("-socket", DRVRERR__VALIDATION_SOCKET);
+
+        return SUCCESS;
+    }
+
+    // MERGE mode reads the inputs from the shard files
+    if (params->mode == MODE_MERGE) {
+        if (params->shards == NOT_SET)
+            return Validate_RequiredErrMsgHelper("-shards", DRVRERR__VALIDATION_SHARD);
+
+        if (strlen(params->out_file) == 0)
+            return Validate_RequiredErrMsgHelper("-o", DRVRERR__VALIDATION_OUT_FILE);
+
+        return SUCCESS;
+    }
+
+    if (params->mode == MODE_DATASET) {
+        if ((params->shards == NOT_SET) != (params->shard == NOT_SET) ||
+            (params->shards != NOT_SET && params->shard >= params->shards)) {
+            printf_s("DrvrError %i: Options -shards and -shard must be given together, with -shard < -shards\n",
+                DRVRERR__VALIDATION_SHARD);
+            return DRVRERR__VALIDATION_SHARD;
+        }
+    }
+
+    if (params->mode != MODE_PACK && params->mode != MODE_DATASET) {
+        if (params->f__mhz == NOT_SET)
+            return Validate_RequiredErrMsgHelper("-f", DRVRERR__VALIDATION_F);
+
+        if (params->p == NOT_SET)
+            return Validate_RequiredErrMsgHelper("-p", DRVRERR__VALIDATION_P);
+    }
 
     if (params->T_pol == NOT_SET)
         return Validate_RequiredErrMsgHelper("-tpol", DRVRERR__VALIDATION_P);
@@ -563,6 +1626,12 @@ int ValidateInputs(DrvrParams* params) {
             return Validate_RequiredErrMsgHelper("-d", DRVRERR__VALIDATION_D);
     }
 
+    // TRACK mode reads the high terminal height from each sample row
+    if (params->mode == MODE_TRACK) {
+        if (params->h_1__meter == NOT_SET)
+            return Validate_RequiredErrMsgHelper("-h1", DRVRERR__VALIDATION_H1);
+    }
+
     if (params->mode == MODE_POINT || params->mode == MODE_CURVE) {
         if (params->h_1__meter == NOT_SET)
             return Validate_RequiredErrMsgHelper("-h1", DRVRERR__VALIDATION_H1);
@@ -571,7 +1640,8 @@ int ValidateInputs(DrvrParams* params) {
             return Validate_RequiredErrMsgHelper("-h2", DRVRERR__VALIDATION_H2);
     }
 
-    if (params->mode == MODE_CURVE || params->mode == MODE_TABLE) {
+    if (params->mode == MODE_CURVE || params->mode == MODE_TABLE || params->mode == MODE_PACK ||
+        params->mode == MODE_DATASET) {
         if (strlen(params->out_file) == 0)
             return  Validate_RequiredErrMsgHelper("-o", DRVRERR__VALIDATION_OUT_FILE);
     }
@@ -644,14 +1714,43 @@ void Help() {
     printf_s("\t-h2   :: Height of high terminal, in meters\n");
     printf_s("\t-f    :: Frequency, in MHz\n");
     printf_s("\t-p    :: Percentage\n");
-    printf_s("\t-tpol :: Polarization\n");
+    printf_s("\t-tpol :: Polarization.  MERGE checks it against the shard files, if given\n");
     printf_s("\t-d    :: Path distance, in km\n");
-    printf_s("\t-o    :: Output file name\n");
-    printf_s("\t-mode :: Mode of operation [POINT, CURVE, TABLE]\n");
+    printf_s("\t-o    :: Output file name.  BATCH and TRACK write to stdout if not given.  DATASET and MERGE\n");
+    printf_s("\t         write to this existing directory\n");
+    printf_s("\t-i    :: BATCH, QUERY and TRACK only.  Input file of query rows, or stdin if not given\n");
+    printf_s("\t-threads :: BATCH, TABLE and DATASET only.  Number of worker threads, default one per core\n");
+    printf_s("\t-shards :: DATASET and MERGE only.  Number of shards the data set is split into\n");
+    printf_s("\t-shard :: DATASET only.  Shard to generate, from 0 to shards - 1\n");
+    printf_s("\t-hq   :: TRACK only.  Round high terminal heights to a multiple of this, in meters\n");
+    printf_s("\t-socket :: SERVE and QUERY only.  Path of the Unix domain socket\n");
+    printf_s("\t-binary :: BATCH only.  Read and write columnar files instead of CSV\n");
+    printf_s("\t-gzip :: Compress CSV output with gzip.  DATASET and MERGE write .csv.gz tables\n");
+    printf_s("\t-tol  :: CURVE only.  Sample adaptively, to within this tolerance, in dB\n");
+    printf_s("\t-resample :: CURVE only.  Resample an adaptive curve onto the 1 km grid\n");
+    printf_s("\t-mode :: Mode of operation [POINT, CURVE, TABLE, PACK, BATCH, DATASET, MERGE, SERVE, QUERY, TRACK]\n");
     printf_s("\n");
     printf_s("Examples:\n");
     printf_s("\tP528Drvr_x86.exe -mode POINT -h1 10 -h2 20000 -f 3000 -p 50 -tpol 1 -d 600\n");
     printf_s("\tP528Drvr_x86.exe -mode CURVE -h1 15 -h2 15000 -f 450 -p 10 -tpol 0 -o curve.csv\n");
+    printf_s("\tP528Drvr_x86.exe -mode CURVE -h1 15 -h2 15000 -f 450 -p 10 -tpol 0 -tol 0.5 -resample -o curve.csv\n");
     printf_s("\tP528Drvr_x86.exe -mode TABLE -f 6500 -p 90 -tpol 1 -o table.csv\n");
+    printf_s("\tP528Drvr_x86.exe -mode PACK -tpol 0 -o p528.pack\n");
+    printf_s("\tP528Drvr_x86.exe -mode BATCH -i queries.csv -o results.csv\n");
+    printf_s("\tP528Drvr_x86.exe -mode BATCH -binary -i queries.cols -o results.cols\n");
+    printf_s("\tP528Drvr_x86.exe -mode BATCH -gzip -i queries.csv -o results.csv.gz\n");
+    printf_s("\tP528Drvr_x86.exe -mode DATASET -tpol 0 -o dataset\n");
+    printf_s("\tP528Drvr_x86.exe -mode DATASET -tpol 0 -shards 4 -shard 2 -o dataset\n");
+    printf_s("\tP528Drvr_x86.exe -mode MERGE -shards 4 -o dataset\n");
+    printf_s("\tP528Drvr_x86.exe -mode SERVE -socket /tmp/p528.sock\n");
+    printf_s("\tP528Drvr_x86.exe -mode QUERY -socket /tmp/p528.sock -i queries.csv\n");
+    printf_s("\tP528Drvr_x86.exe -mode TRACK -h1 15 -f 1090 -p 50 -tpol 0 -hq 10 -i tracks.csv -o results.csv\n");
+    printf_s("\n");
+    printf_s("BATCH query rows are d__km,h_1__meter,h_2__meter,f__mhz,T_pol,p.  Blank rows, rows\n");
+    printf_s("starting with '#', and a header on the first line are skipped.  Each other row gives\n");
+    printf_s("one result row, in input order: return code,free space loss,basic transmission loss,\n");
+    printf_s("warnings.  Rows that do not parse, or hold non-finite values, return 1019.\n");
+    printf_s("QUERY reads and writes rows the same way, through a SERVE process.  TRACK rows are\n");
+    printf_s("track,d__km,h_2__meter, with the samples of each track in time order\n");
     printf_s("\n");
 };
\ No newline at end of file
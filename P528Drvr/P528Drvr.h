@@ -1,6 +1,76 @@
+//
+// PLATFORM
+///////////////////////////////////////////////
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <errno.h>
+#include <stdio.h>
+
+#define __stdcall
+
+// Bounds-checked CRT functions used by the driver, in terms of the standard ones
+#define printf_s                                printf
+#define fprintf_s                               fprintf
+#define sscanf_s                                sscanf
+#define sprintf_s(buffer, format, ...)          snprintf(buffer, sizeof(buffer), format, __VA_ARGS__)
+
+inline int fopen_s(FILE** fp, const char* filename, const char* mode) {
+    *fp = fopen(filename, mode);
+    return (*fp == NULL) ? errno : 0;
+}
+#endif
+
+#include <atomic>
+#include <charconv>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string.h>
+#include <vector>
+
+// Data structures, return codes and warnings shared with the library
+#include "../include/p528.h"
+
+// Functions of the library.  On Windows the DLL is loaded at run time and its
+// functions are looked up by name; elsewhere the driver links to the shared
+// library and takes the address of the export itself
+#ifdef _WIN32
+#define GET_FUNCTION(type, name)                ((type)GetFunction(#name))
+#else
+#define GET_FUNCTION(type, name)                ((type)&name)
+#endif
 
 typedef int(__stdcall *p528func)(double d__km, double h_1__meter, double h_2__meter, 
     double f__mhz, int T_pol, double p, struct Result* result);
+typedef int(__stdcall *losstensorbuildfunc)(const double* d__km, int n_d, const double* h_1__meter, int n_h_1,
+    const double* h_2__meter, int n_h_2, const double* f__mhz, int n_f, const double* p, int n_p,
+    int T_pol, struct LossTensor* tensor);
+typedef int(__stdcall *losstensorwritepackfunc)(const struct LossTensor* tensor, const char* filename);
+typedef void(__stdcall *losstensorfreefunc)(struct LossTensor* tensor);
+typedef int(__stdcall *adaptivecurvefunc)(double h_1__meter, double h_2__meter, double f__mhz, int T_pol, double p,
+    double d_max__km, double tolerance__db, int capacity, double* d__km, struct Result* results, int* count);
+typedef int(__stdcall *querycolumnsopenfunc)(const char* filename, struct QueryColumns* queries);
+typedef void(__stdcall *querycolumnsfreefunc)(struct QueryColumns* queries);
+typedef int(__stdcall *resultcolumnscreatefunc)(const char* filename, long long n, struct ResultColumnsWriter* writer);
+typedef int(__stdcall *resultcolumnswriterowsfunc)(struct ResultColumnsWriter* writer, long long first, int count,
+    const int* rtn, const struct Result* results);
+typedef int(__stdcall *resultcolumnsclosefunc)(struct ResultColumnsWriter* writer);
+typedef int(__stdcall *initpathcontextsfunc)(const double* h_1__meter, const double* h_2__meter, int n,
+    double f__mhz, int T_pol, struct PathContext* contexts);
+typedef int(__stdcall *initpathcontextfunc)(double h_1__meter, double h_2__meter, double f__mhz, int T_pol,
+    struct PathContext* context);
+typedef int(__stdcall *contextfunc)(const struct PathContext* context, double d__km, double p, struct Result* result);
+typedef void(__stdcall *versionfunc)(int* major, int* minor);
+typedef void(__stdcall *resamplecurvefunc)(const double* d__km, const struct Result* results, int count,
+    const double* d_out__km, int n_out, struct Result* results_out);
+typedef int(__stdcall *inittrajectoryfunc)(double h_1__meter, double f__mhz, int T_pol, double h_quantum__meter,
+    struct Trajectory* trajectory);
+typedef int(__stdcall *trajectoryfunc)(struct Trajectory* trajectory, double d__km, double h_2__meter, double p,
+    struct Result* result);
+typedef void(__stdcall *freetrajectoryfunc)(struct Trajectory* trajectory);
 
 //
 // CONSTANTS
@@ -10,16 +80,39 @@ typedef int(__stdcall *p528func)(double d__km, double h_1__meter, double h_2__me
 #define     MODE_CURVE                              1
 #define     MODE_TABLE                              2
 #define     MODE_VERSION                            3
+#define     MODE_PACK                               4
+#define     MODE_BATCH                              5
+#define     MODE_DATASET                            6
+#define     MODE_MERGE                              7
+#define     MODE_SERVE                              8
+#define     MODE_QUERY                              9
+#define     MODE_TRACK                              10
 #define     TIME_SIZE                               26
+#define     DRVR_VERSION_MAJOR                      5       // Matching P528Drvr.rc, where there is no version resource
+#define     DRVR_VERSION_MINOR                      1
 #define     CURVE_POINTS                            1801
+#define     TABLE_COLUMNS                           18
+#define     DATASET_FREQUENCIES                     8
+#define     DATASET_PERCENTAGES                     5
+#define     DATASET_TASKS                           (DATASET_FREQUENCIES * DATASET_PERCENTAGES * TABLE_COLUMNS)
+#define     SHARD_MAGIC                             "P528SHRD"
+#define     SHARD_HEADER_SIZE                       24
+#define     SERVICE_MAGIC                           0x38323550  // "P528", little-endian
+#define     SERVICE_MAX_QUERIES                     65536   // Largest request, in queries
+#define     SERVICE_CACHE_CONTEXTS                  4096    // Path contexts held before the cache is cleared
+#define     SERVICE_BACKLOG                         64
+#define     BATCH_CHUNK_ROWS                        4096    // Query rows parsed and evaluated together
+#define     BATCH_CHUNKS_PER_THREAD                 2       // Chunks in flight per worker thread
+#define     BATCH_LINE_SIZE                         256     // Longest query row, in characters
+#define     OUTPUT_BUFFER_SIZE                      (1 << 20)   // Bytes formatted before each block write
+#define     OUTPUT_NUMBER_SIZE                      320     // Longest formatted number, DBL_MAX with 3 decimals
+#define     OUTPUT_GZIP_MODE                        "wb1"   // Fastest deflate level
 
 //
 // GENERAL ERRORS AND RETURN VALUES
 ///////////////////////////////////////////////
 
 #define     NOT_SET                                 -1
-#define     SUCCESS                                 0
-#define     SUCCESS_WITH_WARNINGS                   11
 #define     DRVR__RETURN_SUCCESS                    1000
 
 #define     DRVRERR__UNKNOWN                        1001
@@ -27,6 +120,10 @@ typedef int(__stdcall *p528func)(double d__km, double h_1__meter, double h_2__me
 #define     DRVRERR__MAJOR_VERSION_MISMATCH         1003
 #define     DRVRERR__INVALID_OPTION                 1004
 #define     DRVRERR__GETP528_FUNC_LOADING           1005
+#define     DRVRERR__GETPACK_FUNC_LOADING           1006
+#define     DRVRERR__GETCURVE_FUNC_LOADING          1007
+#define     DRVRERR__BATCH_WRITE                    1008
+#define     DRVRERR__GETCOLUMNS_FUNC_LOADING        1009
 // Parsing Errors (1000-1099)
 #define     DRVRERR__PARSE_H1_HEIGHT                1010
 #define     DRVRERR__PARSE_H2_HEIGHT                1011
@@ -35,6 +132,12 @@ typedef int(__stdcall *p528func)(double d__km, double h_1__meter, double h_2__me
 #define     DRVRERR__PARSE_P_PERCENTAGE             1014
 #define     DRVRERR__PARSE_MODE_VALUE               1015
 #define     DRVRERR__PARSE_TPOL_POLARIZATION        1016
+#define     DRVRERR__PARSE_TOLERANCE                1017
+#define     DRVRERR__PARSE_THREADS                  1018
+#define     DRVRERR__PARSE_BATCH_ROW                1019
+#define     DRVRERR__PARSE_SHARDS                   1020
+#define     DRVRERR__PARSE_SHARD                    1021
+#define     DRVRERR__PARSE_H_QUANTUM                1022
 // Validation Errors (1100-1199)
 #define     DRVRERR__VALIDATION_MODE                1100
 #define     DRVRERR__VALIDATION_F                   1101
@@ -44,32 +147,24 @@ typedef int(__stdcall *p528func)(double d__km, double h_1__meter, double h_2__me
 #define     DRVRERR__VALIDATION_H2                  1105
 #define     DRVRERR__VALIDATION_OUT_FILE            1106
 #define     DRVRERR__VALIDATION_TPOL                1107
-
-//
-// WARNINGS
-///////////////////////////////////////////////
-
-#define WARNING__NO_WARNINGS                0x00
-#define WARNING__DFRAC_TROPO_REGION         0x01
-#define WARNING__HEIGHT_LIMIT_H_1           0x02
-#define WARNING__HEIGHT_LIMIT_H_2           0x04
+#define     DRVRERR__VALIDATION_IN_FILE             1108
+#define     DRVRERR__VALIDATION_SHARD               1109
+#define     DRVRERR__VALIDATION_SOCKET              1110
+// Data set Errors (1200-1299)
+#define     DRVRERR__SHARD_FILE                     1200
+#define     DRVRERR__SHARD_MISMATCH                 1201
+// Service Errors (1300-1399)
+#define     DRVRERR__SERVICE_SOCKET                 1300
+#define     DRVRERR__SERVICE_PROTOCOL               1301
+#define     DRVRERR__SERVICE_UNSUPPORTED            1302
+// Output Errors (1400-1499)
+#define     DRVRERR__OUTPUT_UNSUPPORTED             1400
+#define     DRVRERR__OUTPUT_WRITE                   1401
 
 //
 // DATA STRUCTURES
 ///////////////////////////////////////////////
 
-struct Result {
-    int propagation_mode;       // Mode of propagation
-    int warnings;               // Warning messages
-
-    double d__km;               // Path distance used in calculations
-    double A__db;               // Total loss
-    double A_fs__db;            // Free space path loss
-    double A_a__db;             // Atmospheric absorption loss, in dB
-
-    double theta_h1__rad;       // Elevation angle of the ray at the low terminal, in rad
-};
-
 struct DrvrParams {
     double h_1__meter = NOT_SET;  // Low terminal height (meter), 1.5 <= h_1__meter <= 20 000 AND h_1__meter <= h2__meter
     double h_2__meter = NOT_SET;  // High terminal height (meter), 1.5 <= h_2__meter <= 20 000 AND h_1__meter <= h2__meter
@@ -78,9 +173,280 @@ struct DrvrParams {
     double d__km = NOT_SET;       // Path distance (km), 0 <= d__km
     int T_pol = NOT_SET;          // Polarization
 
-    int mode = NOT_SET;           // Mode (POINT, CURVE, TABLE)
+    int mode = NOT_SET;           // Mode (POINT, CURVE, TABLE, PACK)
+
+    double tolerance__db = NOT_SET;   // Adaptive CURVE tolerance (dB), or NOT_SET for the 1 km grid
+    bool resample = false;            // Resample an adaptive CURVE onto the 1 km grid
+
+    int threads = NOT_SET;        // BATCH worker threads, or NOT_SET for one per core
+    bool binary = false;          // BATCH reads and writes columnar files instead of CSV
+
+    int shards = NOT_SET;         // DATASET and MERGE number of shards, or NOT_SET for one run
+    int shard = NOT_SET;          // DATASET shard to generate, 0 <= shard < shards
+
+    char socket_path[108] = { 0 };    // SERVE and QUERY Unix domain socket
+
+    double h_quantum__meter = 0;  // TRACK high terminal height quantum (meter), or 0 for exact heights
+
+    bool gzip = false;            // Compress CSV output files with gzip
+
+    char in_file[256] = { 0 };    // BATCH and QUERY input file, or stdin if not set
+    char out_file[256] = { 0 };   // Output file, or directory for DATASET and MERGE
+};
+
+struct BatchQuery {
+    double d__km;
+    double h_1__meter;
+    double h_2__meter;
+    double f__mhz;
+    int T_pol;
+    double p;
+
+    int rtn;                      // DRVRERR__PARSE_BATCH_ROW if the row could not be parsed
+    Result result;
+};
+
+struct BatchChunk {
+    long long index;              // Position of the chunk in the input
+    int count;                    // Number of query rows
+    BatchQuery queries[BATCH_CHUNK_ROWS];
+};
+
+// Blocking FIFO queue of chunks, shared between the BATCH pipeline stages.
+// The pipeline allocates a fixed pool of chunks up front, so a queue never
+// holds more than the pool and push never has to wait
+class ChunkQueue {
+public:
+    void Push(BatchChunk* chunk) {
+        std::lock_guard<std::mutex> lock(mutex);
+        chunks.push_back(chunk);
+        ready.notify_one();
+    }
+
+    // Returns NULL once the queue is closed and empty
+    BatchChunk* Pop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [this] { return !chunks.empty() || closed; });
+        if (chunks.empty())
+            return NULL;
+
+        BatchChunk* chunk = chunks.front();
+        chunks.pop_front();
+        return chunk;
+    }
+
+    void Close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        ready.notify_all();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<BatchChunk*> chunks;
+    bool closed = false;
+};
+
+// Buffered writer of CSV output.  Numbers are formatted with std::to_chars
+// straight into a large buffer, byte-identical to the printf formats they
+// replace, and the buffer is written out in blocks, compressed with gzip if
+// asked.  A writer is used by one thread at a time
+class OutputWriter {
+public:
+    OutputWriter();
+    ~OutputWriter();
+
+    int Open(const char* filename, bool gzip);
+    bool Close();
+    void Format(const char* format, ...);
+
+    void Text(const char* text) {
+        size_t length = strlen(text);
+        if (length > OUTPUT_BUFFER_SIZE - used)
+            Flush();
+        if (length > OUTPUT_BUFFER_SIZE) {
+            Write(text, length);
+            return;
+        }
+
+        memcpy(&buffer[used], text, length);
+        used += length;
+    }
+
+    void Char(char c) {
+        if (used == OUTPUT_BUFFER_SIZE)
+            Flush();
+        buffer[used++] = c;
+    }
+
+    // "%i"
+    void Int(int value) {
+        Reserve();
+        used = std::to_chars(&buffer[used], &buffer[used] + OUTPUT_NUMBER_SIZE, value).ptr - buffer.data();
+    }
+
+    // "%.3f"
+    void Fixed(double value) {
+        Reserve();
+        used = std::to_chars(&buffer[used], &buffer[used] + OUTPUT_NUMBER_SIZE, value, std::chars_format::fixed,
+            3).ptr - buffer.data();
+    }
+
+    // "0x%x"
+    void Hex(int value) {
+        Reserve();
+        buffer[used++] = '0';
+        buffer[used++] = 'x';
+        used = std::to_chars(&buffer[used], &buffer[used] + OUTPUT_NUMBER_SIZE, (unsigned int)value, 16).ptr -
+            buffer.data();
+    }
+
+private:
+    void Reserve() {
+        if (OUTPUT_BUFFER_SIZE - used < OUTPUT_NUMBER_SIZE + 2)
+            Flush();
+    }
+
+    void Flush();
+    void Write(const char* data, size_t size);
+
+    std::vector<char> buffer;
+    size_t used = 0;
+    FILE* fp = NULL;
+    void* gz = NULL;              // gzFile, when compressing
+    bool ok = true;               // False once a write has failed
+};
+
+// SERVE protocol.  Over a local socket, values are in the host layout.  A
+// request is SERVICE_MAGIC, a uint32 count and count ServiceQuery records;
+// the reply is SERVICE_MAGIC, the same count and count ServiceReply records
+struct ServiceQuery {
+    double d__km;
+    double h_1__meter;
+    double h_2__meter;
+    double f__mhz;
+    double p;
+    int T_pol;
+    int reserved;
+};
+
+struct ServiceReply {
+    int rtn;
+    int reserved;
+    Result result;
+};
+
+// Queries sharing a key share a path context.  The ordering needs finite
+// values, so queries with NaN fields never reach the batcher
+struct ServiceKey {
+    double h_1__meter;
+    double h_2__meter;
+    double f__mhz;
+    int T_pol;
+
+    bool operator<(const ServiceKey& other) const {
+        if (h_1__meter != other.h_1__meter)
+            return h_1__meter < other.h_1__meter;
+        if (h_2__meter != other.h_2__meter)
+            return h_2__meter < other.h_2__meter;
+        if (f__mhz != other.f__mhz)
+            return f__mhz < other.f__mhz;
+        return T_pol < other.T_pol;
+    }
+};
+
+// Request of one connection, while its queries are evaluated
+struct ServiceRequest {
+    std::vector<ServiceQuery> queries;
+    std::vector<ServiceReply> replies;
+
+    int remaining;                // Queries not yet evaluated
+    std::mutex mutex;
+    std::condition_variable done;
+};
+
+struct PendingQuery {
+    ServiceRequest* request;
+    int index;
+};
+
+// Queries waiting for evaluation, grouped by key.  Queries of any request
+// that arrive while their key is waiting join the same batch
+class ServiceBatcher {
+public:
+    // Queues the queries of a request.  Queries already answered, with a
+    // reply code other than SUCCESS, are skipped
+    void Submit(ServiceRequest* request) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int i = 0; i < (int)request->queries.size(); i++) {
+            if (request->replies[i].rtn != SUCCESS)
+                continue;
+
+            const ServiceQuery* query = &request->queries[i];
+            ServiceKey key = { query->h_1__meter, query->h_2__meter, query->f__mhz, query->T_pol };
+
+            std::vector<PendingQuery>* batch = &pending[key];
+            if (batch->empty()) {
+                order.push_back(key);
+                ready.notify_one();
+            }
+            PendingQuery item = { request, i };
+            batch->push_back(item);
+        }
+    }
+
+    // Takes the oldest batch.  Returns false once closed
+    bool Take(ServiceKey* key, std::vector<PendingQuery>* batch) {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [this] { return !order.empty() || closed; });
+        if (order.empty())
+            return false;
+
+        *key = order.front();
+        order.pop_front();
+        batch->swap(pending[*key]);
+        pending.erase(*key);
+        return true;
+    }
+
+    void Close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        ready.notify_all();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::map<ServiceKey, std::vector<PendingQuery>> pending;
+    std::deque<ServiceKey> order;
+    bool closed = false;
+};
+
+// Path contexts shared by all connections
+class ServiceCache {
+public:
+    bool Find(const ServiceKey& key, PathContext* context) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::map<ServiceKey, PathContext>::iterator it = contexts.find(key);
+        if (it == contexts.end())
+            return false;
+
+        *context = it->second;
+        return true;
+    }
+
+    void Insert(const ServiceKey& key, const PathContext& context) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (contexts.size() >= SERVICE_CACHE_CONTEXTS)
+            contexts.clear();
+        contexts[key] = context;
+    }
 
-    char out_file[256] = { 0 };   // Output file
+private:
+    std::mutex mutex;
+    std::map<ServiceKey, PathContext> contexts;
 };
 
 //
@@ -97,6 +463,38 @@ void GetDrvrVersionInfo();
 int ValidateInputs(DrvrParams* params);
 int Validate_RequiredErrMsgHelper(const char* opt, int err);
 int LoadDLL();
+#ifdef _WIN32
+void* GetFunction(const char* name);
+#endif
 int CallP528_POINT(DrvrParams* params);
 int CallP528_CURVE(DrvrParams* params);
 int CallP528_TABLE(DrvrParams* params);
+void WriteTable(OutputWriter* out, double f__mhz, double p, const double* A_fs__db, const double* A__db);
+int CallP528_DATASET(DrvrParams* params);
+int CallP528_MERGE(DrvrParams* params);
+void InitDatasetContexts(initpathcontextsfunc init_func, int T_pol, std::atomic<int>* next, PathContext* contexts,
+    int* rtn);
+void EvaluateDatasetTasks(contextfunc context_func, const PathContext* contexts, const int* tasks, int n_tasks,
+    std::atomic<int>* next, double* A__db, double* A_fs__db);
+int WriteDatasetTables(const char* dir, bool gzip, int T_pol, const double* A__db, const double* A_fs__db);
+void EvaluateTableColumns(contextfunc context_func, const PathContext* contexts, double p, std::atomic<int>* next,
+    double* A__db, double* A_fs__db);
+int CallP528_PACK(DrvrParams* params);
+int CallP528_BATCH(DrvrParams* params);
+bool ReadBatchChunk(FILE* fp, bool first, BatchChunk* chunk);
+void EvaluateBatchChunks(ChunkQueue* work, ChunkQueue* done);
+void WriteBatchChunks(OutputWriter* out, ChunkQueue* done, ChunkQueue* free);
+void WriteBatchRow(OutputWriter* out, int rtn, const Result* result);
+void WriteFileHeader(OutputWriter* out, const DrvrParams* params);
+int CallP528_BATCH_BINARY(DrvrParams* params, int threads);
+void EvaluateBatchRows(const QueryColumns* queries, std::atomic<long long>* next, ResultColumnsWriter* writer,
+    resultcolumnswriterowsfunc write_rows, std::mutex* write_lock, int* rtn);
+int CallP528_TRACK(DrvrParams* params);
+int CallP528_SERVE(DrvrParams* params);
+int CallP528_QUERY(DrvrParams* params);
+void ServeConnection(int fd, ServiceBatcher* batcher);
+int ValidateServiceQuery(const ServiceQuery* query);
+void EvaluateServiceBatches(ServiceBatcher* batcher, ServiceCache* cache, initpathcontextfunc init_func,
+    contextfunc context_func);
+bool ReadFull(int fd, void* buffer, size_t size);
+bool WriteFull(int fd, const void* buffer, size_t size);
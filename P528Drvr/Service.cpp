@@ -0,0 +1,385 @@
+#include <math.h>
+#include <string.h>
+#include <thread>
+#include "P528Drvr.h"
+
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+/*=============================================================================
+ |
+ |  Description:  Local P.528 query service.  SERVE mode listens on a Unix
+ |                domain socket and answers requests from any number of
+ |                connections.  Each connection submits the queries of a
+ |                request to a shared batcher, which groups waiting queries
+ |                by (h_1, h_2, f, T_pol).  Worker threads take one group at
+ |                a time and evaluate it over a single path context, kept in
+ |                a cache shared by all connections.  QUERY mode is a client
+ |                that sends rows in the BATCH format and prints the replies.
+ |
+ |                Unix domain sockets are not supported on Windows
+ |
+ *===========================================================================*/
+
+#ifdef _WIN32
+
+int CallP528_SERVE(DrvrParams* params) {
+    printf_s("SERVE mode is not supported on Windows.\n");
+    return DRVRERR__SERVICE_UNSUPPORTED;
+}
+
+int CallP528_QUERY(DrvrParams* params) {
+    printf_s("QUERY mode is not supported on Windows.\n");
+    return DRVRERR__SERVICE_UNSUPPORTED;
+}
+
+#else
+
+/*=============================================================================
+ |
+ |  Description:  Serves P.528 queries over a Unix domain socket, until the
+ |                process is stopped
+ |
+ |        Input:  params        - Structure with user input parameters
+ |
+ |      Returns:  Driver error code, if the socket fails
+ |
+ *===========================================================================*/
+int CallP528_SERVE(DrvrParams* params) {
+    initpathcontextfunc dllP528_InitPathContext = GET_FUNCTION(initpathcontextfunc, P528_InitPathContext);
+    contextfunc dllP528_Context = GET_FUNCTION(contextfunc, P528_Context);
+    if (dllP528_InitPathContext == nullptr || dllP528_Context == nullptr)
+        return DRVRERR__GETP528_FUNC_LOADING;
+
+    // a client that goes away must not stop the service
+    signal(SIGPIPE, SIG_IGN);
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(params->socket_path) >= sizeof(address.sun_path)) {
+        printf_s("Socket path is too long.  Exiting.\n");
+        return DRVRERR__SERVICE_SOCKET;
+    }
+    strcpy(address.sun_path, params->socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        printf_s("Error creating socket.  Exiting.\n");
+        return DRVRERR__SERVICE_SOCKET;
+    }
+
+    // replace the socket of a previous run
+    unlink(params->socket_path);
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, SERVICE_BACKLOG) != 0) {
+        printf_s("Error listening on %s.  Exiting.\n", params->socket_path);
+        close(fd);
+        return DRVRERR__SERVICE_SOCKET;
+    }
+
+    int threads = params->threads;
+    if (threads == NOT_SET)
+        threads = (std::thread::hardware_concurrency() > 0) ? (int)std::thread::hardware_concurrency() : 1;
+
+    ServiceBatcher batcher;
+    ServiceCache cache;
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; i++)
+        workers.push_back(std::thread(EvaluateServiceBatches, &batcher, &cache, dllP528_InitPathContext,
+            dllP528_Context));
+
+    printf_s("Serving P.528 on %s\n", params->socket_path);
+    fflush(stdout);
+
+    for (;;) {
+        int client = accept(fd, NULL, NULL);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            break;
+        }
+
+        std::thread(ServeConnection, client, &batcher).detach();
+    }
+
+    printf_s("Error accepting connections.  Exiting.\n");
+    close(fd);
+    unlink(params->socket_path);
+
+    // connections still open end the process with it
+    batcher.Close();
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+
+    return DRVRERR__SERVICE_SOCKET;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Connection thread of SERVE mode.  Answers requests until
+ |                the client closes the connection or breaks the protocol.
+ |                Queries that fail ValidateServiceQuery() are answered with
+ |                its error code, without being submitted
+ |
+ |        Input:  fd            - Connected socket
+ |                batcher       - Shared batcher
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void ServeConnection(int fd, ServiceBatcher* batcher) {
+    ServiceRequest request;
+
+    for (;;) {
+        unsigned int header[2];
+        if (!ReadFull(fd, header, sizeof(header)) || header[0] != SERVICE_MAGIC || header[1] > SERVICE_MAX_QUERIES)
+            break;
+
+        int count = (int)header[1];
+        request.queries.resize(count);
+        request.replies.assign(count, ServiceReply());
+        if (!ReadFull(fd, request.queries.data(), count * sizeof(ServiceQuery)))
+            break;
+
+        int valid = 0;
+        for (int i = 0; i < count; i++) {
+            request.replies[i].rtn = ValidateServiceQuery(&request.queries[i]);
+            if (request.replies[i].rtn == SUCCESS)
+                valid++;
+        }
+
+        if (valid > 0) {
+            request.remaining = valid;
+            batcher->Submit(&request);
+
+            std::unique_lock<std::mutex> lock(request.mutex);
+            request.done.wait(lock, [&request] { return request.remaining == 0; });
+        }
+
+        if (!WriteFull(fd, header, sizeof(header)) ||
+            !WriteFull(fd, request.replies.data(), count * sizeof(ServiceReply)))
+            break;
+    }
+
+    close(fd);
+}
+
+/*=============================================================================
+ |
+ |  Description:  Checks that the fields of a service query are finite.
+ |                The library validates their ranges
+ |
+ |        Input:  query         - Service query
+ |
+ |      Returns:  SUCCESS or driver validation error code
+ |
+ *===========================================================================*/
+int ValidateServiceQuery(const ServiceQuery* query) {
+    if (!isfinite(query->d__km))
+        return DRVRERR__VALIDATION_D;
+    if (!isfinite(query->h_1__meter))
+        return DRVRERR__VALIDATION_H1;
+    if (!isfinite(query->h_2__meter))
+        return DRVRERR__VALIDATION_H2;
+    if (!isfinite(query->f__mhz))
+        return DRVRERR__VALIDATION_F;
+    if (!isfinite(query->p))
+        return DRVRERR__VALIDATION_P;
+
+    return SUCCESS;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Worker thread of SERVE mode.  Evaluates batches of queries
+ |                that share a path context, until the batcher is closed
+ |
+ |        Input:  batcher       - Shared batcher
+ |                cache         - Shared path contexts
+ |                init_func     - P528_InitPathContext() of the DLL
+ |                context_func  - P528_Context() of the DLL
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void EvaluateServiceBatches(ServiceBatcher* batcher, ServiceCache* cache, initpathcontextfunc init_func,
+    contextfunc context_func) {
+    ServiceKey key;
+    std::vector<PendingQuery> batch;
+    PathContext context;
+
+    while (batcher->Take(&key, &batch)) {
+        int rtn = SUCCESS;
+        if (!cache->Find(key, &context)) {
+            rtn = init_func(key.h_1__meter, key.h_2__meter, key.f__mhz, key.T_pol, &context);
+            if (rtn == SUCCESS)
+                cache->Insert(key, context);
+        }
+
+        for (size_t i = 0; i < batch.size(); i++) {
+            ServiceRequest* request = batch[i].request;
+            const ServiceQuery* query = &request->queries[batch[i].index];
+            ServiceReply* reply = &request->replies[batch[i].index];
+
+            if (rtn == SUCCESS)
+                reply->rtn = context_func(&context, query->d__km, query->p, &reply->result);
+            else
+                reply->rtn = rtn;
+
+            std::lock_guard<std::mutex> lock(request->mutex);
+            if (--request->remaining == 0)
+                request->done.notify_one();
+        }
+    }
+}
+
+/*=============================================================================
+ |
+ |  Description:  Client of SERVE mode.  Reads query rows in the BATCH
+ |                format, sends each chunk of rows as one request and
+ |                writes the replies in the BATCH format
+ |
+ |        Input:  params        - Structure with user input parameters
+ |
+ |      Returns:  SUCCESS or driver error code
+ |
+ *===========================================================================*/
+int CallP528_QUERY(DrvrParams* params) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(params->socket_path) >= sizeof(address.sun_path)) {
+        printf_s("Socket path is too long.  Exiting.\n");
+        return DRVRERR__SERVICE_SOCKET;
+    }
+    strcpy(address.sun_path, params->socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        printf_s("Error connecting to %s.  Exiting.\n", params->socket_path);
+        if (fd >= 0)
+            close(fd);
+        return DRVRERR__SERVICE_SOCKET;
+    }
+
+    FILE* fp_in = stdin;
+    if (strlen(params->in_file) > 0) {
+        int err = fopen_s(&fp_in, params->in_file, "r");
+        if (err != 0) {
+            printf_s("Error opening input file.  Exiting.\n");
+            close(fd);
+            return err;
+        }
+    }
+
+    OutputWriter out;
+    int err = out.Open(params->out_file, params->gzip);
+    if (err != 0) {
+        printf_s("Error opening output file.  Exiting.\n");
+        if (fp_in != stdin)
+            fclose(fp_in);
+        close(fd);
+        return err;
+    }
+
+    out.Text("Return Code,Free Space Loss (dB),Basic Transmission Loss (dB),Warning Flags\n");
+
+    std::vector<BatchChunk> chunk(1);
+    std::vector<ServiceQuery> queries;
+    std::vector<ServiceReply> replies;
+    int rtn = SUCCESS;
+
+    bool more = true;
+    for (bool first = true; more && rtn == SUCCESS; first = false) {
+        more = ReadBatchChunk(fp_in, first, &chunk[0]);
+
+        // rows that did not parse are answered here
+        queries.clear();
+        for (int i = 0; i < chunk[0].count; i++) {
+            const BatchQuery* row = &chunk[0].queries[i];
+            if (row->rtn != SUCCESS)
+                continue;
+
+            ServiceQuery query = { row->d__km, row->h_1__meter, row->h_2__meter, row->f__mhz, row->p, row->T_pol, 0 };
+            queries.push_back(query);
+        }
+
+        unsigned int header[2] = { SERVICE_MAGIC, (unsigned int)queries.size() };
+        replies.resize(queries.size());
+        if (!WriteFull(fd, header, sizeof(header)) ||
+            !WriteFull(fd, queries.data(), queries.size() * sizeof(ServiceQuery)) ||
+            !ReadFull(fd, header, sizeof(header)) || header[0] != SERVICE_MAGIC || header[1] != queries.size() ||
+            !ReadFull(fd, replies.data(), replies.size() * sizeof(ServiceReply))) {
+            rtn = DRVRERR__SERVICE_PROTOCOL;
+            break;
+        }
+
+        size_t k = 0;
+        for (int i = 0; i < chunk[0].count; i++) {
+            const BatchQuery* row = &chunk[0].queries[i];
+            if (row->rtn != SUCCESS)
+                WriteBatchRow(&out, row->rtn, &row->result);
+            else {
+                WriteBatchRow(&out, replies[k].rtn, &replies[k].result);
+                k++;
+            }
+        }
+    }
+
+    if (rtn != SUCCESS)
+        printf_s("Lost the connection to %s.  Exiting.\n", params->socket_path);
+
+    if (!out.Close() && rtn == SUCCESS)
+        rtn = DRVRERR__BATCH_WRITE;
+
+    close(fd);
+    if (fp_in != stdin)
+        fclose(fp_in);
+
+    return rtn;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Reads or writes exactly size bytes on a socket
+ |
+ |      Returns:  False if the connection closed or failed first
+ |
+ *===========================================================================*/
+bool ReadFull(int fd, void* buffer, size_t size) {
+    unsigned char* next = (unsigned char*)buffer;
+    while (size > 0) {
+        ssize_t n = read(fd, next, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+
+        next += n;
+        size -= (size_t)n;
+    }
+
+    return true;
+}
+
+bool WriteFull(int fd, const void* buffer, size_t size) {
+    const unsigned char* next = (const unsigned char*)buffer;
+    while (size > 0) {
+        ssize_t n = write(fd, next, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+
+        next += n;
+        size -= (size_t)n;
+    }
+
+    return true;
+}
+
+#endif
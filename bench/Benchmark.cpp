@@ -0,0 +1,185 @@
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "../include/p528.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/*=============================================================================
+ |
+ |  Description:  Benchmark of the P.528 library.  Each workload is fixed,
+ |                so that runs of different builds can be compared, and is
+ |                repeated scale times.  Results are written as CSV rows:
+ |                workload, operations, seconds, microseconds per operation.
+ |                The Monte Carlo sampler is also run over OpenMP threads
+ |                when built with them, and its samples are checked against
+ |                the single-threaded stream
+ |
+ |        Usage:  p528_bench [scale]
+ |
+ *===========================================================================*/
+
+typedef std::chrono::steady_clock Clock;
+
+// Paths of the README example values
+static const double paths[4][6] = {
+    // d__km, h_1__meter, h_2__meter, f__mhz, T_pol, p
+    {   15,  10,  1000,   500, 0, 50 },
+    {  100, 100, 15000,  3600, 0, 90 },
+    { 1500,  15, 10000,  5700, 0, 10 },
+    {   30,   8, 20000, 22000, 1, 50 },
+};
+
+/*=============================================================================
+ |
+ |  Description:  Writes the result row of one workload
+ |
+ |        Input:  name          - Name of the workload
+ |                operations    - Number of operations timed
+ |                start         - Time the workload started
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+static void Report(const char* name, long long operations, Clock::time_point start)
+{
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    printf("%s,%lld,%.6f,%.3f\n", name, operations, seconds, 1e6 * seconds / operations);
+    fflush(stdout);
+}
+
+int main(int argc, char** argv)
+{
+    int scale = (argc > 1) ? atoi(argv[1]) : 1;
+    if (scale < 1)
+    {
+        printf("Usage: p528_bench [scale]\n");
+        return 1;
+    }
+
+    Result result;
+    int major, minor;
+    P528_GetVersion(&major, &minor);
+    printf("# p528 %i.%i\n", major, minor);
+    printf("Workload,Operations,Seconds,Microseconds per Operation\n");
+
+    /////////////////////////////////////////////
+    // Independent P528() calls
+    //
+
+    Clock::time_point start = Clock::now();
+    long long count = 0;
+    for (int r = 0; r < scale; r++)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            for (int k = 0; k < 10; k++, count++)
+                P528(paths[i][0] + k, paths[i][1], paths[i][2], paths[i][3], (int)paths[i][4], paths[i][5], &result);
+        }
+    }
+    Report("P528", count, start);
+
+    /////////////////////////////////////////////
+    // Loss-vs-distance curve over one path context
+    //
+
+    PathContext context;
+    start = Clock::now();
+    count = 0;
+    for (int r = 0; r < scale; r++)
+    {
+        P528_InitPathContext(paths[0][1], paths[0][2], paths[0][3], (int)paths[0][4], &context);
+        for (int k = 0; k < 200; k++, count++)
+            P528_Context(&context, 1 + 2.5 * k, paths[0][5], &result);
+    }
+    Report("P528_Context", count, start);
+
+    /////////////////////////////////////////////
+    // Flight track replay, level at 9 km with altitude jitter under the 10 m quantum
+    //
+
+    start = Clock::now();
+    count = 0;
+    for (int r = 0; r < scale; r++)
+    {
+        Trajectory trajectory;
+        P528_InitTrajectory(15, 1090, 0, 10, &trajectory);
+        for (int k = 0; k < 200; k++, count++)
+            P528_Trajectory(&trajectory, 400 - 1.9 * k, 9000 + 3 * sin(0.1 * k), 50, &result);
+        P528_FreeTrajectory(&trajectory);
+    }
+    Report("P528_Trajectory", count, start);
+
+    /////////////////////////////////////////////
+    // Great-circle distances from a station to a grid of positions, against the
+    // haversine formula on the standard library
+    //
+
+    const int positions = 1 << 16;
+    std::vector<double> lat__deg(positions), lon__deg(positions), d__km(positions), d_libm__km(positions);
+    for (int i = 0; i < positions; i++)
+    {
+        lat__deg[i] = 30 + 10.0 * (i / 256) / 256;
+        lon__deg[i] = -110 + 10.0 * (i % 256) / 256;
+    }
+
+    start = Clock::now();
+    for (int r = 0; r < 16 * scale; r++)
+        GreatCircleDistanceBatch(35, -105, lat__deg.data(), lon__deg.data(), positions, d__km.data());
+    Report("GreatCircleDistanceBatch", 16LL * scale * positions, start);
+
+    start = Clock::now();
+    for (int r = 0; r < 16 * scale; r++)
+    {
+        const double deg_to_rad = PI / 180;
+        for (int i = 0; i < positions; i++)
+        {
+            double sin_dlat = sin((lat__deg[i] - 35) * deg_to_rad / 2);
+            double sin_dlon = sin((lon__deg[i] + 105) * deg_to_rad / 2);
+            double h = sin_dlat * sin_dlat + cos(35 * deg_to_rad) * cos(lat__deg[i] * deg_to_rad) * sin_dlon * sin_dlon;
+            d_libm__km[i] = 2 * a_0__km * asin(MIN(sqrt(h), 1.0));
+        }
+    }
+    Report("Haversine (libm)", 16LL * scale * positions, start);
+
+    double d_error__km = 0;
+    for (int i = 0; i < positions; i++)
+        d_error__km = MAX(d_error__km, fabs(d__km[i] - d_libm__km[i]));
+    printf("# great-circle distances within %.3g km of the standard library\n", d_error__km);
+
+    /////////////////////////////////////////////
+    // Monte Carlo loss samples
+    //
+
+    LossSampler sampler;
+    P528_InitLossSampler(paths[1][0], paths[1][1], paths[1][2], paths[1][3], (int)paths[1][4], &sampler);
+
+    const int block = 1 << 16;
+    int blocks = 32 * scale;
+    std::vector<double> A__db((size_t)block * blocks);
+    std::vector<double> A_threads__db((size_t)block * blocks);
+
+    start = Clock::now();
+    P528_SampleLoss(&sampler, 528, 0, block * blocks, A__db.data());
+    Report("P528_SampleLoss", (long long)block * blocks, start);
+
+    int threads = 1;
+    start = Clock::now();
+#ifdef _OPENMP
+    threads = omp_get_max_threads();
+#pragma omp parallel for schedule(static)
+#endif
+    for (int b = 0; b < blocks; b++)
+        P528_SampleLoss(&sampler, 528, (long long)b * block, block, &A_threads__db[(size_t)b * block]);
+    Report("P528_SampleLoss (threads)", (long long)block * blocks, start);
+
+    bool same = memcmp(A__db.data(), A_threads__db.data(), A__db.size() * sizeof(double)) == 0;
+    printf("# %i threads, samples %s the single-threaded stream\n", threads, same ? "match" : "DO NOT match");
+
+    return same ? 0 : 1;
+}
@@ -1,12 +1,21 @@
+#include <stdio.h>
 #include <vector>
 #include <algorithm>
 
 using namespace std;
 
+#ifdef _WIN32
 #define DLLEXPORT extern "C" __declspec(dllexport)
+#else
+#define DLLEXPORT extern "C" __attribute__((visibility("default")))
+#endif
 #define MAX(x, y) (((x) > (y)) ? (x) : (y))
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
 
+// Library version, matching win32/p528.rc
+#define P528_VERSION_MAJOR                  5
+#define P528_VERSION_MINOR                  2
+
 #define PI                                  3.1415926535897932384
 #define a_0__km                             6371.0
 #define a_e__km                             9257.0
@@ -35,6 +44,96 @@ using namespace std;
 
 #define Y_pi_99_INDEX                       16
 
+// Uniform grids for the fast Nakagami-Rice lookups.  Nodes fall on every
+// integer K and p, which includes every tabulated value of data::K and data::P
+#define NR_GRID__K_MIN                      -40
+#define NR_GRID__K_COUNT                    61      // K = -40, -39, ..., 20
+#define NR_GRID__P_MIN                      1
+#define NR_GRID__P_COUNT                    99      // p = 1, 2, ..., 99
+#define NR_GRID__Y_PI_99_BUCKETS            512
+
+// Piecewise Chebyshev surrogate of loss versus distance
+#define SURROGATE__ORDER                    12
+#define SURROGATE__MIN_LENGTH__KM           0.01
+#define SURROGATE__MAX_SEGMENTS             64
+
+// Adaptive loss-vs-distance curves
+#define CURVE__INITIAL_STEP__KM             10      // Largest spacing before refinement
+#define CURVE__MIN_STEP__KM                 0.01    // Smallest spacing after refinement
+
+// Inverse solvers
+#define INVERSE__TOLERANCE__KM              0.001   // Distance tolerance of a solution
+#define INVERSE__TOLERANCE__METER           0.1     // Height tolerance of a solution
+#define INVERSE__HEIGHT_NODES               32      // Heights probed for the high terminal
+#define INVERSE__LOBE_DEPTH                 3       // Halvings of a height interval in the two-ray region
+#define INVERSE__LOBE_SAMPLES               48      // Samples for the two-ray region of a height search
+#define INVERSE__LOBE_MARGIN__DB            10      // Depth of two-ray lobes and variability below free space
+#define INVERSE__FREE_SPACE_SAMPLES         16      // Samples closer in than psi_limit
+#define INVERSE__TWO_RAY_SAMPLES            32      // Samples from psi_limit to d_0
+
+// Iso-loss contours over distance and high terminal height
+#define CONTOUR__CELLS_D                    32      // Coarse cells along distance
+#define CONTOUR__CELLS_H                    16      // Coarse cells along height, log-spaced
+#define CONTOUR__DEPTH                      4       // Halvings of each coarse cell near a contour
+
+// Trajectories
+#define TRAJECTORY__PSI_STEP                1e-4    // First step of the warm-started psi search, in rad
+#define TRAJECTORY__CACHE_HEIGHTS           256     // High terminal heights held before the cache is cleared
+
+// Monte Carlo loss sampler.  Nodes are evenly spaced over the valid time percentages
+#define SAMPLER__NODES                      197     // Nodes of the loss-vs-p curve, 0.5% apart, one at p = 10
+#define SAMPLER__P_MIN                      1.0
+#define SAMPLER__P_MAX                      99.0
+#define SAMPLER__BLOCK                      256     // Samples drawn together
+
+// Aggregate interference.  Emitters are evaluated in batches, strongest bound first
+#define AGGREGATE__BATCH                    256     // Emitters evaluated between early-stop checks
+
+// Positions are converted to distances in chunks of this many
+#define GEODESIC__CHUNK                     256
+
+// Coverage rasters.  The header is followed by the flight levels
+#define RASTER__MAGIC                       "P528RAST"
+#define RASTER__FORMAT_VERSION              1
+#define RASTER__HEADER_SIZE                 112
+
+// Axes of the loss tensor, slowest to fastest varying
+#define LOSS_TENSOR__AXIS_F                 0       // log10(f__mhz)
+#define LOSS_TENSOR__AXIS_H_1               1
+#define LOSS_TENSOR__AXIS_H_2               2
+#define LOSS_TENSOR__AXIS_D                 3
+#define LOSS_TENSOR__AXIS_P                 4
+#define LOSS_TENSOR__AXIS_COUNT             5
+#define LOSS_TENSOR__ERROR_SAFETY           2.0     // Factor on the largest interpolation error sampled in a cell
+
+// Binary data pack.  All values are stored little-endian
+#define PACK__MAGIC                         "P528PACK"
+#define PACK__FORMAT_VERSION                2       // 2: cell errors are bounds, not errors at the center
+#define PACK__MODEL_VERSION                 "ITU-R P.528-5"
+#define PACK__HEADER_SIZE                   72
+#define PACK__CONTENT_LOSS_TENSOR           1
+
+// Columnar query and result files.  All values are stored little-endian
+#define COLUMNS__MAGIC                      "P528COLS"
+#define COLUMNS__FORMAT_VERSION             1
+#define COLUMNS__HEADER_SIZE                32
+#define COLUMNS__CONTENT_QUERIES            1
+#define COLUMNS__CONTENT_RESULTS            2
+#define COLUMNS__QUERY_DOUBLES              5       // d__km, h_1__meter, h_2__meter, f__mhz, p
+#define COLUMNS__QUERY_INTS                 1       // T_pol
+#define COLUMNS__RESULT_DOUBLES             5       // d__km, A__db, A_fs__db, A_a__db, theta_h1__rad
+#define COLUMNS__RESULT_INTS                3       // rtn, propagation_mode, warnings
+#define COLUMNS__BLOCK_ROWS                 4096    // Rows encoded per write
+
+// Snapshot of in-memory caches.  Records are stored in the host layout, so a
+// snapshot is only restored by the same library version on the same platform
+#define SNAPSHOT__MAGIC                     "P528SNAP"
+#define SNAPSHOT__FORMAT_VERSION            1
+#define SNAPSHOT__HEADER_SIZE               88
+#define SNAPSHOT__BYTE_ORDER                0x01020304
+#define SNAPSHOT__CONTENT_PATH_CONTEXTS     1
+#define SNAPSHOT__CONTENT_PATH_SURROGATES   2
+
 //
 // RETURN CODES
 ///////////////////////////////////////////////
@@ -51,6 +150,19 @@ using namespace std;
 #define ERROR_VALIDATION__POLARIZATION      9
 #define ERROR_HEIGHT_AND_DISTANCE           10
 #define SUCCESS_WITH_WARNINGS               11
+#define ERROR_LOSS_TENSOR__AXIS             12
+#define ERROR_LOSS_TENSOR__OUT_OF_RANGE     13
+#define ERROR_PACK__IO                      14
+#define ERROR_PACK__FORMAT                  15
+#define ERROR_PACK__CHECKSUM                16
+#define ERROR_SNAPSHOT__MISMATCH            17
+#define ERROR_SNAPSHOT__CAPACITY            18
+#define ERROR_CURVE__CAPACITY               19
+#define ERROR_INVERSE__NO_SOLUTION          20
+#define ERROR_CONTOUR__ALLOCATION           21
+#define ERROR_RASTER__GRID                  22
+#define ERROR_LOSS_TENSOR__ALLOCATION       23
+#define ERROR_CURVE__TOLERANCE              24
 
 //
 // WARNINGS
@@ -72,6 +184,9 @@ public:
 
     const static vector<vector<double>> NakagamiRiceCurves;
     const static vector<int> K;
+
+    const static vector<double> NakagamiRiceGrid;   // NakagamiRiceCurves resampled onto the uniform (K, p) grid
+    const static vector<int> Y_pi_99Index;          // Lower curve for each uniform bucket of Y_pi(99)
 };
 
 //
@@ -148,6 +263,212 @@ struct TroposcatterParams
     double M_s;                 // Troposcatter Line Slope
 };
 
+struct PathPoint
+{
+    int propagation_mode;       // Mode of propagation
+
+    // Distances
+    double d__km;               // Path distance
+    double d_result__km;        // Path distance used in calculations
+
+    // Losses
+    double A_fs__db;            // Free space path loss
+    double A_a__db;             // Atmospheric absorption loss, in dB
+    double A_T__db;             // Terrain attenuation (negative of the LOS loss in LOS)
+
+    // Variability
+    double f_theta_h;           // Angular distance factor
+    double K__db;               // K-value of the Nakagami-Rice distribution
+    double Y_e_50__db;          // Median of the long-term variability distribution
+
+    // Angles
+    double theta_h1__rad;       // Elevation angle of the ray at the low terminal, in rad
+};
+
+struct PathContext
+{
+    // Inputs
+    double h_1__meter;          // Height of the low terminal, in meters
+    double h_2__meter;          // Height of the high terminal, in meters
+    double f__mhz;              // Frequency, in MHz
+    int T_pol;                  // Polarization
+
+    Terminal terminal_1;
+    Terminal terminal_2;
+    Path path;
+
+    // Smooth earth diffraction line
+    double M_d;                 // Diffraction line slope
+    double A_d0;                // Diffraction line intercept
+    double A_dML__db;           // Diffraction loss at d_ML
+
+    // Line of sight
+    double psi_limit;           // Limiting grazing angle
+    double A_d_0__db;           // Loss at d_0
+
+    // Transhorizon
+    bool transhorizon;          // Transhorizon terms have been computed
+    double K_LOS;               // K-value at d_ML - 1 km
+    double d_crx__km;           // Diffraction/troposcatter crossover distance
+    int CASE;                   // Crossover case
+    int warnings;               // Warning flags of transhorizon results
+    LineOfSightParams los_params;   // Line-of-sight parameters at d_ML - 1 km
+};
+
+struct SurrogateSegment
+{
+    double d_min__km;                           // Start of the segment
+    double d_max__km;                           // End of the segment
+    double c[SURROGATE__ORDER + 1];             // Chebyshev coefficients
+    double error__db;                           // Dropped terms of a higher-order fit plus its sampled error, in dB
+};
+
+struct PathSurrogate
+{
+    double p;                                   // Time percentage of the fit
+    double d_min__km;                           // Start of the surrogate, d_0
+    double d_max__km;                           // End of the surrogate
+    int segment_count;
+    SurrogateSegment segments[SURROGATE__MAX_SEGMENTS];
+};
+
+struct CurveInterval
+{
+    double deviation__db;                       // Deviation of the midpoint from linear interpolation
+    int left;                                   // Index of the left sample
+    int middle;                                 // Index of the midpoint sample
+    int right;                                  // Index of the right sample
+
+    bool operator<(const CurveInterval& other) const { return deviation__db < other.deviation__db; }
+};
+
+// Lazily evaluated grid of loss over distance and high terminal height.  Each
+// row of the grid is a path context, built the first time the row is needed
+struct ContourGrid
+{
+    PathContext base;                           // Low terminal geometry
+    double p;                                   // Time percentage
+    double d_max__km;                           // Distance of the last column
+    double h_2_min__meter;                      // Height of the first row
+    double h_2_max__meter;                      // Height of the last row
+    int n_d;                                    // Number of cells along distance
+    int n_h;                                    // Number of cells along height
+
+    vector<double> A__db;                       // Loss at each node, NAN until evaluated
+    vector<PathContext> rows;
+    vector<bool> row_set;
+    int evaluations;                            // Number of nodes evaluated
+};
+
+// Piece of a contour crossing one grid cell, with its ends on the cell edges
+struct ContourSegment
+{
+    int level;                                  // Index of the loss level
+    long long edge[2];                          // Edges holding the ends
+    double x[2];                                // Ends, in fractional columns
+    double y[2];                                // Ends, in fractional rows
+};
+
+struct LossContours
+{
+    int line_count;                             // Number of polylines
+    int point_count;                            // Number of points over all polylines
+    int* line_level;                            // Index of the loss level of each polyline
+    int* line_start;                            // First point of each polyline, plus point_count at the end
+    double* d__km;                              // Distance of each point
+    double* h_2__meter;                         // High terminal height of each point
+    int evaluations;                            // Number of model evaluations used
+    void* storage;                              // Single allocation holding the arrays
+};
+
+// Regular latitude/longitude grid.  Pixel (row, col) is centered on
+// lat_0__deg + row * delta_lat__deg, lon_0__deg + col * delta_lon__deg
+struct RasterGrid
+{
+    double lat_0__deg;                          // Latitude of the first row
+    double lon_0__deg;                          // Longitude of the first column
+    double delta_lat__deg;                      // Latitude step between rows
+    double delta_lon__deg;                      // Longitude step between columns
+    int n_rows;
+    int n_cols;
+};
+
+// Loss of a path context versus distance, for the inverse solvers
+struct DistanceLoss
+{
+    const PathContext* context;
+    double p;                                   // Time percentage
+
+    double operator()(double d__km) const;
+};
+
+// Loss versus the height of the high terminal at a fixed distance.  The low
+// terminal geometry is held in the base context
+struct HeightLoss
+{
+    PathContext base;
+    double d__km;                               // Path distance, in km
+    double p;                                   // Time percentage
+
+    double operator()(double h_2__meter) const;
+};
+
+// State of a trajectory: a track of (d, h_2) samples against a fixed low
+// terminal.  The geometry of the low terminal is computed once.  Each
+// high terminal height, rounded to h_quantum__meter, keeps its path context
+// and the ray trace layers of its slant path in storage, and the grazing
+// angle of the last line-of-sight sample starts the next psi search
+struct Trajectory
+{
+    double h_1__meter;                          // Height of the low terminal, in meters
+    double f__mhz;                              // Frequency, in MHz
+    int T_pol;                                  // Polarization
+    double h_quantum__meter;                    // Rounding of the high terminal height, or 0 for none
+
+    Terminal terminal_1;                        // Geometry of the low terminal
+    double psi;                                 // Grazing angle of the last line-of-sight sample, or 0
+
+    void* storage;                              // Heights cached by the trajectory
+};
+
+// Loss of one path over time percentage, for drawing random loss samples.
+// Interval k runs from p = SAMPLER__P_MIN + k * step to the next node, and
+// holds the loss at both ends, the upper one as approached from below, so
+// that steps of the loss at a node are kept
+struct LossSampler
+{
+    double d__km;                               // Path distance, in km
+    int propagation_mode;                       // Mode of propagation
+    int warnings;                               // Warning flags of the path
+    double step;                                // Node spacing, in percent
+    double A__db[SAMPLER__NODES - 1][2];        // Loss at the ends of each interval, in dB
+};
+
+// Aggregate power received from a set of emitters.  Emitters that were not
+// evaluated are included in I_bound__dbw at their free-space bound
+struct Interference
+{
+    double I__dbw;                              // Power received from the evaluated emitters, in dBW
+    double I_bound__dbw;                        // Upper bound of the power received from all emitters, in dBW
+    int evaluated;                              // Number of emitters evaluated
+    int warnings;                               // Warning flags of the evaluated emitters
+};
+
+struct LossTensor
+{
+    int T_pol;                                  // Polarization
+    int n[LOSS_TENSOR__AXIS_COUNT];             // Number of nodes on each axis
+    const double* axes[LOSS_TENSOR__AXIS_COUNT];    // Node coordinates of each axis
+    double step[LOSS_TENSOR__AXIS_COUNT];       // Node spacing if the axis is uniform, else 0
+
+    const float* A__db;                         // Loss at each node, in dB
+    const float* error__db;                     // Interpolation error bound of each cell, in dB
+
+    void* storage;                              // Storage owned by the tensor, or NULL for a view
+    void* mapping;                              // Read-only mapping of a data pack, or NULL
+    size_t mapping_size;                        // Size of the mapping, in bytes
+};
+
 struct Result {
     int propagation_mode;       // Mode of propagation
     int warnings;               // Warning messages
@@ -160,11 +481,52 @@ struct Result {
     double theta_h1__rad;	    // Elevation angle of the ray at the low terminal, in rad
 };
 
+struct QueryColumns
+{
+    long long n;                                // Number of rows
+
+    const double* d__km;                        // Path distance, in km
+    const double* h_1__meter;                   // Height of the low terminal, in meters
+    const double* h_2__meter;                   // Height of the high terminal, in meters
+    const double* f__mhz;                       // Frequency, in MHz
+    const double* p;                            // Time percentage
+    const int* T_pol;                           // Polarization
+
+    void* storage;                              // Decoded copy of the columns, or NULL
+    void* mapping;                              // Read-only mapping of the file, or NULL
+    size_t mapping_size;                        // Size of the mapping, in bytes
+};
+
+struct ResultColumns
+{
+    long long n;                                // Number of rows
+
+    const double* d__km;                        // Columns of the Result fields
+    const double* A__db;
+    const double* A_fs__db;
+    const double* A_a__db;
+    const double* theta_h1__rad;
+    const int* rtn;                             // Return code of each row
+    const int* propagation_mode;
+    const int* warnings;
+
+    void* storage;                              // Decoded copy of the columns, or NULL
+    void* mapping;                              // Read-only mapping of the file, or NULL
+    size_t mapping_size;                        // Size of the mapping, in bytes
+};
+
+struct ResultColumnsWriter
+{
+    FILE* fp;                                   // Open result file
+    long long n;                                // Number of rows
+};
+
 //
 // FUNCTIONS
 ///////////////////////////////////////////////
 
 // Private Functions
+struct RayLayers;
 void GetPathLoss(double psi, Path *path, double f__mhz, double psi_limit, 
     double A_dML__db, double A_d_0__db, int T_pol, LineOfSightParams* params, double *R_Tg);
 void RayOptics(Terminal *terminal_1, Terminal *terminal_2, double psi, LineOfSightParams *result);
@@ -176,6 +538,68 @@ void TranshorizonSearch(Path* path, Terminal *terminal_1, Terminal *terminal_2,
     double* d_crx__km, int* MODE, int* warnings);
 double LinearInterpolation(double x1, double y1, double x2, double y2, double x);
 void ReflectionCoefficients(double psi, double f__mhz, int T_pol, double* R_g, double* phi_g);
+void LineOfSightInit(Path* path, Terminal* terminal_1, Terminal* terminal_2, double f__mhz, double A_dML__db,
+    int T_pol, double* psi_limit, double* A_d_0__db);
+void LineOfSightPoint(Path* path, Terminal* terminal_1, Terminal* terminal_2, LineOfSightParams* los_params, 
+    double f__mhz, double A_dML__db, double psi_limit, double A_d_0__db, double d__km, int T_pol, PathPoint* point);
+void LineOfSightPsiPoint(Path* path, Terminal* terminal_1, Terminal* terminal_2, LineOfSightParams* los_params,
+    double f__mhz, double A_dML__db, double psi_limit, double A_d_0__db, double d__km, double psi, int T_pol,
+    const RayLayers* layers, PathPoint* point);
+void InitPathGeometry(double h_1__meter, double h_2__meter, double f__mhz, int T_pol, PathContext* context);
+void InitPathLine(PathContext* context);
+void InitPathTranshorizon(PathContext* context);
+void TranshorizonPoint(const PathContext* context, Path* path, Terminal* terminal_1, Terminal* terminal_2,
+    double d__km, TroposcatterParams* tropo, PathPoint* point);
+void PathContextPoint(const PathContext* context, double d__km, PathPoint* point,
+    LineOfSightParams* los_params, TroposcatterParams* tropo);
+void PathPointResult(const Terminal* terminal_1, const Terminal* terminal_2, double f__mhz,
+    const PathPoint* point, double p, Result* result);
+int EvaluatePathLosses(const PathContext* context, double d__km, const double* p, int n_p, double* A__db);
+bool LocateTensorCell(const LossTensor* tensor, int axis, double x, int* i, double* w);
+double InterpolateTensorCell(const LossTensor* tensor, const int* i, const double* w);
+size_t TensorCellIndex(const LossTensor* tensor, const int* i);
+double TensorAxisStep(const double* nodes, int n);
+void PackU32(unsigned char* bytes, unsigned int value);
+void PackU64(unsigned char* bytes, unsigned long long value);
+unsigned int UnpackU32(const unsigned char* bytes);
+unsigned long long UnpackU64(const unsigned char* bytes);
+unsigned long long PackChecksum(const unsigned char* bytes, size_t size);
+void* MapPack(const char* filename, size_t* size);
+void UnmapPack(void* mapping, size_t size);
+void ColumnsHeader(int content, long long n, int n_doubles, int n_ints, unsigned char* header);
+int OpenColumns(const char* filename, int content, int n_doubles, int n_ints, long long* n,
+    const double** doubles, const int** ints, void** storage, void** mapping, size_t* mapping_size);
+int SeekColumns(FILE* fp, long long offset);
+int AddCurveInterval(const PathContext* context, double p, int left, int right, vector<double>* d__km,
+    vector<Result>* results, vector<CurveInterval>* intervals);
+template<typename Loss>
+double FindLossCrossing(const Loss& loss, double L__db, double x_a, double A_a__db, double x_b, double A_b__db,
+    double tolerance);
+double ContourGridHeight(const ContourGrid* grid, double y);
+double ContourGridLoss(ContourGrid* grid, int i, int j);
+void ContourCellSegments(ContourGrid* grid, int i, int j, const double* L__db, int n_levels,
+    vector<ContourSegment>* segments);
+void RefineContourCell(ContourGrid* grid, int i, int j, int size, const double* L__db, int n_levels,
+    vector<ContourSegment>* segments);
+double GreatCircleDistance(double lat_1__deg, double lon_1__deg, double lat_2__deg, double lon_2__deg);
+void RasterTileDistances(double lat__deg, double lon__deg, const RasterGrid* grid, int row_0, int col_0,
+    int n_rows, int n_cols, double* d__km);
+double RasterResolution(const RasterGrid* grid);
+double FreeSpaceLossBound(double d__km, double h_1__meter, double h_2__meter, double f__mhz);
+double HeightLossWithTerminal(const HeightLoss* search, double h_2__meter, const Terminal* terminal_2,
+    PathContext* context);
+bool FindLowestHeightCrossing(const HeightLoss& loss, double L__db, double h_a__meter, double A_a__db,
+    double h_b__meter, double A_b__db, double lobe__meter, int depth, int* budget, double* h_2__meter);
+void SnapshotHeader(int content, size_t record_size, unsigned long long count, unsigned char* header);
+int WriteSnapshot(int content, size_t record_size, const void* records, int count, const char* filename);
+int ReadSnapshot(const char* filename, int content, size_t record_size, void* records, int capacity, int* count);
+void FitSurrogateSegment(const PathContext* context, double p, double d_min__km, double d_max__km,
+    SurrogateSegment* segment);
+double EvaluateChebyshev(const SurrogateSegment* segment, double d__km);
+double FindPsiAtDistance(double d__km, Path* path, Terminal* terminal_1, Terminal* terminal_2);
+double FindPsiNearDistance(double d__km, double psi_start, Terminal* terminal_1, Terminal* terminal_2);
+double QuantizeHeight(double h_1__meter, double h_2__meter, double h_quantum__meter);
+double FindPsiAtDeltaR(double delta_r__km, Path* path, Terminal* terminal_1, Terminal* terminal_2, double terminate);
 void LineOfSight(Path* path, Terminal* terminal_1, Terminal* terminal_2, LineOfSightParams* los_params, double f__mhz, double A_dML__db,
     double p, double d__km, int T_pol, Result *result, double *K_LOS);
 double SmoothEarthDiffraction(double d_1__km, double d_2__km, double f__mhz, double d_0__km, int T_pol);
@@ -190,8 +614,73 @@ int ValidateInputs(double d__km, double h_1__meter, double h_2__meter, double f_
 // Public Functions
 DLLEXPORT int P528(double d__km, double h_1__meter, double h_2__meter, double f__mhz, 
     int T_pol, double p, Result *result);
+DLLEXPORT void P528_GetVersion(int* major, int* minor);
 DLLEXPORT int P528_Ex(double d__km, double h_1__meter, double h_2__meter, double f__mhz,
     int T_pol, double p, Result* result, Terminal* terminal_1, Terminal* terminal_2,
     TroposcatterParams* tropo, Path* path, LineOfSightParams* los_params);
 DLLEXPORT double FindKForYpiAt99Percent(double Y_pi_99__db);
-DLLEXPORT double NakagamiRice(double K, double q);
\ No newline at end of file
+DLLEXPORT double NakagamiRice(double K, double q);
+DLLEXPORT double NakagamiRiceFast(double K, double p);
+DLLEXPORT double FindKForYpiAt99PercentFast(double Y_pi_99__db);
+DLLEXPORT void NakagamiRiceBatch(const double* K, const double* p, int n, double* Y_pi__db);
+DLLEXPORT void FindKForYpiAt99PercentBatch(const double* Y_pi_99__db, int n, double* K);
+DLLEXPORT int P528_InitPathContext(double h_1__meter, double h_2__meter, double f__mhz, int T_pol, 
+    PathContext* context);
+DLLEXPORT int P528_InitPathContexts(const double* h_1__meter, const double* h_2__meter, int n, double f__mhz,
+    int T_pol, PathContext* contexts);
+DLLEXPORT int P528_Context(const PathContext* context, double d__km, double p, Result* result);
+DLLEXPORT int LossTensor_Build(const double* d__km, int n_d, const double* h_1__meter, int n_h_1,
+    const double* h_2__meter, int n_h_2, const double* f__mhz, int n_f, const double* p, int n_p,
+    int T_pol, LossTensor* tensor);
+DLLEXPORT int LossTensor_Query(const LossTensor* tensor, double d__km, double h_1__meter, double h_2__meter,
+    double f__mhz, double p, double* A__db, double* error__db);
+DLLEXPORT void LossTensor_Free(LossTensor* tensor);
+DLLEXPORT int P528_InitPathSurrogate(const PathContext* context, double p, double d_max__km,
+    double tolerance__db, PathSurrogate* surrogate);
+DLLEXPORT int P528_Surrogate(const PathContext* context, const PathSurrogate* surrogate, double d__km,
+    double* A__db, double* error__db);
+DLLEXPORT int LossTensor_WritePack(const LossTensor* tensor, const char* filename);
+DLLEXPORT int LossTensor_OpenPack(const char* filename, int verify, LossTensor* tensor);
+DLLEXPORT int P528_WriteContextSnapshot(const PathContext* contexts, int count, const char* filename);
+DLLEXPORT int P528_ReadContextSnapshot(const char* filename, PathContext* contexts, int capacity, int* count);
+DLLEXPORT int P528_WriteSurrogateSnapshot(const PathSurrogate* surrogates, int count, const char* filename);
+DLLEXPORT int P528_ReadSurrogateSnapshot(const char* filename, PathSurrogate* surrogates, int capacity, int* count);
+DLLEXPORT int P528_AdaptiveCurve(double h_1__meter, double h_2__meter, double f__mhz, int T_pol, double p,
+    double d_max__km, double tolerance__db, int capacity, double* d__km, Result* results, int* count);
+DLLEXPORT void P528_ResampleCurve(const double* d__km, const Result* results, int count,
+    const double* d_out__km, int n_out, Result* results_out);
+DLLEXPORT int P528_RangeForLoss(double h_1__meter, double h_2__meter, double f__mhz, int T_pol, double p,
+    double L__db, double d_max__km, double* d__km, double* intervals__km, int capacity, int* count);
+DLLEXPORT int P528_HeightForLoss(double h_1__meter, double d__km, double f__mhz, int T_pol, double p,
+    double L__db, double* h_2__meter, int* warnings);
+DLLEXPORT int P528_LossContours(double h_1__meter, double f__mhz, int T_pol, double p, const double* L__db,
+    int n_levels, double d_max__km, double h_2_min__meter, double h_2_max__meter, LossContours* contours);
+DLLEXPORT void P528_FreeLossContours(LossContours* contours);
+DLLEXPORT int P528_CoverageRaster(double lat__deg, double lon__deg, double h_1__meter, const double* h_2__meter,
+    int n_levels, double f__mhz, int T_pol, double p, const RasterGrid* grid, int tile_size,
+    double tolerance__db, const char* filename);
+DLLEXPORT void GreatCircleDistanceBatch(double lat_1__deg, double lon_1__deg, const double* lat_2__deg,
+    const double* lon_2__deg, int n, double* d__km);
+DLLEXPORT int P528_ContextPositions(const PathContext* context, double lat__deg, double lon__deg,
+    const double* lat_2__deg, const double* lon_2__deg, int n, double p, Result* results);
+DLLEXPORT int QueryColumns_Write(const char* filename, long long n, const double* d__km, const double* h_1__meter,
+    const double* h_2__meter, const double* f__mhz, const int* T_pol, const double* p);
+DLLEXPORT int QueryColumns_Open(const char* filename, QueryColumns* queries);
+DLLEXPORT void QueryColumns_Free(QueryColumns* queries);
+DLLEXPORT int ResultColumns_Create(const char* filename, long long n, ResultColumnsWriter* writer);
+DLLEXPORT int ResultColumns_WriteRows(ResultColumnsWriter* writer, long long first, int count, const int* rtn,
+    const Result* results);
+DLLEXPORT int ResultColumns_Close(ResultColumnsWriter* writer);
+DLLEXPORT int ResultColumns_Open(const char* filename, ResultColumns* results);
+DLLEXPORT void ResultColumns_Free(ResultColumns* results);
+DLLEXPORT int P528_InitTrajectory(double h_1__meter, double f__mhz, int T_pol, double h_quantum__meter,
+    Trajectory* trajectory);
+DLLEXPORT int P528_Trajectory(Trajectory* trajectory, double d__km, double h_2__meter, double p, Result* result);
+DLLEXPORT void P528_FreeTrajectory(Trajectory* trajectory);
+DLLEXPORT int P528_AggregateInterference(double h_1__meter, double f__mhz, int T_pol, double p,
+    const double* d__km, const double* h_2__meter, const double* eirp__dbw, int n, double h_quantum__meter,
+    double margin__db, double tolerance__db, Interference* result);
+DLLEXPORT int P528_InitLossSampler(double d__km, double h_1__meter, double h_2__meter, double f__mhz, int T_pol,
+    LossSampler* sampler);
+DLLEXPORT void P528_SampleLoss(const LossSampler* sampler, unsigned long long seed, long long first, int n,
+    double* A__db);
\ No newline at end of file
@@ -1,9 +1,14 @@
 #include <vector>
 #include <algorithm>
+#include "p835.h"
 
 using namespace std;
 
+#ifdef _WIN32
 #define DLLEXPORT extern "C" __declspec(dllexport)
+#else
+#define DLLEXPORT extern "C" __attribute__((visibility("default")))
+#endif
 #define MAX(x, y) (((x) > (y)) ? (x) : (y))
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
 
@@ -22,6 +27,21 @@ struct SlantPathAttenuationResult
     double a__km;                           // Ray length, in km
     double angle__rad;                      // Incident angle, in rad
     double delta_L__km;                     // Excess atmospheric path length, in km
+    double h_G__km;                         // Height of the lowest point of the ray, in km
+    int iterations;                         // Iterations of the h_G search for negative elevation angles
+};
+
+// Layers of a ray trace between two heights.  Layer k spans from h__km[k]
+// to h__km[k + 1], and holds the properties at its middle.  None of these
+// depend on the elevation angle
+struct RayLayers
+{
+    int i_lower;                            // Index of the first layer, Equation 16(a)
+    int i_upper;                            // Index of the last layer, Equation 16(b)
+    double m;                               // Layer thickness parameter, Equation 16(c)
+    vector<double> h__km;                   // Height of the bottom of each layer, in km
+    vector<double> n;                       // Refractive index of each layer
+    vector<double> gamma;                   // Specific attenuation of each layer, in dB/km
 };
 
 struct RayTraceConfig
@@ -29,6 +49,27 @@ struct RayTraceConfig
     Temperature temperature;
     DryPressure dry_pressure;
     WetPressure wet_pressure;
+
+    // Atmosphere policy interface, for custom profiles given as function pointers
+    void GetState(double h__km, double* T__kelvin, double* p__hPa, double* e__hPa) const
+    {
+        *T__kelvin = temperature(h__km);
+        *p__hPa = dry_pressure(h__km);
+        *e__hPa = wet_pressure(h__km);
+    }
+};
+
+double GlobalWetPressure(double h__km);
+
+// Atmosphere policy for the mean annual global reference atmosphere of
+// Rec ITU-R P.835.  Statically dispatched, so the atmosphere evaluation is
+// visible to the compiler inside the ray trace layer loop
+struct GlobalAtmosphere
+{
+    void GetState(double h__km, double* T__kelvin, double* p__hPa, double* e__hPa) const
+    {
+        GlobalAtmosphereState(h__km, T__kelvin, p__hPa, e__hPa);
+    }
 };
 
 class OxygenData
@@ -60,6 +101,7 @@ double NonresonantDebyeAttenuation(double f__ghz, double e__hPa, double p__hPa,
 double RefractiveIndex(double p__hPa, double T__kelvin, double e__hPa);
 void GetLayerProperties(double f__ghz, double h_i__km, RayTraceConfig config,
     double* n, double* gamma);
+double LayerThickness(double m, int i);
 
 double SpecificAttenuation(double f__ghz, double T__kelvin, double e__hPa, double p__hPa);
 double OxygenRefractivity(double f__ghz, double T__kelvin, double e__hPa, double p__hPa);
@@ -73,5 +115,24 @@ void RayTrace(double f__ghz, double h_1__km, double h_2__km, double beta_1__rad,
 
 int SlantPathAttenuation(double f__ghz, double h_1__km, double h_2__km, double beta_1__rad,
     SlantPathAttenuationResult* result);
+int SlantPathAttenuation(double f__ghz, double h_1__km, double h_2__km, double beta_1__rad,
+    RayTraceConfig config, SlantPathAttenuationResult* result);
+
+// Templated on an atmosphere policy providing GetState().  Instantiated
+// for GlobalAtmosphere and RayTraceConfig
+template<typename Atmosphere>
+void GetLayerProperties(double f__ghz, double h_i__km, const Atmosphere& atmosphere,
+    double* n, double* gamma);
 
-double GlobalWetPressure(double h__km);
\ No newline at end of file
+template<typename Atmosphere>
+void InitRayLayers(double f__ghz, double h_1__km, double h_2__km, const Atmosphere& atmosphere,
+    RayLayers* layers);
+void TraceRayLayers(const RayLayers* layers, double beta_1__rad, SlantPathAttenuationResult* result);
+
+template<typename Atmosphere>
+void RayTrace(double f__ghz, double h_1__km, double h_2__km, double beta_1__rad,
+    const Atmosphere& atmosphere, SlantPathAttenuationResult* result);
+
+template<typename Atmosphere>
+int SlantPathAttenuation(double f__ghz, double h_1__km, double h_2__km, double beta_1__rad,
+    const Atmosphere& atmosphere, SlantPathAttenuationResult* result);
\ No newline at end of file
@@ -1,4 +1,8 @@
+#ifdef _WIN32
 #define DLLEXPORT extern "C" __declspec(dllexport)
+#else
+#define DLLEXPORT extern "C" __attribute__((visibility("default")))
+#endif
 #define MAX(x, y) (((x) > (y)) ? (x) : (y))
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
 
@@ -31,3 +35,5 @@ double GlobalPressure_Regime1(double h_prime__km);
 double GlobalPressure_Regime2(double h__km);
 double GlobalWaterVapourDensity(double h__km, double rho_0);
 double GlobalWaterVapourPressure(double h__km, double rho_0);
+int GlobalAtmosphereState(double h__km, double* T__kelvin, double* p__hPa, double* e__hPa);
+int GlobalAtmosphereStateBatch(const double* h__km, int n, double* T__kelvin, double* p__hPa, double* e__hPa);
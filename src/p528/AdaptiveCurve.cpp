@@ -0,0 +1,232 @@
+#include <math.h>
+#include "../../include/p528.h"
+
+/*=============================================================================
+ |
+ |  Description:  Samples the midpoint of an interval of an adaptive curve
+ |                and queues the interval, ranked by how far the midpoint
+ |                deviates from linear interpolation between the ends
+ |
+ |        Input:  context       - Path context
+ |                p             - Time percentage
+ |                left          - Index of the left sample
+ |                right         - Index of the right sample
+ |
+ | Input/Output:  d__km         - Sampled distances, in km
+ |                results       - Sampled results
+ |                intervals     - Heap of intervals
+ |
+ |      Returns:  rtn           - SUCCESS or error code
+ |
+ *===========================================================================*/
+int AddCurveInterval(const PathContext* context, double p, int left, int right, vector<double>* d__km,
+    vector<Result>* results, vector<CurveInterval>* intervals)
+{
+    double d_middle__km = ((*d__km)[left] + (*d__km)[right]) / 2;
+
+    Result result;
+    int rtn = P528_Context(context, d_middle__km, p, &result);
+    if (rtn != SUCCESS && rtn != SUCCESS_WITH_WARNINGS)
+        return rtn;
+
+    d__km->push_back(d_middle__km);
+    results->push_back(result);
+
+    CurveInterval interval;
+    interval.left = left;
+    interval.middle = (int)d__km->size() - 1;
+    interval.right = right;
+    interval.deviation__db = fabs(result.A__db - ((*results)[left].A__db + (*results)[right].A__db) / 2);
+
+    intervals->push_back(interval);
+    push_heap(intervals->begin(), intervals->end());
+
+    return SUCCESS;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Generates a loss-vs-distance curve with adaptive sampling.
+ |                Samples are always placed at d_0, d_ML and d_crx, and no
+ |                further apart than CURVE__INITIAL_STEP__KM.  The interval
+ |                whose midpoint deviates most from linear interpolation is
+ |                then halved, until every deviation is within tolerance or
+ |                the samples run out.  Intervals shorter than
+ |                2 * CURVE__MIN_STEP__KM are not halved.  When the samples
+ |                run out first, the curve is still returned, with
+ |                ERROR_CURVE__TOLERANCE
+ |
+ |        Input:  h_1__meter    - Height of the low terminal, in meters
+ |                h_2__meter    - Height of the high terminal, in meters
+ |                f__mhz        - Frequency, in MHz
+ |                T_pol         - Code indicating either polarization
+ |                                  + 0 : POLARIZATION__HORIZONTAL
+ |                                  + 1 : POLARIZATION__VERTICAL
+ |                p             - Time percentage
+ |                d_max__km     - End of the curve, in km
+ |                tolerance__db - Deviation from linear interpolation, in dB
+ |                capacity      - Maximum number of samples
+ |
+ |      Outputs:  d__km         - Sampled distances, in increasing order
+ |                results       - Result at each sampled distance
+ |                count         - Number of samples
+ |
+ |      Returns:  rtn           - SUCCESS, ERROR_CURVE__TOLERANCE or error code
+ |
+ *===========================================================================*/
+int P528_AdaptiveCurve(double h_1__meter, double h_2__meter, double f__mhz, int T_pol, double p,
+    double d_max__km, double tolerance__db, int capacity, double* d__km, Result* results, int* count)
+{
+    *count = 0;
+
+    int warnings = WARNING__NO_WARNINGS;
+    int err = ValidateInputs(d_max__km, h_1__meter, h_2__meter, f__mhz, T_pol, p, &warnings);
+    if (err != SUCCESS && err != ERROR_HEIGHT_AND_DISTANCE)
+        return err;
+
+    PathContext context;
+    InitPathGeometry(h_1__meter, h_2__meter, f__mhz, T_pol, &context);
+    InitPathTranshorizon(&context);
+
+    /////////////////////////////////////////////
+    // Initial samples
+    //
+
+    double breakpoints[5] = { 0, context.path.d_0__km, context.path.d_ML__km, context.d_crx__km, d_max__km };
+    sort(breakpoints, breakpoints + 5);
+
+    vector<double> d_sampled__km;
+    d_sampled__km.push_back(0);
+    for (int i = 1; i < 5; i++)
+    {
+        double d_start__km = d_sampled__km.back();
+        double d_end__km = MIN(breakpoints[i], d_max__km);
+        if (d_end__km <= d_start__km)
+            continue;
+
+        int steps = (int)ceil((d_end__km - d_start__km) / CURVE__INITIAL_STEP__KM);
+        for (int j = 1; j < steps; j++)
+            d_sampled__km.push_back(d_start__km + j * (d_end__km - d_start__km) / steps);
+        d_sampled__km.push_back(d_end__km);
+    }
+
+    // each interval also needs its midpoint sampled
+    if ((int)(2 * d_sampled__km.size() - 1) > capacity)
+        return ERROR_CURVE__CAPACITY;
+
+    vector<Result> sampled(d_sampled__km.size());
+    for (size_t i = 0; i < d_sampled__km.size(); i++)
+    {
+        int rtn = P528_Context(&context, d_sampled__km[i], p, &sampled[i]);
+        if (rtn != SUCCESS && rtn != SUCCESS_WITH_WARNINGS)
+            return rtn;
+    }
+
+    vector<CurveInterval> intervals;
+    int n_initial = (int)d_sampled__km.size();
+    for (int i = 0; i < n_initial - 1; i++)
+    {
+        err = AddCurveInterval(&context, p, i, i + 1, &d_sampled__km, &sampled, &intervals);
+        if (err != SUCCESS)
+            return err;
+    }
+
+    //
+    // Initial samples
+    /////////////////////////////////////////////
+
+    /////////////////////////////////////////////
+    // Refine the worst interval first
+    //
+
+    while (!intervals.empty() && (int)d_sampled__km.size() + 2 <= capacity)
+    {
+        pop_heap(intervals.begin(), intervals.end());
+        CurveInterval interval = intervals.back();
+        intervals.pop_back();
+
+        if (interval.deviation__db <= tolerance__db)
+            break;
+
+        if (d_sampled__km[interval.right] - d_sampled__km[interval.left] < 2 * CURVE__MIN_STEP__KM)
+            continue;
+
+        err = AddCurveInterval(&context, p, interval.left, interval.middle, &d_sampled__km, &sampled, &intervals);
+        if (err != SUCCESS)
+            return err;
+        err = AddCurveInterval(&context, p, interval.middle, interval.right, &d_sampled__km, &sampled, &intervals);
+        if (err != SUCCESS)
+            return err;
+    }
+
+    // samples ran out while an interval that could still be halved is outside of tolerance
+    int rtn = SUCCESS;
+    for (size_t i = 0; i < intervals.size(); i++)
+    {
+        if (intervals[i].deviation__db > tolerance__db &&
+            d_sampled__km[intervals[i].right] - d_sampled__km[intervals[i].left] >= 2 * CURVE__MIN_STEP__KM)
+            rtn = ERROR_CURVE__TOLERANCE;
+    }
+
+    //
+    // Refine the worst interval first
+    /////////////////////////////////////////////
+
+    // return the samples in order of distance
+    vector<int> order(d_sampled__km.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = (int)i;
+    sort(order.begin(), order.end(), [&](int a, int b) { return d_sampled__km[a] < d_sampled__km[b]; });
+
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        d__km[i] = d_sampled__km[order[i]];
+        results[i] = sampled[order[i]];
+    }
+    *count = (int)order.size();
+
+    return rtn;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Resamples a curve onto new distances, such as the legacy
+ |                1 km grid.  Losses and angles are interpolated linearly;
+ |                the mode and warnings are taken from the sample at or
+ |                before each distance.  Distances outside of the curve take
+ |                the nearest end
+ |
+ |        Input:  d__km         - Curve distances, in increasing order
+ |                results       - Curve results
+ |                count         - Number of curve samples
+ |                d_out__km     - New distances, in km
+ |                n_out         - Number of new distances
+ |
+ |      Outputs:  results_out   - Results at the new distances
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void P528_ResampleCurve(const double* d__km, const Result* results, int count,
+    const double* d_out__km, int n_out, Result* results_out)
+{
+    for (int i = 0; i < n_out; i++)
+    {
+        double d__km_i = MIN(MAX(d_out__km[i], d__km[0]), d__km[count - 1]);
+
+        int k = (int)(upper_bound(d__km, d__km + count, d__km_i) - d__km) - 1;
+        k = MIN(MAX(k, 0), MAX(count - 2, 0));
+
+        const Result* lower = &results[k];
+        const Result* upper = &results[MIN(k + 1, count - 1)];
+        double t = (count > 1) ? (d__km_i - d__km[k]) / (d__km[k + 1] - d__km[k]) : 0;
+
+        Result* result = &results_out[i];
+        *result = (t < 1) ? *lower : *upper;
+        result->d__km = d_out__km[i];
+        result->A__db = lower->A__db + t * (upper->A__db - lower->A__db);
+        result->A_fs__db = lower->A_fs__db + t * (upper->A_fs__db - lower->A_fs__db);
+        result->A_a__db = lower->A_a__db + t * (upper->A_a__db - lower->A_a__db);
+        result->theta_h1__rad = lower->theta_h1__rad + t * (upper->theta_h1__rad - lower->theta_h1__rad);
+    }
+}
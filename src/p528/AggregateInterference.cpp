@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <math.h>
+#include "../../include/p528.h"
+
+/*=============================================================================
+ |
+ |  Description:  Lower bound on the free-space loss of a path, from the
+ |                straight line between the terminals over a spherical earth.
+ |                The ray paths of P.528 are never shorter than this line,
+ |                except within a fraction of a dB at the shortest and
+ |                near-horizon distances
+ |
+ |        Input:  d__km         - Path distance, in km
+ |                h_1__meter    - Height of the low terminal, in meters
+ |                h_2__meter    - Height of the high terminal, in meters
+ |                f__mhz        - Frequency, in MHz
+ |
+ |      Returns:  A_fs__db      - Free-space loss bound, in dB
+ |
+ *===========================================================================*/
+double FreeSpaceLossBound(double d__km, double h_1__meter, double h_2__meter, double f__mhz)
+{
+    double r_1__km = a_0__km + h_1__meter / 1000;
+    double r_2__km = a_0__km + h_2__meter / 1000;
+    double s = sin(d__km / (2 * a_0__km));
+    double r__km = sqrt(pow(r_2__km - r_1__km, 2) + 4 * r_1__km * r_2__km * s * s);
+
+    return 20.0 * log10(f__mhz) + 20.0 * log10(r__km) + 32.45;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Aggregate power received at a ground terminal from many
+ |                airborne emitters.  Each emitter is bounded by its EIRP
+ |                less the free-space loss bound of its path, plus a margin
+ |                for paths whose loss falls below free space.  Emitters are
+ |                evaluated strongest bound first, in batches that share the
+ |                path contexts of a trajectory, and the evaluation stops
+ |                once the bounds of the remaining emitters cannot raise the
+ |                total by more than the tolerance
+ |
+ |        Input:  h_1__meter        - Height of the receiving terminal, in
+ |                                    meters
+ |                f__mhz            - Frequency, in MHz
+ |                T_pol             - Code indicating either polarization
+ |                                      + 0 : POLARIZATION__HORIZONTAL
+ |                                      + 1 : POLARIZATION__VERTICAL
+ |                p                 - Time percentage
+ |                d__km             - Path distance of each emitter, in km
+ |                h_2__meter        - Height of each emitter, in meters,
+ |                                    no lower than the receiving terminal
+ |                eirp__dbw         - EIRP of each emitter toward the
+ |                                    receiver, in dBW
+ |                n                 - Number of emitters
+ |                h_quantum__meter  - Emitter heights are rounded to a
+ |                                    multiple of this, so that nearby
+ |                                    emitters share a path context, or 0
+ |                                    to use each height as given
+ |                margin__db        - Largest amount by which the loss of an
+ |                                    emitter may fall below its free-space
+ |                                    bound.  Two-ray gain alone reaches
+ |                                    6 dB, and time percentages below 50
+ |                                    add to it: about 9 dB at p = 1
+ |                tolerance__db     - Largest rise of the total, in dB, that
+ |                                    the emitters left unevaluated may
+ |                                    cause, or 0 to evaluate every emitter
+ |
+ |      Outputs:  result            - Aggregate received power
+ |
+ |      Returns:  rtn               - SUCCESS or error code
+ |
+ *===========================================================================*/
+int P528_AggregateInterference(double h_1__meter, double f__mhz, int T_pol, double p,
+    const double* d__km, const double* h_2__meter, const double* eirp__dbw, int n, double h_quantum__meter,
+    double margin__db, double tolerance__db, Interference* result)
+{
+    result->I__dbw = -INFINITY;
+    result->I_bound__dbw = -INFINITY;
+    result->evaluated = 0;
+    result->warnings = WARNING__NO_WARNINGS;
+
+    /////////////////////////////////////////////
+    // Free-space bound of each emitter
+    //
+
+    vector<double> bound__w(n);
+    for (int i = 0; i < n; i++)
+    {
+        // validate the height as given, then bound the height P528_Trajectory() will use
+        int warnings = WARNING__NO_WARNINGS;
+        int err = ValidateInputs(d__km[i], h_1__meter, h_2__meter[i], f__mhz, T_pol, p, &warnings);
+        if (err != SUCCESS)
+            return err;
+
+        double h__meter = QuantizeHeight(h_1__meter, h_2__meter[i], h_quantum__meter);
+
+        double A_fs__db = FreeSpaceLossBound(d__km[i], h_1__meter, h__meter, f__mhz);
+        bound__w[i] = pow(10, (eirp__dbw[i] - A_fs__db + margin__db) / 10);
+    }
+
+    // strongest bound first, with the bound of all emitters after each one
+    vector<int> order(n);
+    for (int i = 0; i < n; i++)
+        order[i] = i;
+    sort(order.begin(), order.end(), [&bound__w](int a, int b) { return bound__w[a] > bound__w[b]; });
+
+    vector<double> remaining__w(n + 1, 0);
+    for (int k = n - 1; k >= 0; k--)
+        remaining__w[k] = remaining__w[k + 1] + bound__w[order[k]];
+
+    //
+    // Free-space bound of each emitter
+    /////////////////////////////////////////////
+
+    /////////////////////////////////////////////
+    // Evaluate in batches until the rest cannot matter
+    //
+
+    Trajectory trajectory;
+    int err = P528_InitTrajectory(h_1__meter, f__mhz, T_pol, h_quantum__meter, &trajectory);
+    if (err != SUCCESS)
+        return err;
+
+    double I__w = 0;
+    int k = 0;
+    while (k < n)
+    {
+        if (tolerance__db > 0 && I__w > 0 && 10 * log10((I__w + remaining__w[k]) / I__w) <= tolerance__db)
+            break;
+
+        // heights in order within a batch, so that neighbours share path contexts
+        int count = MIN(AGGREGATE__BATCH, n - k);
+        vector<int> batch(order.begin() + k, order.begin() + k + count);
+        sort(batch.begin(), batch.end(), [h_2__meter](int a, int b) { return h_2__meter[a] < h_2__meter[b]; });
+
+        for (int j = 0; j < count; j++)
+        {
+            int i = batch[j];
+
+            Result point;
+            err = P528_Trajectory(&trajectory, d__km[i], h_2__meter[i], p, &point);
+            if (err != SUCCESS && err != SUCCESS_WITH_WARNINGS)
+            {
+                P528_FreeTrajectory(&trajectory);
+                return err;
+            }
+
+            I__w += pow(10, (eirp__dbw[i] - point.A__db) / 10);
+            result->warnings |= point.warnings;
+        }
+
+        k += count;
+    }
+
+    P528_FreeTrajectory(&trajectory);
+
+    //
+    // Evaluate in batches until the rest cannot matter
+    /////////////////////////////////////////////
+
+    result->evaluated = k;
+    result->I__dbw = 10 * log10(I__w);
+    result->I_bound__dbw = 10 * log10(I__w + remaining__w[k]);
+
+    if (result->warnings == WARNING__NO_WARNINGS)
+        return SUCCESS;
+    else
+        return SUCCESS_WITH_WARNINGS;
+}
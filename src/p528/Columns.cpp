@@ -0,0 +1,450 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/p528.h"
+
+/*=============================================================================
+ |
+ |  Description:  Header of a columnar query or result file.  The file holds
+ |                a 32 byte header followed by the columns, each one holding
+ |                a value for every row:
+ |
+ |                   0  char[8]   magic, "P528COLS"
+ |                   8  uint32    format version
+ |                  12  uint32    content, COLUMNS__CONTENT_*
+ |                  16  uint64    number of rows
+ |                  24  uint32    number of double columns
+ |                  28  uint32    number of int32 columns
+ |                  32  double[]  double columns, in order
+ |                      int32[]   int32 columns, in order
+ |
+ |                All values are little-endian, so the columns can be used in
+ |                place on little-endian hosts
+ |
+ |        Input:  content       - COLUMNS__CONTENT_QUERIES or _RESULTS
+ |                n             - Number of rows
+ |                n_doubles     - Number of double columns
+ |                n_ints        - Number of int32 columns
+ |
+ |      Outputs:  header        - COLUMNS__HEADER_SIZE bytes
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void ColumnsHeader(int content, long long n, int n_doubles, int n_ints, unsigned char* header)
+{
+    memcpy(header, COLUMNS__MAGIC, 8);
+    PackU32(header + 8, COLUMNS__FORMAT_VERSION);
+    PackU32(header + 12, content);
+    PackU64(header + 16, n);
+    PackU32(header + 24, n_doubles);
+    PackU32(header + 28, n_ints);
+}
+
+/*=============================================================================
+ |
+ |  Description:  Seeks to a 64-bit offset, for files over 2 GB
+ |
+ |      Returns:  Zero on success
+ |
+ *===========================================================================*/
+int SeekColumns(FILE* fp, long long offset)
+{
+#ifdef _WIN32
+    return _fseeki64(fp, offset, SEEK_SET);
+#else
+    return fseeko(fp, (off_t)offset, SEEK_SET);
+#endif
+}
+
+/*=============================================================================
+ |
+ |  Description:  Opens a columnar file.  The file is mapped read-only and,
+ |                on little-endian hosts, the columns point directly into the
+ |                mapping.  Big-endian hosts decode a private copy
+ |
+ |        Input:  filename      - Path of the file
+ |                content       - Expected content, COLUMNS__CONTENT_*
+ |                n_doubles     - Expected number of double columns
+ |                n_ints        - Expected number of int32 columns
+ |
+ |      Outputs:  n             - Number of rows
+ |                doubles       - Double columns
+ |                ints          - Int32 columns
+ |                storage       - Decoded copy, or NULL
+ |                mapping       - Mapping of the file, or NULL
+ |                mapping_size  - Size of the mapping, in bytes
+ |
+ |      Returns:  rtn           - SUCCESS or error code
+ |
+ *===========================================================================*/
+int OpenColumns(const char* filename, int content, int n_doubles, int n_ints, long long* n,
+    const double** doubles, const int** ints, void** storage, void** mapping, size_t* mapping_size)
+{
+    *n = 0;
+    *storage = NULL;
+    *mapping = NULL;
+    *mapping_size = 0;
+
+    size_t size;
+    unsigned char* bytes = (unsigned char*)MapPack(filename, &size);
+    if (bytes == NULL)
+        return ERROR_PACK__IO;
+
+    if (size < COLUMNS__HEADER_SIZE ||
+        memcmp(bytes, COLUMNS__MAGIC, 8) != 0 ||
+        UnpackU32(bytes + 8) != COLUMNS__FORMAT_VERSION ||
+        UnpackU32(bytes + 12) != (unsigned int)content ||
+        UnpackU32(bytes + 24) != (unsigned int)n_doubles ||
+        UnpackU32(bytes + 28) != (unsigned int)n_ints)
+    {
+        UnmapPack(bytes, size);
+        return ERROR_PACK__FORMAT;
+    }
+
+    unsigned long long rows = UnpackU64(bytes + 16);
+    size_t row_size = 8 * n_doubles + 4 * n_ints;
+    if (rows > (size - COLUMNS__HEADER_SIZE) / row_size || size != COLUMNS__HEADER_SIZE + rows * row_size)
+    {
+        UnmapPack(bytes, size);
+        return ERROR_PACK__FORMAT;
+    }
+
+    const unsigned char* columns = bytes + COLUMNS__HEADER_SIZE;
+    size_t columns_size = rows * row_size;
+
+    unsigned int one = 1;
+    bool little_endian = *(unsigned char*)&one == 1;
+
+    if (!little_endian)
+    {
+        // decode a private copy, in the same layout as the file
+        unsigned char* copy = (unsigned char*)malloc(MAX(columns_size, (size_t)1));
+        if (copy == NULL)
+        {
+            UnmapPack(bytes, size);
+            return ERROR_PACK__IO;
+        }
+
+        size_t double_count = rows * n_doubles;
+        for (size_t i = 0; i < double_count; i++)
+        {
+            unsigned long long value = UnpackU64(columns + 8 * i);
+            memcpy(copy + 8 * i, &value, 8);
+        }
+        for (size_t i = 0; i < rows * n_ints; i++)
+        {
+            unsigned int value = UnpackU32(columns + 8 * double_count + 4 * i);
+            memcpy(copy + 8 * double_count + 4 * i, &value, 4);
+        }
+        UnmapPack(bytes, size);
+
+        columns = copy;
+        *storage = copy;
+    }
+    else
+    {
+        // use the columns in place
+        *mapping = bytes;
+        *mapping_size = size;
+    }
+
+    for (int k = 0; k < n_doubles; k++)
+        doubles[k] = (const double*)columns + k * rows;
+    for (int k = 0; k < n_ints; k++)
+        ints[k] = (const int*)(columns + 8 * n_doubles * rows) + k * rows;
+
+    *n = (long long)rows;
+
+    return SUCCESS;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Writes query columns to a columnar file, as input for a
+ |                bulk job
+ |
+ |        Input:  filename      - Path of the file
+ |                n             - Number of rows
+ |                d__km         - Path distances, in km
+ |                h_1__meter    - Heights of the low terminal, in meters
+ |                h_2__meter    - Heights of the high terminal, in meters
+ |                f__mhz        - Frequencies, in MHz
+ |                T_pol         - Polarizations
+ |                p             - Time percentages
+ |
+ |      Returns:  rtn           - SUCCESS or ERROR_PACK__IO
+ |
+ *===========================================================================*/
+int QueryColumns_Write(const char* filename, long long n, const double* d__km, const double* h_1__meter,
+    const double* h_2__meter, const double* f__mhz, const int* T_pol, const double* p)
+{
+    const double* doubles[COLUMNS__QUERY_DOUBLES] = { d__km, h_1__meter, h_2__meter, f__mhz, p };
+
+    FILE* fp = fopen(filename, "wb");
+    if (fp == NULL)
+        return ERROR_PACK__IO;
+
+    unsigned char header[COLUMNS__HEADER_SIZE];
+    ColumnsHeader(COLUMNS__CONTENT_QUERIES, n, COLUMNS__QUERY_DOUBLES, COLUMNS__QUERY_INTS, header);
+    bool ok = fwrite(header, 1, COLUMNS__HEADER_SIZE, fp) == COLUMNS__HEADER_SIZE;
+
+    vector<unsigned char> bytes(8 * COLUMNS__BLOCK_ROWS);
+
+    for (int k = 0; ok && k < COLUMNS__QUERY_DOUBLES; k++)
+    {
+        for (long long first = 0; ok && first < n; first += COLUMNS__BLOCK_ROWS)
+        {
+            int count = (int)MIN((long long)COLUMNS__BLOCK_ROWS, n - first);
+            for (int i = 0; i < count; i++)
+            {
+                unsigned long long value;
+                memcpy(&value, &doubles[k][first + i], 8);
+                PackU64(&bytes[8 * i], value);
+            }
+
+            ok = fwrite(bytes.data(), 8, count, fp) == (size_t)count;
+        }
+    }
+
+    for (long long first = 0; ok && first < n; first += COLUMNS__BLOCK_ROWS)
+    {
+        int count = (int)MIN((long long)COLUMNS__BLOCK_ROWS, n - first);
+        for (int i = 0; i < count; i++)
+            PackU32(&bytes[4 * i], T_pol[first + i]);
+
+        ok = fwrite(bytes.data(), 4, count, fp) == (size_t)count;
+    }
+
+    if (fclose(fp) != 0 || !ok)
+        return ERROR_PACK__IO;
+
+    return SUCCESS;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Opens a columnar query file
+ |
+ |        Input:  filename      - Path of the file
+ |
+ |      Outputs:  queries       - Query columns, released with
+ |                                QueryColumns_Free()
+ |
+ |      Returns:  rtn           - SUCCESS or error code
+ |
+ *===========================================================================*/
+int QueryColumns_Open(const char* filename, QueryColumns* queries)
+{
+    const double* doubles[COLUMNS__QUERY_DOUBLES] = { NULL };
+    const int* ints[COLUMNS__QUERY_INTS] = { NULL };
+
+    int rtn = OpenColumns(filename, COLUMNS__CONTENT_QUERIES, COLUMNS__QUERY_DOUBLES, COLUMNS__QUERY_INTS,
+        &queries->n, doubles, ints, &queries->storage, &queries->mapping, &queries->mapping_size);
+
+    queries->d__km = doubles[0];
+    queries->h_1__meter = doubles[1];
+    queries->h_2__meter = doubles[2];
+    queries->f__mhz = doubles[3];
+    queries->p = doubles[4];
+    queries->T_pol = ints[0];
+
+    return rtn;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Releases the columns from QueryColumns_Open()
+ |
+ *===========================================================================*/
+void QueryColumns_Free(QueryColumns* queries)
+{
+    if (queries->mapping != NULL)
+        UnmapPack(queries->mapping, queries->mapping_size);
+    free(queries->storage);
+
+    queries->mapping = NULL;
+    queries->storage = NULL;
+    queries->n = 0;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Creates a columnar result file sized for every row.  Rows
+ |                are then written in any order, in blocks, with
+ |                ResultColumns_WriteRows()
+ |
+ |        Input:  filename      - Path of the file
+ |                n             - Number of rows
+ |
+ |      Outputs:  writer        - Open result file
+ |
+ |      Returns:  rtn           - SUCCESS or ERROR_PACK__IO
+ |
+ *===========================================================================*/
+int ResultColumns_Create(const char* filename, long long n, ResultColumnsWriter* writer)
+{
+    writer->n = n;
+    writer->fp = fopen(filename, "wb");
+    if (writer->fp == NULL)
+        return ERROR_PACK__IO;
+
+    unsigned char header[COLUMNS__HEADER_SIZE];
+    ColumnsHeader(COLUMNS__CONTENT_RESULTS, n, COLUMNS__RESULT_DOUBLES, COLUMNS__RESULT_INTS, header);
+    bool ok = fwrite(header, 1, COLUMNS__HEADER_SIZE, writer->fp) == COLUMNS__HEADER_SIZE;
+
+    // extend the file to its full size
+    long long size = COLUMNS__HEADER_SIZE + n * (8 * COLUMNS__RESULT_DOUBLES + 4 * COLUMNS__RESULT_INTS);
+    if (ok && n > 0)
+        ok = SeekColumns(writer->fp, size - 1) == 0 && fputc(0, writer->fp) == 0;
+
+    if (!ok)
+    {
+        fclose(writer->fp);
+        writer->fp = NULL;
+        return ERROR_PACK__IO;
+    }
+
+    return SUCCESS;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Writes a block of consecutive rows to a result file.  Each
+ |                column of the block is encoded and written in one piece.
+ |                Calls on the same writer must not overlap in time
+ |
+ |        Input:  writer        - Open result file
+ |                first         - Index of the first row
+ |                count         - Number of rows
+ |                rtn           - Return code of each row
+ |                results       - Result of each row
+ |
+ |      Returns:  rtn           - SUCCESS or error code
+ |
+ *===========================================================================*/
+int ResultColumns_WriteRows(ResultColumnsWriter* writer, long long first, int count, const int* rtn,
+    const Result* results)
+{
+    if (first < 0 || count < 0 || first + count > writer->n)
+        return ERROR_PACK__FORMAT;
+
+    long long n = writer->n;
+    vector<unsigned char> bytes(8 * (size_t)MIN(count, COLUMNS__BLOCK_ROWS));
+    bool ok = true;
+
+    for (int block = 0; ok && block < count; block += COLUMNS__BLOCK_ROWS)
+    {
+        int m = MIN(COLUMNS__BLOCK_ROWS, count - block);
+        const Result* r = results + block;
+
+        for (int k = 0; ok && k < COLUMNS__RESULT_DOUBLES; k++)
+        {
+            for (int i = 0; i < m; i++)
+            {
+                double x;
+                switch (k)
+                {
+                    case 0: x = r[i].d__km; break;
+                    case 1: x = r[i].A__db; break;
+                    case 2: x = r[i].A_fs__db; break;
+                    case 3: x = r[i].A_a__db; break;
+                    default: x = r[i].theta_h1__rad; break;
+                }
+
+                unsigned long long value;
+                memcpy(&value, &x, 8);
+                PackU64(&bytes[8 * i], value);
+            }
+
+            long long offset = COLUMNS__HEADER_SIZE + 8 * (k * n + first + block);
+            ok = SeekColumns(writer->fp, offset) == 0 && fwrite(bytes.data(), 8, m, writer->fp) == (size_t)m;
+        }
+
+        for (int k = 0; ok && k < COLUMNS__RESULT_INTS; k++)
+        {
+            for (int i = 0; i < m; i++)
+            {
+                int x = (k == 0) ? rtn[block + i] : (k == 1) ? r[i].propagation_mode : r[i].warnings;
+                PackU32(&bytes[4 * i], x);
+            }
+
+            long long offset = COLUMNS__HEADER_SIZE + 8 * COLUMNS__RESULT_DOUBLES * n + 4 * (k * n + first + block);
+            ok = SeekColumns(writer->fp, offset) == 0 && fwrite(bytes.data(), 4, m, writer->fp) == (size_t)m;
+        }
+    }
+
+    if (!ok)
+        return ERROR_PACK__IO;
+
+    return SUCCESS;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Closes a result file from ResultColumns_Create()
+ |
+ |      Returns:  rtn           - SUCCESS or ERROR_PACK__IO
+ |
+ *===========================================================================*/
+int ResultColumns_Close(ResultColumnsWriter* writer)
+{
+    if (writer->fp == NULL)
+        return ERROR_PACK__IO;
+
+    int closed = fclose(writer->fp);
+    writer->fp = NULL;
+
+    if (closed != 0)
+        return ERROR_PACK__IO;
+
+    return SUCCESS;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Opens a columnar result file
+ |
+ |        Input:  filename      - Path of the file
+ |
+ |      Outputs:  results       - Result columns, released with
+ |                                ResultColumns_Free()
+ |
+ |      Returns:  rtn           - SUCCESS or error code
+ |
+ *===========================================================================*/
+int ResultColumns_Open(const char* filename, ResultColumns* results)
+{
+    const double* doubles[COLUMNS__RESULT_DOUBLES] = { NULL };
+    const int* ints[COLUMNS__RESULT_INTS] = { NULL };
+
+    int rtn = OpenColumns(filename, COLUMNS__CONTENT_RESULTS, COLUMNS__RESULT_DOUBLES, COLUMNS__RESULT_INTS,
+        &results->n, doubles, ints, &results->storage, &results->mapping, &results->mapping_size);
+
+    results->d__km = doubles[0];
+    results->A__db = doubles[1];
+    results->A_fs__db = doubles[2];
+    results->A_a__db = doubles[3];
+    results->theta_h1__rad = doubles[4];
+    results->rtn = ints[0];
+    results->propagation_mode = ints[1];
+    results->warnings = ints[2];
+
+    return rtn;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Releases the columns from ResultColumns_Open()
+ |
+ *===========================================================================*/
+void ResultColumns_Free(ResultColumns* results)
+{
+    if (results->mapping != NULL)
+        UnmapPack(results->mapping, results->mapping_size);
+    free(results->storage);
+
+    results->mapping = NULL;
+    results->storage = NULL;
+    results->n = 0;
+}
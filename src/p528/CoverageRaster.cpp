@@ -0,0 +1,263 @@
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "../../include/p528.h"
+
+/*=============================================================================
+ |
+ |  Description:  Great-circle distances from a station to the pixels of a
+ |                tile of a raster grid
+ |
+ |        Input:  lat__deg      - Latitude of the station, in degrees
+ |                lon__deg      - Longitude of the station, in degrees
+ |                grid          - Raster grid
+ |                row_0         - First row of the tile
+ |                col_0         - First column of the tile
+ |                n_rows        - Number of rows in the tile
+ |                n_cols        - Number of columns in the tile
+ |
+ |      Outputs:  d__km         - Distance of each pixel, row-major, in km
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void RasterTileDistances(double lat__deg, double lon__deg, const RasterGrid* grid, int row_0, int col_0,
+    int n_rows, int n_cols, double* d__km)
+{
+    for (int r = 0; r < n_rows; r++)
+    {
+        double lat_pixel__deg = grid->lat_0__deg + (row_0 + r) * grid->delta_lat__deg;
+        for (int c = 0; c < n_cols; c++)
+        {
+            double lon_pixel__deg = grid->lon_0__deg + (col_0 + c) * grid->delta_lon__deg;
+            d__km[r * n_cols + c] = GreatCircleDistance(lat__deg, lon__deg, lat_pixel__deg, lon_pixel__deg);
+        }
+    }
+}
+
+/*=============================================================================
+ |
+ |  Description:  Distance resolution of a raster grid: the smallest spacing
+ |                between neighbouring pixels, which bounds the change in
+ |                distance from the station between them.  Longitude spacing
+ |                is taken at the latitude of the grid nearest a pole, and
+ |                the result is no finer than CURVE__MIN_STEP__KM
+ |
+ |        Input:  grid          - Raster grid
+ |
+ |      Returns:  Distance resolution, in km
+ |
+ *===========================================================================*/
+double RasterResolution(const RasterGrid* grid)
+{
+    const double deg_to_km = PI / 180 * a_0__km;
+
+    double resolution__km = PI * a_0__km;
+    if (grid->n_rows > 1)
+        resolution__km = MIN(resolution__km, fabs(grid->delta_lat__deg) * deg_to_km);
+    if (grid->n_cols > 1)
+    {
+        double lat_end__deg = grid->lat_0__deg + (grid->n_rows - 1) * grid->delta_lat__deg;
+        double lat_max__deg = MIN(MAX(fabs(grid->lat_0__deg), fabs(lat_end__deg)), 90.0);
+        resolution__km = MIN(resolution__km, fabs(grid->delta_lon__deg) * deg_to_km * cos(lat_max__deg * PI / 180));
+    }
+
+    return MAX(resolution__km, CURVE__MIN_STEP__KM);
+}
+
+/*=============================================================================
+ |
+ |  Description:  Computes loss rasters around a ground station for several
+ |                flight levels, and streams them to a file tile by tile.
+ |                Loss depends only on the distance from the station, so one
+ |                adaptive loss-vs-distance curve is built per flight level
+ |                and every pixel is interpolated from it, with enough
+ |                samples to refine down to the pixel spacing.  Only one
+ |                tile is held in memory.  The file holds a header followed
+ |                by the tiles:
+ |
+ |                   0  char[8]   magic, "P528RAST"
+ |                   8  uint32    format version
+ |                  12  uint32    T_pol
+ |                  16  uint32    number of rows
+ |                  20  uint32    number of columns
+ |                  24  uint32    tile size, in pixels
+ |                  28  uint32    number of flight levels
+ |                  32  double    station latitude, in degrees
+ |                  40  double    station longitude, in degrees
+ |                  48  double    h_1__meter
+ |                  56  double    f__mhz
+ |                  64  double    p
+ |                  72  double    lat_0__deg
+ |                  80  double    lon_0__deg
+ |                  88  double    delta_lat__deg
+ |                  96  double    delta_lon__deg
+ |                 104  double    tolerance__db
+ |                 112  double[]  flight levels, h_2__meter
+ |                      float[]   tiles, in row-major order of tiles.  Each
+ |                                tile holds one row-major block of pixels per
+ |                                flight level, clipped at the grid edges
+ |
+ |                All values are little-endian
+ |
+ |        Input:  lat__deg      - Latitude of the station, in degrees
+ |                lon__deg      - Longitude of the station, in degrees
+ |                h_1__meter    - Height of the station, in meters
+ |                h_2__meter    - Flight levels, in meters
+ |                n_levels      - Number of flight levels
+ |                f__mhz        - Frequency, in MHz
+ |                T_pol         - Code indicating either polarization
+ |                                  + 0 : POLARIZATION__HORIZONTAL
+ |                                  + 1 : POLARIZATION__VERTICAL
+ |                p             - Time percentage
+ |                grid          - Raster grid
+ |                tile_size     - Rows and columns in each tile
+ |                tolerance__db - Tolerance of the loss-vs-distance curves
+ |                filename      - Path of the raster file
+ |
+ |      Returns:  rtn           - SUCCESS, ERROR_CURVE__TOLERANCE if a curve
+ |                                ran out of samples before tolerance, with
+ |                                the raster still written, or error code
+ |
+ *===========================================================================*/
+int P528_CoverageRaster(double lat__deg, double lon__deg, double h_1__meter, const double* h_2__meter,
+    int n_levels, double f__mhz, int T_pol, double p, const RasterGrid* grid, int tile_size,
+    double tolerance__db, const char* filename)
+{
+    if (grid->n_rows < 1 || grid->n_cols < 1 || tile_size < 1 || n_levels < 1)
+        return ERROR_RASTER__GRID;
+
+    /////////////////////////////////////////////
+    // One loss-vs-distance curve per flight level
+    //
+
+    double d_max__km = CURVE__MIN_STEP__KM;
+    vector<double> d_row__km(grid->n_cols);
+    for (int r = 0; r < grid->n_rows; r++)
+    {
+        RasterTileDistances(lat__deg, lon__deg, grid, r, 0, 1, grid->n_cols, d_row__km.data());
+        for (int c = 0; c < grid->n_cols; c++)
+            d_max__km = MAX(d_max__km, d_row__km[c]);
+    }
+
+    // enough samples to halve every interval down to the pixel spacing, on top of the initial samples
+    double resolution__km = MIN(RasterResolution(grid), d_max__km);
+    double samples = 2 * ceil(d_max__km / CURVE__INITIAL_STEP__KM) + 8 + 2 * ceil(d_max__km / resolution__km);
+    int capacity = (int)MIN(samples, (double)INT_MAX);
+
+    vector<double> scratch_d__km(capacity);
+    vector<Result> scratch_results(capacity);
+    vector<vector<double>> curve_d__km(n_levels);
+    vector<vector<Result>> curve_results(n_levels);
+    vector<int> curve_count(n_levels);
+
+    // a curve that ran out of samples before reaching tolerance is still used, and reported at the end
+    int rtn = SUCCESS;
+    for (int level = 0; level < n_levels; level++)
+    {
+        int warnings = WARNING__NO_WARNINGS;
+        int err = ValidateInputs(d_max__km, h_1__meter, h_2__meter[level], f__mhz, T_pol, p, &warnings);
+        if (err != SUCCESS && err != ERROR_HEIGHT_AND_DISTANCE)
+            return err;
+
+        err = P528_AdaptiveCurve(h_1__meter, h_2__meter[level], f__mhz, T_pol, p, d_max__km, tolerance__db,
+            capacity, scratch_d__km.data(), scratch_results.data(), &curve_count[level]);
+        if (err == ERROR_CURVE__TOLERANCE)
+            rtn = err;
+        else if (err != SUCCESS)
+            return err;
+
+        curve_d__km[level].assign(scratch_d__km.begin(), scratch_d__km.begin() + curve_count[level]);
+        curve_results[level].assign(scratch_results.begin(), scratch_results.begin() + curve_count[level]);
+    }
+
+    //
+    // One loss-vs-distance curve per flight level
+    /////////////////////////////////////////////
+
+    /////////////////////////////////////////////
+    // Header
+    //
+
+    size_t header_size = RASTER__HEADER_SIZE + 8 * n_levels;
+    vector<unsigned char> header(header_size, 0);
+    memcpy(header.data(), RASTER__MAGIC, 8);
+    PackU32(&header[8], RASTER__FORMAT_VERSION);
+    PackU32(&header[12], T_pol);
+    PackU32(&header[16], grid->n_rows);
+    PackU32(&header[20], grid->n_cols);
+    PackU32(&header[24], tile_size);
+    PackU32(&header[28], n_levels);
+
+    double values[10] = { lat__deg, lon__deg, h_1__meter, f__mhz, p,
+        grid->lat_0__deg, grid->lon_0__deg, grid->delta_lat__deg, grid->delta_lon__deg, tolerance__db };
+    for (int k = 0; k < 10; k++)
+    {
+        unsigned long long value;
+        memcpy(&value, &values[k], 8);
+        PackU64(&header[32 + 8 * k], value);
+    }
+    for (int level = 0; level < n_levels; level++)
+    {
+        unsigned long long value;
+        memcpy(&value, &h_2__meter[level], 8);
+        PackU64(&header[RASTER__HEADER_SIZE + 8 * level], value);
+    }
+
+    FILE* fp = fopen(filename, "wb");
+    if (fp == NULL)
+        return ERROR_PACK__IO;
+
+    bool ok = fwrite(header.data(), 1, header_size, fp) == header_size;
+
+    //
+    // Header
+    /////////////////////////////////////////////
+
+    /////////////////////////////////////////////
+    // Stream the tiles
+    //
+
+    size_t tile_pixels = (size_t)tile_size * tile_size;
+    vector<double> d__km(tile_pixels);
+    vector<Result> results(tile_pixels);
+    vector<unsigned char> bytes(4 * tile_pixels);
+
+    for (int row_0 = 0; ok && row_0 < grid->n_rows; row_0 += tile_size)
+    {
+        int n_rows = MIN(tile_size, grid->n_rows - row_0);
+        for (int col_0 = 0; ok && col_0 < grid->n_cols; col_0 += tile_size)
+        {
+            int n_cols = MIN(tile_size, grid->n_cols - col_0);
+            int n = n_rows * n_cols;
+
+            RasterTileDistances(lat__deg, lon__deg, grid, row_0, col_0, n_rows, n_cols, d__km.data());
+
+            for (int level = 0; ok && level < n_levels; level++)
+            {
+                P528_ResampleCurve(curve_d__km[level].data(), curve_results[level].data(), curve_count[level],
+                    d__km.data(), n, results.data());
+
+                for (int i = 0; i < n; i++)
+                {
+                    float A__db = (float)results[i].A__db;
+                    unsigned int value;
+                    memcpy(&value, &A__db, 4);
+                    PackU32(&bytes[4 * i], value);
+                }
+
+                ok = fwrite(bytes.data(), 4, n, fp) == (size_t)n;
+            }
+        }
+    }
+
+    //
+    // Stream the tiles
+    /////////////////////////////////////////////
+
+    if (fclose(fp) != 0 || !ok)
+        return ERROR_PACK__IO;
+
+    return rtn;
+}
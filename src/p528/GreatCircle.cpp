@@ -0,0 +1,187 @@
+#include <math.h>
+#include <string.h>
+#include "../../include/p528.h"
+
+/*=============================================================================
+ |
+ |  Description:  Great-circle distance between two points on a sphere of
+ |                radius a_0__km, the same earth radius as the model, using
+ |                the haversine formula
+ |
+ |        Input:  lat_1__deg    - Latitude of the first point, in degrees
+ |                lon_1__deg    - Longitude of the first point, in degrees
+ |                lat_2__deg    - Latitude of the second point, in degrees
+ |                lon_2__deg    - Longitude of the second point, in degrees
+ |
+ |      Returns:  d__km         - Great-circle distance, in km
+ |
+ *===========================================================================*/
+double GreatCircleDistance(double lat_1__deg, double lon_1__deg, double lat_2__deg, double lon_2__deg)
+{
+    double d__km;
+    GreatCircleDistanceBatch(lat_1__deg, lon_1__deg, &lat_2__deg, &lon_2__deg, 1, &d__km);
+
+    return d__km;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Square of the sine, from a polynomial with no branches or
+ |                calls.  The square has a period of pi, so the argument is
+ |                reduced to [-pi/2, pi/2], where the Taylor series of the
+ |                sine to x^21 is accurate to double precision
+ |
+ |        Input:  x             - Angle, in radians
+ |
+ |      Returns:  sin^2(x)
+ |
+ *===========================================================================*/
+static inline double SinSquared(double x)
+{
+    // nearest multiple of pi, rounded by the addition of 1.5 * 2^52
+    const double round_magic = 6755399441055744.0;
+    double k = (x * (1 / PI) + round_magic) - round_magic;
+
+    // pi in two parts, so that the reduction is exact for the k of any angle
+    double y = (x - k * 3.14159265358979311600e+00) - k * 1.22464679914735317720e-16;
+    double y2 = y * y;
+
+    double s = y * (1 + y2 * (-1.0 / 6 + y2 * (1.0 / 120 + y2 * (-1.0 / 5040 + y2 * (1.0 / 362880
+        + y2 * (-1.0 / 39916800 + y2 * (1.0 / 6227020800 + y2 * (-1.0 / 1307674368000
+        + y2 * (1.0 / 355687428096000 + y2 * (-1.0 / 121645100408832000
+        + y2 * (1.0 / 51090942171709440000.0)))))))))));
+
+    return s * s;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Arcsine on [0, 1], from a polynomial with no branches or
+ |                calls.  The rational approximation of fdlibm on [0, 0.5]
+ |                is used for the argument itself, or for asin(sqrt((1-x)/2))
+ |                above 0.5
+ |
+ |        Input:  x             - Sine, in [0, 1]
+ |
+ |      Returns:  asin(x), in radians
+ |
+ *===========================================================================*/
+static inline double ArcSin(double x)
+{
+    bool upper = (x > 0.5);
+    double z = upper ? sqrt(fabs(1 - x) / 2) : x;
+
+    double t = z * z;
+    double p = t * (1.66666666666666657415e-01 + t * (-3.25565818622400915405e-01 + t * (2.01212532134862925881e-01
+        + t * (-4.00555345006794114027e-02 + t * (7.91534994289814532176e-04 + t * 3.47933107596021167570e-05)))));
+    double q = 1 + t * (-2.40339491173441421878e+00 + t * (2.02094576023350569471e+00
+        + t * (-6.88283971605453293030e-01 + t * 7.70381505559019352791e-02)));
+    double a = z + z * (p / q);
+
+    // asin(x) = pi/2 - 2 asin(sqrt((1-x)/2)), with pi/2 in two parts
+    return upper ? 1.57079632679489655800e+00 - (2 * a - 6.12323399573676603587e-17) : a;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Batch form of GreatCircleDistance(), from one point to
+ |                many.  The terms of the first point are hoisted out of
+ |                the loop.  Distances are computed in blocks, with loops
+ |                free of branches and calls so that the compiler can
+ |                vectorize them: the sines and arcsine are polynomials, and
+ |                cos(lat_1) cos(lat_2) is taken from the squared sines of
+ |                the half difference and half sum of the latitudes
+ |
+ |        Input:  lat_1__deg    - Latitude of the first point, in degrees
+ |                lon_1__deg    - Longitude of the first point, in degrees
+ |                lat_2__deg    - Array of latitudes, in degrees
+ |                lon_2__deg    - Array of longitudes, in degrees
+ |                n             - Number of elements
+ |
+ |      Outputs:  d__km         - Array of great-circle distances, in km
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void GreatCircleDistanceBatch(double lat_1__deg, double lon_1__deg, const double* lat_2__deg,
+    const double* lon_2__deg, int n, double* d__km)
+{
+    const double half_deg_to_rad = PI / 360;
+
+    double lat_1__rad = lat_1__deg * half_deg_to_rad;
+    double lon_1__rad = lon_1__deg * half_deg_to_rad;
+
+    double d_block__km[GEODESIC__CHUNK];
+    for (int i_0 = 0; i_0 < n; i_0 += GEODESIC__CHUNK)
+    {
+        int count = MIN(GEODESIC__CHUNK, n - i_0);
+        const double* lat = lat_2__deg + i_0;
+        const double* lon = lon_2__deg + i_0;
+
+        // cos(a) cos(b) = 1 - sin^2((a - b)/2) - sin^2((a + b)/2)
+        for (int j = 0; j < count; j++)
+        {
+            double lat_2__rad = lat[j] * half_deg_to_rad;
+            double sin2_dlat = SinSquared(lat_2__rad - lat_1__rad);
+            double sin2_slat = SinSquared(lat_2__rad + lat_1__rad);
+            double sin2_dlon = SinSquared(lon[j] * half_deg_to_rad - lon_1__rad);
+
+            // h is in [0, 1] but for rounding.  Its magnitude is taken rather than
+            // clamping it, which the compiler would split into branches
+            double h = fabs(sin2_dlat + (1 - sin2_dlat - sin2_slat) * sin2_dlon);
+
+            d_block__km[j] = 2 * a_0__km * ArcSin(sqrt(h));
+        }
+
+        // written in blocks, as the output could alias the positions
+        memcpy(&d__km[i_0], d_block__km, count * sizeof(double));
+    }
+}
+
+/*=============================================================================
+ |
+ |  Description:  Computes P.528 results from a ground station to many
+ |                positions, on a path context.  Distances are computed in
+ |                chunks of GEODESIC__CHUNK positions on the stack and
+ |                consumed at once, so the caller needs no distance buffer.
+ |                All positions share the heights, frequency and polarization
+ |                of the context, so positions at other altitudes need a
+ |                context of their own (one per h_2)
+ |
+ |        Input:  context       - Path context, from P528_InitPathContext()
+ |                lat__deg      - Latitude of the station, in degrees
+ |                lon__deg      - Longitude of the station, in degrees
+ |                lat_2__deg    - Array of latitudes, in degrees
+ |                lon_2__deg    - Array of longitudes, in degrees
+ |                n             - Number of positions
+ |                p             - Time percentage
+ |
+ |      Outputs:  results       - Array of results
+ |
+ |      Returns:  rtn           - SUCCESS, SUCCESS_WITH_WARNINGS if any
+ |                                result has warnings, or error code
+ |
+ *===========================================================================*/
+int P528_ContextPositions(const PathContext* context, double lat__deg, double lon__deg,
+    const double* lat_2__deg, const double* lon_2__deg, int n, double p, Result* results)
+{
+    int rtn = SUCCESS;
+
+    double d__km[GEODESIC__CHUNK];
+    for (int start = 0; start < n; start += GEODESIC__CHUNK)
+    {
+        int count = MIN(GEODESIC__CHUNK, n - start);
+        GreatCircleDistanceBatch(lat__deg, lon__deg, lat_2__deg + start, lon_2__deg + start, count, d__km);
+
+        for (int i = 0; i < count; i++)
+        {
+            int err = P528_Context(context, d__km[i], p, &results[start + i]);
+            if (err == SUCCESS_WITH_WARNINGS)
+                rtn = SUCCESS_WITH_WARNINGS;
+            else if (err != SUCCESS)
+                return err;
+        }
+    }
+
+    return rtn;
+}
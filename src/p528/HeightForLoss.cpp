@@ -0,0 +1,240 @@
+#include <math.h>
+#include "../../include/p528.h"
+
+/*=============================================================================
+ |
+ |  Description:  Loss at the search distance for a high terminal whose
+ |                geometry is already known.  Only the terms that depend on
+ |                both terminals are recomputed
+ |
+ |        Input:  search        - Height search, with the low terminal
+ |                h_2__meter    - Height of the high terminal, in meters
+ |                terminal_2    - Geometry of the high terminal
+ |
+ |      Outputs:  context       - Path context of the high terminal
+ |
+ |      Returns:  A__db         - Loss, in dB
+ |
+ *===========================================================================*/
+double HeightLossWithTerminal(const HeightLoss* search, double h_2__meter, const Terminal* terminal_2,
+    PathContext* context)
+{
+    *context = search->base;
+    context->h_2__meter = h_2__meter;
+    context->terminal_2 = *terminal_2;
+    InitPathLine(context);
+
+    if (context->path.d_ML__km - search->d__km <= 0.001)
+        InitPathTranshorizon(context);
+
+    double A__db;
+    EvaluatePathLosses(context, search->d__km, &search->p, 1, &A__db);
+
+    return A__db;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Loss at the search distance for a high terminal height
+ |
+ |        Input:  h_2__meter    - Height of the high terminal, in meters
+ |
+ |      Returns:  A__db         - Loss, in dB
+ |
+ *===========================================================================*/
+double HeightLoss::operator()(double h_2__meter) const
+{
+    Terminal terminal_2;
+    terminal_2.h_r__km = h_2__meter / 1000;
+    TerminalGeometry(base.f__mhz, &terminal_2);
+
+    PathContext context;
+    return HeightLossWithTerminal(this, h_2__meter, &terminal_2, &context);
+}
+
+/*=============================================================================
+ |
+ |  Description:  Finds the lowest height in an interval of the two-ray
+ |                region that meets a loss threshold.  Two-ray lobes make
+ |                the loss non-monotone in height, so while the free-space
+ |                bound less INVERSE__LOBE_MARGIN__DB does not rule out the
+ |                threshold, the interval is halved, lower half first, if it
+ |                is wider than half a lobe or its midpoint is not between
+ |                its ends, up to a depth and while the shared budget of
+ |                samples lasts.  Dips narrower than the final subintervals
+ |                can be missed
+ |
+ |        Input:  loss          - Height search
+ |                L__db         - Loss threshold, in dB
+ |                h_a__meter    - Lower end, where the loss exceeds L__db
+ |                A_a__db       - Loss at the lower end, in dB
+ |                h_b__meter    - Upper end
+ |                A_b__db       - Loss at the upper end, in dB
+ |                lobe__meter   - Half of the two-ray lobe period in height
+ |                depth         - Remaining halvings
+ |
+ | Input/Output:  budget        - Remaining samples
+ |
+ |      Outputs:  h_2__meter    - Lowest height found that meets L__db
+ |
+ |      Returns:  True if a height was found
+ |
+ *===========================================================================*/
+bool FindLowestHeightCrossing(const HeightLoss& loss, double L__db, double h_a__meter, double A_a__db,
+    double h_b__meter, double A_b__db, double lobe__meter, int depth, int* budget, double* h_2__meter)
+{
+    // free-space loss grows with height, so the bound at the lower end holds over the interval
+    double A_bound__db = FreeSpaceLossBound(loss.d__km, loss.base.h_1__meter, h_a__meter, loss.base.f__mhz)
+        - INVERSE__LOBE_MARGIN__DB;
+
+    if (depth > 0 && *budget > 0 && h_b__meter - h_a__meter > 2 * INVERSE__TOLERANCE__METER && A_bound__db <= L__db)
+    {
+        double h_m__meter = (h_a__meter + h_b__meter) / 2;
+        double A_m__db = loss(h_m__meter);
+        (*budget)--;
+
+        bool monotone = A_m__db >= MIN(A_a__db, A_b__db) && A_m__db <= MAX(A_a__db, A_b__db);
+        if (A_m__db <= L__db || !monotone || h_b__meter - h_a__meter > lobe__meter)
+        {
+            if (A_m__db <= L__db)
+                return FindLowestHeightCrossing(loss, L__db, h_a__meter, A_a__db, h_m__meter, A_m__db,
+                    lobe__meter, depth - 1, budget, h_2__meter);
+
+            return FindLowestHeightCrossing(loss, L__db, h_a__meter, A_a__db, h_m__meter, A_m__db,
+                    lobe__meter, depth - 1, budget, h_2__meter)
+                || FindLowestHeightCrossing(loss, L__db, h_m__meter, A_m__db, h_b__meter, A_b__db,
+                    lobe__meter, depth - 1, budget, h_2__meter);
+        }
+    }
+
+    if (A_b__db > L__db)
+        return false;
+
+    *h_2__meter = FindLossCrossing(loss, L__db, h_a__meter, A_a__db, h_b__meter, A_b__db, INVERSE__TOLERANCE__METER);
+    return true;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Computes the minimum height of the high terminal for which
+ |                the loss at a distance does not exceed a threshold.  The
+ |                low terminal geometry is computed once.  The high terminal
+ |                is probed at INVERSE__HEIGHT_NODES heights, log-spaced from
+ |                h_1 to the largest valid height.  Where the path is within
+ |                d_0, two-ray lobes make the loss non-monotone in height,
+ |                and the interval below each node is searched for lobes by
+ |                FindLowestHeightCrossing(); elsewhere the lowest node that
+ |                meets the threshold is refined against the node below it.
+ |                The result is the first crossing on the refined grid
+ |
+ |        Input:  h_1__meter    - Height of the low terminal, in meters
+ |                d__km         - Path distance, in km
+ |                f__mhz        - Frequency, in MHz
+ |                T_pol         - Code indicating either polarization
+ |                                  + 0 : POLARIZATION__HORIZONTAL
+ |                                  + 1 : POLARIZATION__VERTICAL
+ |                p             - Time percentage
+ |                L__db         - Loss threshold, in dB
+ |
+ |      Outputs:  h_2__meter    - Minimum height of the high terminal, in meters
+ |                warnings      - Warning flags for the solution
+ |
+ |      Returns:  rtn           - SUCCESS, SUCCESS_WITH_WARNINGS or error code
+ |
+ *===========================================================================*/
+int P528_HeightForLoss(double h_1__meter, double d__km, double f__mhz, int T_pol, double p,
+    double L__db, double* h_2__meter, int* warnings)
+{
+    const double h_max__meter = 80000;
+
+    *h_2__meter = 0;
+    *warnings = WARNING__NO_WARNINGS;
+
+    int err = ValidateInputs(d__km, h_1__meter, h_max__meter, f__mhz, T_pol, p, warnings);
+    if (err != SUCCESS && err != ERROR_HEIGHT_AND_DISTANCE)
+        return err;
+
+    HeightLoss loss;
+    loss.d__km = d__km;
+    loss.p = p;
+
+    PathContext* base = &loss.base;
+    base->h_1__meter = h_1__meter;
+    base->f__mhz = f__mhz;
+    base->T_pol = T_pol;
+    base->transhorizon = false;
+    base->warnings = WARNING__NO_WARNINGS;
+
+    base->terminal_1.h_r__km = h_1__meter / 1000;
+    TerminalGeometry(f__mhz, &base->terminal_1);
+
+    /////////////////////////////////////////////
+    // Scan the height nodes
+    //
+
+    // half a lobe of the two-ray model, in height, at the search distance
+    double lobe__meter = (299.792458 / f__mhz) * (d__km * 1000) / (4 * h_1__meter);
+    int budget = INVERSE__LOBE_SAMPLES;
+
+    double h_prev__meter = h_1__meter;
+    double A_prev__db = 0;
+    PathContext context;
+    bool found = false;
+
+    for (int i = 0; i < INVERSE__HEIGHT_NODES && !found; i++)
+    {
+        double h__meter = (i == INVERSE__HEIGHT_NODES - 1) ? h_max__meter
+            : h_1__meter * pow(h_max__meter / h_1__meter, (double)i / (INVERSE__HEIGHT_NODES - 1));
+
+        Terminal terminal_2;
+        terminal_2.h_r__km = h__meter / 1000;
+        TerminalGeometry(f__mhz, &terminal_2);
+
+        double A__db = HeightLossWithTerminal(&loss, h__meter, &terminal_2, &context);
+
+        if (i == 0)
+        {
+            if (A__db <= L__db)
+            {
+                *h_2__meter = h__meter;
+                found = true;
+            }
+        }
+        else if (d__km < context.path.d_0__km)
+            found = FindLowestHeightCrossing(loss, L__db, h_prev__meter, A_prev__db, h__meter, A__db,
+                lobe__meter, INVERSE__LOBE_DEPTH, &budget, h_2__meter);
+        else if (A__db <= L__db)
+        {
+            *h_2__meter = FindLossCrossing(loss, L__db, h_prev__meter, A_prev__db, h__meter, A__db,
+                INVERSE__TOLERANCE__METER);
+            found = true;
+        }
+
+        h_prev__meter = h__meter;
+        A_prev__db = A__db;
+    }
+
+    //
+    // Scan the height nodes
+    /////////////////////////////////////////////
+
+    // warnings for the solution, not the top of the search
+    *warnings = WARNING__NO_WARNINGS;
+    if (!found)
+        return ERROR_INVERSE__NO_SOLUTION;
+
+    ValidateInputs(d__km, h_1__meter, *h_2__meter, f__mhz, T_pol, p, warnings);
+
+    // the crossover search of the transhorizon path also flags the solution
+    Terminal terminal_2;
+    terminal_2.h_r__km = *h_2__meter / 1000;
+    TerminalGeometry(f__mhz, &terminal_2);
+    HeightLossWithTerminal(&loss, *h_2__meter, &terminal_2, &context);
+    if (context.transhorizon)
+        *warnings |= context.warnings;
+
+    if (*warnings != WARNING__NO_WARNINGS)
+        return SUCCESS_WITH_WARNINGS;
+
+    return SUCCESS;
+}
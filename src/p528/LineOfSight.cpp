@@ -33,6 +33,86 @@ double FindPsiAtDistance(double d__km, Path *path, Terminal *terminal_1, Termina
     return psi;
 }
 
+/*=============================================================================
+ |
+ |  Description:  Finds the grazing angle psi of the ray for a path
+ |                distance, starting from a nearby psi, such as that of the
+ |                previous sample of a trajectory.  The distance is
+ |                bracketed by steps that double away from psi_start, then
+ |                bisected to the tolerance of FindPsiAtDistance()
+ |
+ |        Input:  d__km         - Path distance, in km
+ |                psi_start     - Nearby grazing angle, in rad
+ |                terminal_1    - Struct containing low terminal parameters
+ |                terminal_2    - Struct containing high terminal parameters
+ |
+ |      Returns:  psi           - Grazing angle, in rad
+ |
+ *===========================================================================*/
+double FindPsiNearDistance(double d__km, double psi_start, Terminal *terminal_1, Terminal *terminal_2)
+{
+    if (d__km == 0)
+        return PI / 2;
+
+    LineOfSightParams params_temp;
+    RayOptics(terminal_1, terminal_2, psi_start, &params_temp);
+    if (abs(d__km - params_temp.d__km) <= 1e-3)
+        return psi_start;
+
+    // distance decreases as psi increases
+    double direction = (params_temp.d__km > d__km) ? 1 : -1;
+    double psi_near = psi_start;
+    double psi_far = psi_start;
+    double step = TRAJECTORY__PSI_STEP;
+
+    /////////////////////////////////////////////
+    // Bracket the distance
+    //
+
+    while (true)
+    {
+        psi_far = psi_near + direction * step;
+        if (psi_far >= PI / 2 || psi_far <= 0)
+        {
+            psi_far = (direction > 0) ? PI / 2 : 0;
+            break;
+        }
+
+        RayOptics(terminal_1, terminal_2, psi_far, &params_temp);
+        if (abs(d__km - params_temp.d__km) <= 1e-3)
+            return psi_far;
+        if ((params_temp.d__km > d__km) != (direction > 0))
+            break;
+
+        psi_near = psi_far;
+        step *= 2;
+    }
+
+    //
+    // Bracket the distance
+    /////////////////////////////////////////////
+
+    double psi_low = MIN(psi_near, psi_far);
+    double psi_high = MAX(psi_near, psi_far);
+    double psi = (psi_low + psi_high) / 2;
+
+    while (psi_high - psi_low > 1e-12)
+    {
+        psi = (psi_low + psi_high) / 2;
+        RayOptics(terminal_1, terminal_2, psi, &params_temp);
+
+        if (abs(d__km - params_temp.d__km) <= 1e-3)
+            break;
+
+        if (params_temp.d__km > d__km)
+            psi_low = psi;
+        else
+            psi_high = psi;
+    }
+
+    return psi;
+}
+
 double FindPsiAtDeltaR(double delta_r__km, Path *path, Terminal *terminal_1, Terminal *terminal_2, double terminate)
 {
     double psi = PI / 2;
@@ -79,32 +159,30 @@ double FindDistanceAtDeltaR(double delta_r__km, Path *path, Terminal *terminal_1
 
 /*=============================================================================
  |
- |  Description:  This function computes the total loss in the line-of-sight
- |                region as described in Annex 2, Section 6 of
- |                Recommendation ITU-R P.528-5, "Propagation curves for
- |                aeronautical mobile and radionavigation services using
- |                the VHF, UHF and SHF bands"
+ |  Description:  This function computes the distance-independent terms of
+ |                the line-of-sight region as described in Annex 2,
+ |                Section 6 of Recommendation ITU-R P.528-5, "Propagation
+ |                curves for aeronautical mobile and radionavigation
+ |                services using the VHF, UHF and SHF bands"
  |
  |        Input:  path          - Struct containing path parameters
  |                terminal_1    - Struct containing low terminal parameters
  |                terminal_2    - Struct containing high terminal parameters
  |                f__mhz        - Frequency, in MHz
  |                A_dML__db     - Diffraction loss at d_ML, in dB
- |                p             - Time percentage
- |                d__km         - Path length, in km
  |                T_pol         - Code indicating either polarization
  |                                  + 0 : POLARIZATION__HORIZONTAL
  |                                  + 1 : POLARIZATION__VERTICAL
  |
- |      Outputs:  los_params    - Struct containing LOS parameters
- |                result        - Struct containing P.528 results
- |                K_LOS         - K-value
+ |      Outputs:  path          - d_0__km is set
+ |                psi_limit     - Angular limit separating FS and 2-Ray, in rad
+ |                A_d_0__db     - Loss at d_0, in dB
  |
  |      Returns:  [void]
  |
  *===========================================================================*/
-void LineOfSight(Path *path, Terminal *terminal_1, Terminal *terminal_2, LineOfSightParams *los_params, 
-    double f__mhz, double A_dML__db, double p, double d__km, int T_pol, Result *result, double *K_LOS)
+void LineOfSightInit(Path *path, Terminal *terminal_1, Terminal *terminal_2, double f__mhz, 
+    double A_dML__db, int T_pol, double *psi_limit, double *A_d_0__db)
 {
     double psi;
     double R_Tg;
@@ -115,7 +193,7 @@ void LineOfSight(Path *path, Terminal *terminal_1, Terminal *terminal_2, LineOfS
 
     // determine psi_limit, where you switch from free space to 2-ray model
     // lambda / 2 is the start of the lobe closest to d_ML
-    double psi_limit = FindPsiAtDeltaR(lambda__km / 2, path, terminal_1, terminal_2, terminate);
+    *psi_limit = FindPsiAtDeltaR(lambda__km / 2, path, terminal_1, terminal_2, terminate);
 
     // "[d_y6__km] is the largest distance at which a free-space value is obtained in a two-ray model
     //   of reflection from a smooth earth with a reflection coefficient of -1" [ES-83-3, page 44]
@@ -179,29 +257,111 @@ void LineOfSight(Path *path, Terminal *terminal_1, Terminal *terminal_2, LineOfS
 
     double psi_d0 = FindPsiAtDistance(path->d_0__km, path, terminal_1, terminal_2);
 
-    RayOptics(terminal_1, terminal_2, psi_d0, los_params);
+    LineOfSightParams los_params;
+    RayOptics(terminal_1, terminal_2, psi_d0, &los_params);
+
+    GetPathLoss(psi_d0, path, f__mhz, *psi_limit, A_dML__db, 0, T_pol, &los_params, &R_Tg);
 
-    GetPathLoss(psi_d0, path, f__mhz, psi_limit, A_dML__db, 0, T_pol, los_params, &R_Tg);
+    *A_d_0__db = los_params.A_LOS__db;
 
     //
     // Compute loss at d_0__km
     /////////////////////////////////////////////
+}
 
+/*=============================================================================
+ |
+ |  Description:  This function computes the distance-dependent terms of the
+ |                line-of-sight loss as described in Annex 2, Section 6 of
+ |                Recommendation ITU-R P.528-5, "Propagation curves for
+ |                aeronautical mobile and radionavigation services using
+ |                the VHF, UHF and SHF bands".  Terms that depend on the
+ |                time percentage are left to PathPointResult().  See
+ |                LineOfSightPsiPoint()
+ |
+ |        Input:  path          - Struct containing path parameters
+ |                terminal_1    - Struct containing low terminal parameters
+ |                terminal_2    - Struct containing high terminal parameters
+ |                f__mhz        - Frequency, in MHz
+ |                A_dML__db     - Diffraction loss at d_ML, in dB
+ |                psi_limit     - Angular limit separating FS and 2-Ray, in rad
+ |                A_d_0__db     - Loss at d_0, in dB
+ |                d__km         - Path length, in km
+ |                T_pol         - Code indicating either polarization
+ |                                  + 0 : POLARIZATION__HORIZONTAL
+ |                                  + 1 : POLARIZATION__VERTICAL
+ |
+ |      Outputs:  los_params    - Struct containing LOS parameters
+ |                point         - Distance-dependent terms of the result
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void LineOfSightPoint(Path *path, Terminal *terminal_1, Terminal *terminal_2, LineOfSightParams *los_params, 
+    double f__mhz, double A_dML__db, double psi_limit, double A_d_0__db, double d__km, int T_pol, PathPoint *point)
+{
     // tune psi for the desired distance
-    psi = FindPsiAtDistance(d__km, path, terminal_1, terminal_2);
+    double psi = FindPsiAtDistance(d__km, path, terminal_1, terminal_2);
+
+    LineOfSightPsiPoint(path, terminal_1, terminal_2, los_params, f__mhz, A_dML__db, psi_limit, A_d_0__db, d__km,
+        psi, T_pol, NULL, point);
+}
+
+/*=============================================================================
+ |
+ |  Description:  Computes the distance-dependent terms of the line-of-sight
+ |                loss for the grazing angle psi already found for the path
+ |                distance.  The ray trace layers between the terminals can
+ |                be given, to trace the slant path without recomputing them
+ |
+ |        Input:  path          - Struct containing path parameters
+ |                terminal_1    - Struct containing low terminal parameters
+ |                terminal_2    - Struct containing high terminal parameters
+ |                f__mhz        - Frequency, in MHz
+ |                A_dML__db     - Diffraction loss at d_ML, in dB
+ |                psi_limit     - Angular limit separating FS and 2-Ray, in rad
+ |                A_d_0__db     - Loss at d_0, in dB
+ |                d__km         - Path length, in km
+ |                psi           - Grazing angle of the ray for d__km, in rad
+ |                T_pol         - Code indicating either polarization
+ |                                  + 0 : POLARIZATION__HORIZONTAL
+ |                                  + 1 : POLARIZATION__VERTICAL
+ |                layers        - Ray trace layers from terminal_1 to
+ |                                terminal_2, or NULL
+ |
+ |      Outputs:  los_params    - Struct containing LOS parameters
+ |                point         - Distance-dependent terms of the result
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void LineOfSightPsiPoint(Path *path, Terminal *terminal_1, Terminal *terminal_2, LineOfSightParams *los_params,
+    double f__mhz, double A_dML__db, double psi_limit, double A_d_0__db, double d__km, double psi, int T_pol,
+    const RayLayers *layers, PathPoint *point)
+{
+    double R_Tg;
+
+    // 0.2997925 = speed of light, gigameters per sec
+    double lambda__km = 0.2997925 / f__mhz;                             // [Eqn 6-1]
 
     RayOptics(terminal_1, terminal_2, psi, los_params);
 
-    GetPathLoss(psi, path, f__mhz, psi_limit, A_dML__db, los_params->A_LOS__db, T_pol, los_params, &R_Tg);
+    GetPathLoss(psi, path, f__mhz, psi_limit, A_dML__db, A_d_0__db, T_pol, los_params, &R_Tg);
 
     /////////////////////////////////////////////
     // Compute atmospheric absorption
     //
 
+    // the layers only serve rays that rise from the low terminal; a ray
+    // that dips below it is traced from its lowest point
     SlantPathAttenuationResult result_slant;
-    SlantPathAttenuation(f__mhz / 1000, terminal_1->h_r__km, terminal_2->h_r__km, PI / 2 - los_params->theta_h1__rad, &result_slant);
+    double beta_1__rad = PI / 2 - los_params->theta_h1__rad;
+    if (layers != NULL && beta_1__rad <= PI / 2)
+        TraceRayLayers(layers, beta_1__rad, &result_slant);
+    else
+        SlantPathAttenuation(f__mhz / 1000, terminal_1->h_r__km, terminal_2->h_r__km, beta_1__rad, &result_slant);
 
-    result->A_a__db = result_slant.A_gas__db;
+    point->A_a__db = result_slant.A_gas__db;
 
     //
     // Compute atmospheric absorption
@@ -211,7 +371,7 @@ void LineOfSight(Path *path, Terminal *terminal_1, Terminal *terminal_2, LineOfS
     // Compute free-space loss
     //
 
-    result->A_fs__db = 20.0 * log10(los_params->r_0__km) + 20.0 * log10(f__mhz) + 32.45; // [Eqn 6-4]
+    point->A_fs__db = 20.0 * log10(los_params->r_0__km) + 20.0 * log10(f__mhz) + 32.45; // [Eqn 6-4]
 
     //
     // Compute free-space loss
@@ -230,8 +390,7 @@ void LineOfSight(Path *path, Terminal *terminal_1, Terminal *terminal_2, LineOfS
     else
         f_theta_h = MAX(0.5 - (1 / PI) * (atan(20.0 * log10(32.0 * los_params->theta_h1__rad))), 0);
 
-    double Y_e__db, Y_e_50__db, A_Y;
-    LongTermVariability(terminal_1->d_r__km, terminal_2->d_r__km, d__km, f__mhz, p, f_theta_h, los_params->A_LOS__db, &Y_e__db, &A_Y);
+    double Y_e_50__db, A_Y;
     LongTermVariability(terminal_1->d_r__km, terminal_2->d_r__km, d__km, f__mhz, 50, f_theta_h, los_params->A_LOS__db, &Y_e_50__db, &A_Y);
 
     // [Eqn 13-2]
@@ -262,26 +421,67 @@ void LineOfSight(Path *path, Terminal *terminal_1, Terminal *terminal_2, LineOfS
     double W = W_R + W_a;                       // [Eqn 13-8]
 
     // [Eqn 13-9]
+    double K_LOS;
     if (W <= 0.0)
-        *K_LOS = -40.0;
+        K_LOS = -40.0;
     else
     {
-        *K_LOS = 10.0 * log10(W);
+        K_LOS = 10.0 * log10(W);
 
-    if (*K_LOS < -40.0)
-        *K_LOS = -40.0;
+    if (K_LOS < -40.0)
+        K_LOS = -40.0;
     }
 
-    double Y_pi_50__db = 0.0;   //  zero mean
-    double Y_pi__db = NakagamiRice(*K_LOS, p);
-
-    double Y_total__db = -CombineDistributions(Y_e_50__db, Y_e__db, Y_pi_50__db, Y_pi__db, p);
-
     //
     // Compute variability
     /////////////////////////////////////////////
 
-    result->d__km = los_params->d__km;
-    result->A__db = result->A_fs__db + result->A_a__db - los_params->A_LOS__db + Y_total__db;
-    result->theta_h1__rad = los_params->theta_h1__rad;
+    point->propagation_mode = PROP_MODE__LOS;
+    point->d__km = d__km;
+    point->d_result__km = los_params->d__km;
+    point->A_T__db = -los_params->A_LOS__db;
+    point->f_theta_h = f_theta_h;
+    point->K__db = K_LOS;
+    point->Y_e_50__db = Y_e_50__db;
+    point->theta_h1__rad = los_params->theta_h1__rad;
+}
+
+/*=============================================================================
+ |
+ |  Description:  This function computes the total loss in the line-of-sight
+ |                region as described in Annex 2, Section 6 of
+ |                Recommendation ITU-R P.528-5, "Propagation curves for
+ |                aeronautical mobile and radionavigation services using
+ |                the VHF, UHF and SHF bands"
+ |
+ |        Input:  path          - Struct containing path parameters
+ |                terminal_1    - Struct containing low terminal parameters
+ |                terminal_2    - Struct containing high terminal parameters
+ |                f__mhz        - Frequency, in MHz
+ |                A_dML__db     - Diffraction loss at d_ML, in dB
+ |                p             - Time percentage
+ |                d__km         - Path length, in km
+ |                T_pol         - Code indicating either polarization
+ |                                  + 0 : POLARIZATION__HORIZONTAL
+ |                                  + 1 : POLARIZATION__VERTICAL
+ |
+ |      Outputs:  los_params    - Struct containing LOS parameters
+ |                result        - Struct containing P.528 results
+ |                K_LOS         - K-value
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void LineOfSight(Path *path, Terminal *terminal_1, Terminal *terminal_2, LineOfSightParams *los_params, 
+    double f__mhz, double A_dML__db, double p, double d__km, int T_pol, Result *result, double *K_LOS)
+{
+    double psi_limit, A_d_0__db;
+    LineOfSightInit(path, terminal_1, terminal_2, f__mhz, A_dML__db, T_pol, &psi_limit, &A_d_0__db);
+
+    PathPoint point;
+    LineOfSightPoint(path, terminal_1, terminal_2, los_params, f__mhz, A_dML__db, psi_limit, A_d_0__db, d__km, T_pol, &point);
+
+    PathPointResult(terminal_1, terminal_2, f__mhz, &point, p, result);
+
+    *K_LOS = point.K__db;
 }
\ No newline at end of file
@@ -0,0 +1,414 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unordered_map>
+#include "../../include/p528.h"
+
+/*=============================================================================
+ |
+ |  Description:  Height of the high terminal along a contour grid.  Rows are
+ |                log-spaced, and fractional rows are interpolated in log
+ |                height
+ |
+ |        Input:  grid          - Contour grid
+ |                y             - Row, possibly fractional
+ |
+ |      Returns:  h_2__meter    - Height of the high terminal, in meters
+ |
+ *===========================================================================*/
+double ContourGridHeight(const ContourGrid* grid, double y)
+{
+    if (y >= grid->n_h)
+        return grid->h_2_max__meter;
+
+    return grid->h_2_min__meter * pow(grid->h_2_max__meter / grid->h_2_min__meter, y / grid->n_h);
+}
+
+/*=============================================================================
+ |
+ |  Description:  Loss at a node of a contour grid.  Each node is evaluated
+ |                once, and each row builds its path context once from the
+ |                shared low terminal geometry
+ |
+ |        Input:  grid          - Contour grid
+ |                i             - Column of the node
+ |                j             - Row of the node
+ |
+ |      Returns:  A__db         - Loss, in dB
+ |
+ *===========================================================================*/
+double ContourGridLoss(ContourGrid* grid, int i, int j)
+{
+    double* A__db = &grid->A__db[(size_t)j * (grid->n_d + 1) + i];
+    if (!isnan(*A__db))
+        return *A__db;
+
+    PathContext* context = &grid->rows[j];
+    if (!grid->row_set[j])
+    {
+        double h_2__meter = ContourGridHeight(grid, j);
+
+        *context = grid->base;
+        context->h_2__meter = h_2__meter;
+        context->terminal_2.h_r__km = h_2__meter / 1000;
+        TerminalGeometry(context->f__mhz, &context->terminal_2);
+        InitPathLine(context);
+        InitPathTranshorizon(context);
+
+        grid->row_set[j] = true;
+    }
+
+    double d__km = grid->d_max__km * i / grid->n_d;
+    EvaluatePathLosses(context, d__km, &grid->p, 1, A__db);
+    grid->evaluations++;
+
+    return *A__db;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Marching squares on a single cell of the finest grid.  The
+ |                corners are numbered counter-clockwise from (i, j), and
+ |                edge k runs from corner k to corner k + 1.  Saddle cells
+ |                are resolved with the mean of the corners
+ |
+ |        Input:  grid          - Contour grid
+ |                i             - Column of the lower left corner
+ |                j             - Row of the lower left corner
+ |                L__db         - Loss levels, in dB
+ |                n_levels      - Number of loss levels
+ |
+ | Input/Output:  segments      - Contour segments
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void ContourCellSegments(ContourGrid* grid, int i, int j, const double* L__db, int n_levels,
+    vector<ContourSegment>* segments)
+{
+    const int corner_i[4] = { i, i + 1, i + 1, i };
+    const int corner_j[4] = { j, j, j + 1, j + 1 };
+
+    double A__db[4];
+    for (int k = 0; k < 4; k++)
+        A__db[k] = ContourGridLoss(grid, corner_i[k], corner_j[k]);
+
+    // edges are keyed on their lower left node, so neighboring cells agree
+    long long stride = grid->n_d + 1;
+    long long edge_ids[4] = {
+        2 * (j * stride + i),                   // bottom
+        2 * (j * stride + i + 1) + 1,           // right
+        2 * ((j + 1) * stride + i),             // top
+        2 * (j * stride + i) + 1 };             // left
+
+    for (int level = 0; level < n_levels; level++)
+    {
+        bool below[4];
+        for (int k = 0; k < 4; k++)
+            below[k] = A__db[k] <= L__db[level];
+
+        int crossed[4];
+        double x[4], y[4];
+        int n_crossed = 0;
+        for (int k = 0; k < 4; k++)
+        {
+            int m = (k + 1) % 4;
+            if (below[k] == below[m])
+                continue;
+
+            double t = (L__db[level] - A__db[k]) / (A__db[m] - A__db[k]);
+            x[k] = corner_i[k] + t * (corner_i[m] - corner_i[k]);
+            y[k] = corner_j[k] + t * (corner_j[m] - corner_j[k]);
+            crossed[n_crossed++] = k;
+        }
+
+        int pairs[2][2];
+        int n_pairs = 0;
+        if (n_crossed == 2)
+        {
+            pairs[0][0] = crossed[0];
+            pairs[0][1] = crossed[1];
+            n_pairs = 1;
+        }
+        else if (n_crossed == 4)
+        {
+            double A_mean__db = (A__db[0] + A__db[1] + A__db[2] + A__db[3]) / 4;
+            bool center_below = A_mean__db <= L__db[level];
+
+            if (center_below == below[0])
+            {
+                // corner 0 joins the center, so cut off corners 1 and 3
+                pairs[0][0] = 0; pairs[0][1] = 1;
+                pairs[1][0] = 2; pairs[1][1] = 3;
+            }
+            else
+            {
+                // cut off corners 0 and 2
+                pairs[0][0] = 3; pairs[0][1] = 0;
+                pairs[1][0] = 1; pairs[1][1] = 2;
+            }
+            n_pairs = 2;
+        }
+
+        for (int n = 0; n < n_pairs; n++)
+        {
+            ContourSegment segment;
+            segment.level = level;
+            for (int e = 0; e < 2; e++)
+            {
+                int k = pairs[n][e];
+                segment.edge[e] = edge_ids[k];
+                segment.x[e] = x[k];
+                segment.y[e] = y[k];
+            }
+            segments->push_back(segment);
+        }
+    }
+}
+
+/*=============================================================================
+ |
+ |  Description:  Quadtree refinement of a cell of the contour grid.  Cells
+ |                whose corners all fall on the same side of every level are
+ |                dropped; the rest are quartered down to the finest grid
+ |
+ |        Input:  grid          - Contour grid
+ |                i             - Column of the lower left corner
+ |                j             - Row of the lower left corner
+ |                size          - Width of the cell, in finest cells
+ |                L__db         - Loss levels, in dB
+ |                n_levels      - Number of loss levels
+ |
+ | Input/Output:  segments      - Contour segments
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void RefineContourCell(ContourGrid* grid, int i, int j, int size, const double* L__db, int n_levels,
+    vector<ContourSegment>* segments)
+{
+    double A_00__db = ContourGridLoss(grid, i, j);
+    double A_10__db = ContourGridLoss(grid, i + size, j);
+    double A_01__db = ContourGridLoss(grid, i, j + size);
+    double A_11__db = ContourGridLoss(grid, i + size, j + size);
+
+    double A_min__db = MIN(MIN(A_00__db, A_10__db), MIN(A_01__db, A_11__db));
+    double A_max__db = MAX(MAX(A_00__db, A_10__db), MAX(A_01__db, A_11__db));
+
+    bool straddled = false;
+    for (int level = 0; level < n_levels; level++)
+    {
+        if (A_min__db <= L__db[level] && A_max__db > L__db[level])
+            straddled = true;
+    }
+
+    if (!straddled)
+        return;
+
+    if (size == 1)
+    {
+        ContourCellSegments(grid, i, j, L__db, n_levels, segments);
+        return;
+    }
+
+    int half = size / 2;
+    RefineContourCell(grid, i, j, half, L__db, n_levels, segments);
+    RefineContourCell(grid, i + half, j, half, L__db, n_levels, segments);
+    RefineContourCell(grid, i, j + half, half, L__db, n_levels, segments);
+    RefineContourCell(grid, i + half, j + half, half, L__db, n_levels, segments);
+}
+
+/*=============================================================================
+ |
+ |  Description:  Extracts contours of constant loss over distance and high
+ |                terminal height, for a fixed low terminal.  A coarse grid
+ |                of CONTOUR__CELLS_D by CONTOUR__CELLS_H cells is refined,
+ |                quadtree-style, only where a level passes through a cell,
+ |                down to CONTOUR__DEPTH halvings.  Contours are traced with
+ |                marching squares on the finest cells and joined into
+ |                polylines.  Features smaller than a coarse cell, that do
+ |                not cross any coarse cell corner values, may be missed
+ |
+ |        Input:  h_1__meter        - Height of the low terminal, in meters
+ |                f__mhz            - Frequency, in MHz
+ |                T_pol             - Code indicating either polarization
+ |                                      + 0 : POLARIZATION__HORIZONTAL
+ |                                      + 1 : POLARIZATION__VERTICAL
+ |                p                 - Time percentage
+ |                L__db             - Loss levels, in dB
+ |                n_levels          - Number of loss levels
+ |                d_max__km         - End of the distance axis, in km
+ |                h_2_min__meter    - Start of the height axis, in meters
+ |                h_2_max__meter    - End of the height axis, in meters
+ |
+ |      Outputs:  contours          - Polylines, released with
+ |                                    P528_FreeLossContours()
+ |
+ |      Returns:  rtn               - SUCCESS or error code
+ |
+ *===========================================================================*/
+int P528_LossContours(double h_1__meter, double f__mhz, int T_pol, double p, const double* L__db,
+    int n_levels, double d_max__km, double h_2_min__meter, double h_2_max__meter, LossContours* contours)
+{
+    memset(contours, 0, sizeof(LossContours));
+
+    int warnings = WARNING__NO_WARNINGS;
+    int err = ValidateInputs(d_max__km, h_1__meter, h_2_min__meter, f__mhz, T_pol, p, &warnings);
+    if (err == SUCCESS || err == ERROR_HEIGHT_AND_DISTANCE)
+        err = ValidateInputs(d_max__km, h_1__meter, h_2_max__meter, f__mhz, T_pol, p, &warnings);
+    if (err != SUCCESS && err != ERROR_HEIGHT_AND_DISTANCE)
+        return err;
+    if (h_2_max__meter <= h_2_min__meter)
+        return ERROR_VALIDATION__H_2;
+
+    /////////////////////////////////////////////
+    // Refine the grid near the contours
+    //
+
+    ContourGrid grid;
+    grid.p = p;
+    grid.d_max__km = d_max__km;
+    grid.h_2_min__meter = h_2_min__meter;
+    grid.h_2_max__meter = h_2_max__meter;
+    grid.n_d = CONTOUR__CELLS_D << CONTOUR__DEPTH;
+    grid.n_h = CONTOUR__CELLS_H << CONTOUR__DEPTH;
+    grid.A__db.assign((size_t)(grid.n_d + 1) * (grid.n_h + 1), NAN);
+    grid.rows.resize(grid.n_h + 1);
+    grid.row_set.assign(grid.n_h + 1, false);
+    grid.evaluations = 0;
+
+    grid.base.h_1__meter = h_1__meter;
+    grid.base.f__mhz = f__mhz;
+    grid.base.T_pol = T_pol;
+    grid.base.transhorizon = false;
+    grid.base.warnings = WARNING__NO_WARNINGS;
+    grid.base.terminal_1.h_r__km = h_1__meter / 1000;
+    TerminalGeometry(f__mhz, &grid.base.terminal_1);
+
+    vector<ContourSegment> segments;
+    int size = 1 << CONTOUR__DEPTH;
+    for (int j = 0; j < grid.n_h; j += size)
+    {
+        for (int i = 0; i < grid.n_d; i += size)
+            RefineContourCell(&grid, i, j, size, L__db, n_levels, &segments);
+    }
+
+    //
+    // Refine the grid near the contours
+    /////////////////////////////////////////////
+
+    /////////////////////////////////////////////
+    // Join the segments into polylines
+    //
+
+    // each edge holds at most two segments of a level
+    unordered_map<long long, vector<int>> edges;
+    for (int s = 0; s < (int)segments.size(); s++)
+    {
+        for (int e = 0; e < 2; e++)
+            edges[segments[s].edge[e] * n_levels + segments[s].level].push_back(s);
+    }
+
+    vector<bool> used(segments.size(), false);
+    vector<int> line_level, line_start;
+    vector<double> x, y;
+
+    // open polylines start at an edge with a single segment, then whatever
+    // is left forms closed loops
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (int s = 0; s < (int)segments.size(); s++)
+        {
+            if (used[s])
+                continue;
+
+            const ContourSegment* segment = &segments[s];
+            int start = -1;
+            for (int e = 0; e < 2; e++)
+            {
+                if (pass == 1 || edges[segment->edge[e] * n_levels + segment->level].size() == 1)
+                    start = e;
+            }
+            if (start < 0)
+                continue;
+
+            line_level.push_back(segment->level);
+            line_start.push_back((int)x.size());
+            x.push_back(segment->x[start]);
+            y.push_back(segment->y[start]);
+
+            int current = s;
+            int end = 1 - start;
+            while (current >= 0)
+            {
+                used[current] = true;
+                x.push_back(segments[current].x[end]);
+                y.push_back(segments[current].y[end]);
+
+                long long key = segments[current].edge[end] * n_levels + segments[current].level;
+                int next = -1;
+                for (int candidate : edges[key])
+                {
+                    if (!used[candidate])
+                        next = candidate;
+                }
+
+                if (next >= 0)
+                    end = (segments[next].edge[0] == segments[current].edge[end]) ? 1 : 0;
+                current = next;
+            }
+        }
+    }
+
+    //
+    // Join the segments into polylines
+    /////////////////////////////////////////////
+
+    int line_count = (int)line_level.size();
+    int point_count = (int)x.size();
+
+    size_t size_ints = sizeof(int) * (2 * line_count + 1);
+    size_ints = (size_ints + sizeof(double) - 1) / sizeof(double) * sizeof(double);
+    unsigned char* storage = (unsigned char*)malloc(size_ints + sizeof(double) * 2 * point_count);
+    if (storage == NULL)
+        return ERROR_CONTOUR__ALLOCATION;
+
+    contours->storage = storage;
+    contours->line_count = line_count;
+    contours->point_count = point_count;
+    contours->line_level = (int*)storage;
+    contours->line_start = contours->line_level + line_count;
+    contours->d__km = (double*)(storage + size_ints);
+    contours->h_2__meter = contours->d__km + point_count;
+    contours->evaluations = grid.evaluations;
+
+    for (int k = 0; k < line_count; k++)
+    {
+        contours->line_level[k] = line_level[k];
+        contours->line_start[k] = line_start[k];
+    }
+    contours->line_start[line_count] = point_count;
+
+    for (int k = 0; k < point_count; k++)
+    {
+        contours->d__km[k] = d_max__km * x[k] / grid.n_d;
+        contours->h_2__meter[k] = ContourGridHeight(&grid, y[k]);
+    }
+
+    return SUCCESS;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Releases the polylines of P528_LossContours()
+ |
+ | Input/Output:  contours      - Contours
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void P528_FreeLossContours(LossContours* contours)
+{
+    free(contours->storage);
+    memset(contours, 0, sizeof(LossContours));
+}
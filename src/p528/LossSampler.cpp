@@ -0,0 +1,158 @@
+#include <math.h>
+#include <string.h>
+#include "../../include/p528.h"
+
+/*=============================================================================
+ |
+ |  Description:  Counter-based random numbers.  Each value is the SplitMix64
+ |                output for one counter of a keyed stream, so any sample of
+ |                the stream can be drawn without drawing the ones before it
+ |
+ |        Input:  key           - Key of the stream
+ |                counter       - Position in the stream
+ |
+ |      Returns:  64 random bits
+ |
+ *===========================================================================*/
+static inline unsigned long long CounterRandom(unsigned long long key, unsigned long long counter)
+{
+    unsigned long long z = key + (counter + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/*=============================================================================
+ |
+ |  Description:  Prepares random loss samples for a path.  The path context
+ |                and the distance-dependent terms are computed once, then
+ |                the loss is evaluated on an even grid of time percentages,
+ |                which samples the inverse CDF of the combined long-term and
+ |                Nakagami-Rice distributions of the total loss
+ |
+ |        Input:  d__km         - Path distance, in km
+ |                h_1__meter    - Height of the low terminal, in meters
+ |                h_2__meter    - Height of the high terminal, in meters
+ |                f__mhz        - Frequency, in MHz
+ |                T_pol         - Code indicating either polarization
+ |                                  + 0 : POLARIZATION__HORIZONTAL
+ |                                  + 1 : POLARIZATION__VERTICAL
+ |
+ |      Outputs:  sampler       - Loss sampler
+ |
+ |      Returns:  rtn           - SUCCESS or error code
+ |
+ *===========================================================================*/
+int P528_InitLossSampler(double d__km, double h_1__meter, double h_2__meter, double f__mhz, int T_pol,
+    LossSampler* sampler)
+{
+    sampler->d__km = d__km;
+    sampler->propagation_mode = PROP_MODE__NOT_SET;
+    sampler->warnings = WARNING__NO_WARNINGS;
+    sampler->step = (SAMPLER__P_MAX - SAMPLER__P_MIN) / (SAMPLER__NODES - 1);
+    for (int k = 0; k < SAMPLER__NODES - 1; k++)
+    {
+        sampler->A__db[k][0] = 0;
+        sampler->A__db[k][1] = 0;
+    }
+
+    int err = ValidateInputs(d__km, h_1__meter, h_2__meter, f__mhz, T_pol, 50, &sampler->warnings);
+    if (err != SUCCESS)
+    {
+        if (err == ERROR_HEIGHT_AND_DISTANCE)
+            return SUCCESS;
+        else
+            return err;
+    }
+
+    PathContext context;
+    err = P528_InitPathContext(h_1__meter, h_2__meter, f__mhz, T_pol, &context);
+    if (err != SUCCESS)
+        return err;
+
+    PathPoint point;
+    LineOfSightParams los_params;
+    TroposcatterParams tropo;
+    PathContextPoint(&context, d__km, &point, &los_params, &tropo);
+
+    sampler->propagation_mode = point.propagation_mode;
+    if (point.propagation_mode != PROP_MODE__LOS)
+        sampler->warnings |= context.warnings;
+
+    // the variability steps at p = 10, so each interval ends just below its upper node
+    for (int k = 0; k < SAMPLER__NODES - 1; k++)
+    {
+        double p_lower = SAMPLER__P_MIN + k * sampler->step;
+        double p_upper = nextafter(SAMPLER__P_MIN + (k + 1) * sampler->step, 0.0);
+
+        Result result;
+        PathPointResult(&context.terminal_1, &context.terminal_2, f__mhz, &point, p_lower, &result);
+        sampler->A__db[k][0] = result.A__db;
+        PathPointResult(&context.terminal_1, &context.terminal_2, f__mhz, &point, p_upper, &result);
+        sampler->A__db[k][1] = result.A__db;
+    }
+
+    if (sampler->warnings == WARNING__NO_WARNINGS)
+        return SUCCESS;
+    else
+        return SUCCESS_WITH_WARNINGS;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Draws random loss samples of a path.  Sample i takes the
+ |                time percentage 100 u_i, for a uniform u_i from the
+ |                counter-based stream of the seed at counter i, and
+ |                interpolates the loss of the sampler at it.  A sample
+ |                depends only on the seed and its index, so the stream is
+ |                reproducible however it is split across calls or threads.
+ |                Percentages outside of [1, 99], where P.528 is not defined,
+ |                take the loss at the nearest end.  Samples are drawn in
+ |                blocks, with loops free of branches and calls so that the
+ |                compiler can vectorize them
+ |
+ |        Input:  sampler       - Loss sampler, from P528_InitLossSampler()
+ |                seed          - Seed of the stream
+ |                first         - Index of the first sample in the stream
+ |                n             - Number of samples
+ |
+ |      Outputs:  A__db         - Samples of the loss, in dB
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void P528_SampleLoss(const LossSampler* sampler, unsigned long long seed, long long first, int n,
+    double* A__db)
+{
+    // streams of nearby seeds must not be shifted copies of each other
+    unsigned long long key = CounterRandom(seed, 0);
+
+    double scale = 100 / sampler->step;
+    double offset = SAMPLER__P_MIN / sampler->step;
+
+    double t[SAMPLER__BLOCK];
+    double A_block__db[SAMPLER__BLOCK];
+    for (int i_0 = 0; i_0 < n; i_0 += SAMPLER__BLOCK)
+    {
+        int count = MIN(SAMPLER__BLOCK, n - i_0);
+        unsigned long long counter = (unsigned long long)(first + i_0);
+
+        // fractional node of each sample, from 53 random bits
+        for (int j = 0; j < count; j++)
+        {
+            double u = (double)(long long)(CounterRandom(key, counter + j) >> 11) * (1.0 / 9007199254740992.0);
+            t[j] = MIN(MAX(u * scale - offset, 0.0), SAMPLER__NODES - 1.0);
+        }
+
+        // interpolated into the block, as the output could alias the sampler.  The
+        // node index is as wide as a double, so the lookups can be gathered
+        for (int j = 0; j < count; j++)
+        {
+            long long k = MIN((long long)t[j], SAMPLER__NODES - 2);
+            double w = t[j] - k;
+            A_block__db[j] = sampler->A__db[k][0] + w * (sampler->A__db[k][1] - sampler->A__db[k][0]);
+        }
+
+        memcpy(&A__db[i_0], A_block__db, count * sizeof(double));
+    }
+}
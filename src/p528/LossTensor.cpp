@@ -0,0 +1,574 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "../../include/p528.h"
+
+/*=============================================================================
+ |
+ |  Description:  Computes the loss for a set of time percentages at a single
+ |                distance of a path context.  The distance-dependent terms
+ |                are computed once and shared by all of the percentages
+ |
+ |        Input:  context       - Path context
+ |                d__km         - Path distance, in km
+ |                p             - Array of time percentages
+ |                n_p           - Number of time percentages
+ |
+ |      Outputs:  A__db         - Array of losses, in dB
+ |
+ |      Returns:  rtn           - SUCCESS or error code
+ |
+ *===========================================================================*/
+int EvaluatePathLosses(const PathContext* context, double d__km, const double* p, int n_p, double* A__db)
+{
+    PathPoint point;
+    LineOfSightParams los_params;
+    TroposcatterParams tropo;
+    bool point_set = false;
+
+    for (int j = 0; j < n_p; j++)
+    {
+        int warnings = WARNING__NO_WARNINGS;
+        int err = ValidateInputs(d__km, context->h_1__meter, context->h_2__meter, context->f__mhz,
+            context->T_pol, p[j], &warnings);
+        if (err == ERROR_HEIGHT_AND_DISTANCE)
+        {
+            A__db[j] = 0;
+            continue;
+        }
+        else if (err != SUCCESS)
+            return err;
+
+        if (!point_set)
+        {
+            PathContextPoint(context, d__km, &point, &los_params, &tropo);
+            point_set = true;
+        }
+
+        Result result;
+        PathPointResult(&context->terminal_1, &context->terminal_2, context->f__mhz, &point, p[j], &result);
+        A__db[j] = result.A__db;
+    }
+
+    return SUCCESS;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Finds the cell of a tensor axis containing x, and the
+ |                weight of the upper node of the cell
+ |
+ |        Input:  tensor        - Loss tensor
+ |                axis          - Axis index
+ |                x             - Coordinate along the axis
+ |
+ |      Outputs:  i             - Index of the lower node of the cell
+ |                w             - Weight of the upper node, [0, 1]
+ |
+ |      Returns:  true if x is within the axis, else false
+ |
+ *===========================================================================*/
+bool LocateTensorCell(const LossTensor* tensor, int axis, double x, int* i, double* w)
+{
+    const double* nodes = tensor->axes[axis];
+    int n = tensor->n[axis];
+
+    if (!(x >= nodes[0] && x <= nodes[n - 1]))
+        return false;
+
+    int k;
+    if (tensor->step[axis] > 0)
+        k = (int)((x - nodes[0]) / tensor->step[axis]);
+    else
+        k = (int)(upper_bound(nodes, nodes + n, x) - nodes) - 1;
+    k = MIN(MAX(k, 0), n - 2);
+
+    *i = k;
+    *w = MIN(MAX((x - nodes[k]) / (nodes[k + 1] - nodes[k]), 0.0), 1.0);
+
+    return true;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Multilinear interpolation of the loss within a tensor cell,
+ |                over the 32 corners of the cell
+ |
+ |        Input:  tensor        - Loss tensor
+ |                i             - Index of the lower node on each axis
+ |                w             - Weight of the upper node on each axis
+ |
+ |      Returns:  A__db         - Interpolated loss, in dB
+ |
+ *===========================================================================*/
+double InterpolateTensorCell(const LossTensor* tensor, const int* i, const double* w)
+{
+    size_t stride[LOSS_TENSOR__AXIS_COUNT];
+    stride[LOSS_TENSOR__AXIS_COUNT - 1] = 1;
+    for (int k = LOSS_TENSOR__AXIS_COUNT - 2; k >= 0; k--)
+        stride[k] = stride[k + 1] * tensor->n[k + 1];
+
+    size_t base = 0;
+    for (int k = 0; k < LOSS_TENSOR__AXIS_COUNT; k++)
+        base += i[k] * stride[k];
+
+    // gather the corners, with the fastest axis in the lowest bit
+    double A__db[1 << LOSS_TENSOR__AXIS_COUNT];
+    size_t offset[1 << LOSS_TENSOR__AXIS_COUNT];
+    offset[0] = base;
+    int count = 1;
+    for (int k = LOSS_TENSOR__AXIS_COUNT - 1; k >= 0; k--)
+    {
+        for (int c = 0; c < count; c++)
+            offset[count + c] = offset[c] + stride[k];
+        count *= 2;
+    }
+    for (int c = 0; c < count; c++)
+        A__db[c] = tensor->A__db[offset[c]];
+
+    // collapse one axis at a time, fastest first.  A node without a loss
+    // (NaN) is skipped in favor of its neighbor along the axis
+    for (int k = LOSS_TENSOR__AXIS_COUNT - 1; k >= 0; k--)
+    {
+        count /= 2;
+        for (int c = 0; c < count; c++)
+        {
+            double A_lower__db = A__db[2 * c];
+            double A_upper__db = A__db[2 * c + 1];
+            if (isnan(A_lower__db))
+                A__db[c] = A_upper__db;
+            else if (isnan(A_upper__db))
+                A__db[c] = A_lower__db;
+            else
+                A__db[c] = A_lower__db + w[k] * (A_upper__db - A_lower__db);
+        }
+    }
+
+    return A__db[0];
+}
+
+/*=============================================================================
+ |
+ |  Description:  Returns the flat index of a cell of the tensor
+ |
+ |        Input:  tensor        - Loss tensor
+ |                i             - Index of the lower node on each axis
+ |
+ |      Returns:  Cell index
+ |
+ *===========================================================================*/
+size_t TensorCellIndex(const LossTensor* tensor, const int* i)
+{
+    size_t index = 0;
+    for (int k = 0; k < LOSS_TENSOR__AXIS_COUNT; k++)
+        index = index * (tensor->n[k] - 1) + i[k];
+
+    return index;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Returns the node spacing of a uniform tensor axis.  A
+ |                uniform axis locates its cell without a search
+ |
+ |        Input:  nodes         - Node coordinates
+ |                n             - Number of nodes
+ |
+ |      Returns:  step          - Node spacing, or 0 if the axis is not uniform
+ |
+ *===========================================================================*/
+double TensorAxisStep(const double* nodes, int n)
+{
+    double step = (nodes[n - 1] - nodes[0]) / (n - 1);
+    for (int j = 1; j < n - 1; j++)
+    {
+        if (fabs(nodes[j] - (nodes[0] + j * step)) > 1e-9 * (nodes[n - 1] - nodes[0]))
+            return 0;
+    }
+
+    return step;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Coordinate of a half node of a tensor axis.  Even half
+ |                nodes are the nodes, and odd ones are half way between
+ |
+ |        Input:  nodes         - Nodes of the axis
+ |                half          - Index of the half node, < 2 n - 1
+ |
+ |      Returns:  Coordinate of the half node
+ |
+ *===========================================================================*/
+static double HalfNode(const double* nodes, int half)
+{
+    if (half % 2 == 0)
+        return nodes[half / 2];
+    else
+        return (nodes[half / 2] + nodes[half / 2 + 1]) / 2;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Compares the directly evaluated loss at a half node with
+ |                the interpolation of every cell that holds it, and raises
+ |                the sampled error of those cells.  Along each axis, a
+ |                midpoint lies in one cell and a node in the cells on
+ |                either side of it.  The nodes themselves are skipped, as
+ |                the interpolation is exact there
+ |
+ |        Input:  tensor        - Loss tensor
+ |                half          - Half node index on each axis
+ |                A__db         - Loss at the half node, in dB
+ |
+ |      Outputs:  error__db     - Largest sampled error of each cell, in dB
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+static void SampleCellErrors(const LossTensor* tensor, const int* half, double A__db, float* error__db)
+{
+    int cells[LOSS_TENSOR__AXIS_COUNT][2];
+    double weights[LOSS_TENSOR__AXIS_COUNT][2];
+    int count[LOSS_TENSOR__AXIS_COUNT];
+    bool node = true;
+
+    for (int k = 0; k < LOSS_TENSOR__AXIS_COUNT; k++)
+    {
+        int j = half[k] / 2;
+        count[k] = 0;
+        if (half[k] % 2 == 1)
+        {
+            cells[k][count[k]] = j;
+            weights[k][count[k]++] = 0.5;
+            node = false;
+        }
+        else
+        {
+            if (j > 0)
+            {
+                cells[k][count[k]] = j - 1;
+                weights[k][count[k]++] = 1;
+            }
+            if (j < tensor->n[k] - 1)
+            {
+                cells[k][count[k]] = j;
+                weights[k][count[k]++] = 0;
+            }
+        }
+    }
+
+    if (node)
+        return;
+
+    int i[LOSS_TENSOR__AXIS_COUNT];
+    double w[LOSS_TENSOR__AXIS_COUNT];
+    for (int combination = 0; combination < (1 << LOSS_TENSOR__AXIS_COUNT); combination++)
+    {
+        bool held = true;
+        for (int k = 0; k < LOSS_TENSOR__AXIS_COUNT && held; k++)
+        {
+            int c = (combination >> k) & 1;
+            held = (c < count[k]);
+            if (held)
+            {
+                i[k] = cells[k][c];
+                w[k] = weights[k][c];
+            }
+        }
+        if (!held)
+            continue;
+
+        double error = fabs(InterpolateTensorCell(tensor, i, w) - A__db);
+
+        // round the error up when narrowing to float
+        float sampled = (float)error;
+        if (sampled < error)
+            sampled = nextafterf(sampled, INFINITY);
+
+        size_t index = TensorCellIndex(tensor, i);
+        if (sampled > error__db[index])
+            error__db[index] = sampled;
+    }
+}
+
+/*=============================================================================
+ |
+ |  Description:  Builds a dense tensor of P.528 losses over (log f, h_1, h_2,
+ |                d, p).  Nodes with h_1 above h_2 are filled by reciprocity.
+ |                Nodes where the terminals are at the same point in space
+ |                have no loss, and are stored as NaN so that the
+ |                interpolation skips them.
+ |                Every cell carries a bound of the error of the multilinear
+ |                interpolation, measured against direct evaluation.  The
+ |                error is sampled at the center, the face centers and the
+ |                edge midpoints of the cell, and the largest is scaled by
+ |                LOSS_TENSOR__ERROR_SAFETY.  Losses that change faster than
+ |                the half node spacing, such as the two-ray lobes of short
+ |                line-of-sight paths, can exceed the bound
+ |
+ |        Input:  d__km         - Distance nodes, in km
+ |                n_d           - Number of distance nodes
+ |                h_1__meter    - Low terminal height nodes, in meters
+ |                n_h_1         - Number of low terminal height nodes
+ |                h_2__meter    - High terminal height nodes, in meters
+ |                n_h_2         - Number of high terminal height nodes
+ |                f__mhz        - Frequency nodes, in MHz
+ |                n_f           - Number of frequency nodes
+ |                p             - Time percentage nodes
+ |                n_p           - Number of time percentage nodes
+ |                T_pol         - Code indicating either polarization
+ |                                  + 0 : POLARIZATION__HORIZONTAL
+ |                                  + 1 : POLARIZATION__VERTICAL
+ |
+ |      Outputs:  tensor        - Loss tensor, released with LossTensor_Free()
+ |
+ |      Returns:  rtn           - SUCCESS or error code
+ |
+ *===========================================================================*/
+int LossTensor_Build(const double* d__km, int n_d, const double* h_1__meter, int n_h_1,
+    const double* h_2__meter, int n_h_2, const double* f__mhz, int n_f, const double* p, int n_p,
+    int T_pol, LossTensor* tensor)
+{
+    const double* inputs[LOSS_TENSOR__AXIS_COUNT] = { f__mhz, h_1__meter, h_2__meter, d__km, p };
+    int n[LOSS_TENSOR__AXIS_COUNT] = { n_f, n_h_1, n_h_2, n_d, n_p };
+
+    tensor->storage = NULL;
+    tensor->mapping = NULL;
+    tensor->mapping_size = 0;
+
+    // every axis needs at least one cell, with strictly increasing nodes
+    size_t node_count = 1;
+    size_t cell_count = 1;
+    size_t axis_count = 0;
+    for (int k = 0; k < LOSS_TENSOR__AXIS_COUNT; k++)
+    {
+        if (n[k] < 2)
+            return ERROR_LOSS_TENSOR__AXIS;
+        for (int j = 1; j < n[k]; j++)
+        {
+            if (!(inputs[k][j] > inputs[k][j - 1]))
+                return ERROR_LOSS_TENSOR__AXIS;
+        }
+
+        // the cells are fewer than the nodes, so only the node count can overflow
+        if (node_count > SIZE_MAX / n[k])
+            return ERROR_LOSS_TENSOR__ALLOCATION;
+        node_count *= n[k];
+        cell_count *= n[k] - 1;
+        axis_count += n[k];
+    }
+
+    // the frequency axis is logarithmic
+    if (f__mhz[0] <= 0)
+        return ERROR_LOSS_TENSOR__AXIS;
+
+    // one block holds the axes, then the node losses and the cell errors
+    size_t limit = (axis_count > SIZE_MAX / sizeof(double)) ? 0 : (SIZE_MAX - axis_count * sizeof(double)) / sizeof(float);
+    if (node_count > limit || cell_count > limit - node_count)
+        return ERROR_LOSS_TENSOR__ALLOCATION;
+    char* storage = (char*)malloc(axis_count * sizeof(double) + (node_count + cell_count) * sizeof(float));
+    if (storage == NULL)
+        return ERROR_LOSS_TENSOR__ALLOCATION;
+
+    double* axes = (double*)storage;
+    float* A__db = (float*)(axes + axis_count);
+    float* error__db = A__db + node_count;
+
+    tensor->T_pol = T_pol;
+    for (int k = 0; k < LOSS_TENSOR__AXIS_COUNT; k++)
+    {
+        for (int j = 0; j < n[k]; j++)
+            axes[j] = (k == LOSS_TENSOR__AXIS_F) ? log10(inputs[k][j]) : inputs[k][j];
+
+        tensor->n[k] = n[k];
+        tensor->axes[k] = axes;
+        tensor->step[k] = TensorAxisStep(axes, n[k]);
+        axes += n[k];
+    }
+    tensor->A__db = A__db;
+    tensor->error__db = error__db;
+    tensor->storage = storage;
+
+    vector<double> losses__db(n_p);
+    PathContext context;
+    int err;
+
+    /////////////////////////////////////////////
+    // Losses at the nodes
+    //
+
+    float* node = A__db;
+    for (int i_f = 0; i_f < n_f; i_f++)
+    for (int i_h_1 = 0; i_h_1 < n_h_1; i_h_1++)
+    for (int i_h_2 = 0; i_h_2 < n_h_2; i_h_2++)
+    {
+        // the loss is reciprocal in the terminal heights
+        double h_low__meter = MIN(h_1__meter[i_h_1], h_2__meter[i_h_2]);
+        double h_high__meter = MAX(h_1__meter[i_h_1], h_2__meter[i_h_2]);
+
+        err = P528_InitPathContext(h_low__meter, h_high__meter, f__mhz[i_f], T_pol, &context);
+        if (err != SUCCESS)
+        {
+            LossTensor_Free(tensor);
+            return err;
+        }
+
+        for (int i_d = 0; i_d < n_d; i_d++)
+        {
+            err = EvaluatePathLosses(&context, d__km[i_d], p, n_p, losses__db.data());
+            if (err != SUCCESS)
+            {
+                LossTensor_Free(tensor);
+                return err;
+            }
+
+            // the terminals are at the same point in space (see ValidateInputs())
+            bool same_point = (h_low__meter == h_high__meter && d__km[i_d] == 0);
+
+            for (int i_p = 0; i_p < n_p; i_p++)
+                *node++ = same_point ? NAN : (float)losses__db[i_p];
+        }
+    }
+
+    //
+    // Losses at the nodes
+    /////////////////////////////////////////////
+
+    /////////////////////////////////////////////
+    // Interpolation error bound of the cells
+    //
+
+    // the error is sampled at the half nodes of the tensor, where every coordinate
+    // is at a node or half way between two.  These are the center, the face
+    // centers and the edge midpoints of each cell, and each one is evaluated once
+    // and compared with the interpolation of every cell that holds it
+    for (size_t c = 0; c < cell_count; c++)
+        error__db[c] = 0;
+
+    int n_half[LOSS_TENSOR__AXIS_COUNT];
+    for (int k = 0; k < LOSS_TENSOR__AXIS_COUNT; k++)
+        n_half[k] = 2 * n[k] - 1;
+
+    vector<double> p_half(n_half[LOSS_TENSOR__AXIS_P]);
+    for (int j = 0; j < n_half[LOSS_TENSOR__AXIS_P]; j++)
+        p_half[j] = HalfNode(p, j);
+    losses__db.resize(n_half[LOSS_TENSOR__AXIS_P]);
+
+    int half[LOSS_TENSOR__AXIS_COUNT];
+    for (half[0] = 0; half[0] < n_half[0]; half[0]++)
+    for (half[1] = 0; half[1] < n_half[1]; half[1]++)
+    for (half[2] = 0; half[2] < n_half[2]; half[2]++)
+    {
+        double f_half__mhz = (half[0] % 2 == 0) ? f__mhz[half[0] / 2] : pow(10, HalfNode(tensor->axes[LOSS_TENSOR__AXIS_F], half[0]));
+        double h_1_half__meter = HalfNode(h_1__meter, half[1]);
+        double h_2_half__meter = HalfNode(h_2__meter, half[2]);
+        double h_low__meter = MIN(h_1_half__meter, h_2_half__meter);
+        double h_high__meter = MAX(h_1_half__meter, h_2_half__meter);
+
+        err = P528_InitPathContext(h_low__meter, h_high__meter, f_half__mhz, T_pol, &context);
+        if (err != SUCCESS)
+        {
+            LossTensor_Free(tensor);
+            return err;
+        }
+
+        for (half[3] = 0; half[3] < n_half[3]; half[3]++)
+        {
+            double d_half__km = HalfNode(d__km, half[3]);
+
+            // the terminals are at the same point in space, where a query has no loss
+            if (h_low__meter == h_high__meter && d_half__km == 0)
+                continue;
+
+            err = EvaluatePathLosses(&context, d_half__km, p_half.data(), n_half[LOSS_TENSOR__AXIS_P], losses__db.data());
+            if (err != SUCCESS)
+            {
+                LossTensor_Free(tensor);
+                return err;
+            }
+
+            for (half[4] = 0; half[4] < n_half[4]; half[4]++)
+                SampleCellErrors(tensor, half, losses__db[half[4]], error__db);
+        }
+    }
+
+    // the half nodes miss the peaks of the error between them, which the safety
+    // factor allows for.  The bound is rounded up when narrowing to float
+    for (size_t c = 0; c < cell_count; c++)
+    {
+        double bound = LOSS_TENSOR__ERROR_SAFETY * error__db[c];
+        error__db[c] = (float)bound;
+        if (error__db[c] < bound)
+            error__db[c] = nextafterf(error__db[c], INFINITY);
+    }
+
+    //
+    // Interpolation error bound of the cells
+    /////////////////////////////////////////////
+
+    return SUCCESS;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Interpolates the loss from a loss tensor
+ |
+ |        Input:  tensor        - Loss tensor
+ |                d__km         - Path distance, in km
+ |                h_1__meter    - Height of the low terminal, in meters
+ |                h_2__meter    - Height of the high terminal, in meters
+ |                f__mhz        - Frequency, in MHz
+ |                p             - Time percentage
+ |
+ |      Outputs:  A__db         - Interpolated loss, in dB
+ |                error__db     - Interpolation error bound of the cell, in dB
+ |
+ |      Returns:  rtn           - SUCCESS or ERROR_LOSS_TENSOR__OUT_OF_RANGE
+ |
+ *===========================================================================*/
+int LossTensor_Query(const LossTensor* tensor, double d__km, double h_1__meter, double h_2__meter,
+    double f__mhz, double p, double* A__db, double* error__db)
+{
+    double x[LOSS_TENSOR__AXIS_COUNT] = { log10(f__mhz), h_1__meter, h_2__meter, d__km, p };
+
+    int i[LOSS_TENSOR__AXIS_COUNT];
+    double w[LOSS_TENSOR__AXIS_COUNT];
+    for (int k = 0; k < LOSS_TENSOR__AXIS_COUNT; k++)
+    {
+        if (!LocateTensorCell(tensor, k, x[k], &i[k], &w[k]))
+            return ERROR_LOSS_TENSOR__OUT_OF_RANGE;
+    }
+
+    // as in P528(), terminals at the same point in space have no loss
+    if (h_1__meter == h_2__meter && d__km == 0)
+        *A__db = 0;
+    else
+        *A__db = InterpolateTensorCell(tensor, i, w);
+    *error__db = tensor->error__db[TensorCellIndex(tensor, i)];
+
+    return SUCCESS;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Releases the storage owned by a loss tensor, or the
+ |                mapping of the data pack it was opened from
+ |
+ |        Input:  tensor        - Loss tensor
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void LossTensor_Free(LossTensor* tensor)
+{
+    free(tensor->storage);
+    if (tensor->mapping != NULL)
+        UnmapPack(tensor->mapping, tensor->mapping_size);
+
+    tensor->storage = NULL;
+    tensor->mapping = NULL;
+    tensor->mapping_size = 0;
+    tensor->A__db = NULL;
+    tensor->error__db = NULL;
+}
@@ -0,0 +1,418 @@
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "../../include/p528.h"
+
+/*=============================================================================
+ |
+ |  Description:  Little-endian encoding of the integers in a data pack
+ |
+ *===========================================================================*/
+void PackU32(unsigned char* bytes, unsigned int value)
+{
+    for (int i = 0; i < 4; i++)
+        bytes[i] = (unsigned char)(value >> (8 * i));
+}
+
+void PackU64(unsigned char* bytes, unsigned long long value)
+{
+    for (int i = 0; i < 8; i++)
+        bytes[i] = (unsigned char)(value >> (8 * i));
+}
+
+unsigned int UnpackU32(const unsigned char* bytes)
+{
+    unsigned int value = 0;
+    for (int i = 3; i >= 0; i--)
+        value = (value << 8) | bytes[i];
+
+    return value;
+}
+
+unsigned long long UnpackU64(const unsigned char* bytes)
+{
+    unsigned long long value = 0;
+    for (int i = 7; i >= 0; i--)
+        value = (value << 8) | bytes[i];
+
+    return value;
+}
+
+/*=============================================================================
+ |
+ |  Description:  64-bit FNV-1a checksum of the payload of a data pack
+ |
+ |        Input:  bytes         - Payload
+ |                size          - Size of the payload, in bytes
+ |
+ |      Returns:  Checksum
+ |
+ *===========================================================================*/
+unsigned long long PackChecksum(const unsigned char* bytes, size_t size)
+{
+    unsigned long long hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Maps a data pack into memory, read-only.  Processes that
+ |                map the same file share its pages
+ |
+ |        Input:  filename      - Path of the data pack
+ |
+ |      Outputs:  size          - Size of the mapping, in bytes
+ |
+ |      Returns:  Address of the mapping, or NULL on failure
+ |
+ *===========================================================================*/
+void* MapPack(const char* filename, size_t* size)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return NULL;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return NULL;
+    }
+
+    HANDLE map = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (map == NULL)
+        return NULL;
+
+    void* mapping = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(map);
+
+    *size = (size_t)file_size.QuadPart;
+    return mapping;
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    void* mapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        return NULL;
+
+    *size = (size_t)st.st_size;
+    return mapping;
+#endif
+}
+
+/*=============================================================================
+ |
+ |  Description:  Releases a mapping from MapPack()
+ |
+ *===========================================================================*/
+void UnmapPack(void* mapping, size_t size)
+{
+#ifdef _WIN32
+    UnmapViewOfFile(mapping);
+#else
+    munmap(mapping, size);
+#endif
+}
+
+/*=============================================================================
+ |
+ |  Description:  Writes a loss tensor to a data pack.  The pack holds a
+ |                72 byte header followed by the payload:
+ |
+ |                   0  char[8]   magic, "P528PACK"
+ |                   8  uint32    format version
+ |                  12  uint32    content, PACK__CONTENT_LOSS_TENSOR
+ |                  16  char[16]  model version, "ITU-R P.528-5"
+ |                  32  uint32    T_pol
+ |                  36  uint32[5] number of nodes on each axis
+ |                  56  uint64    payload size, in bytes
+ |                  64  uint64    FNV-1a checksum of the payload
+ |                  72  double[]  axes, in axis order
+ |                      float[]   node losses
+ |                      float[]   cell error bounds
+ |
+ |                All values are little-endian, so the payload can be used
+ |                in place on little-endian hosts
+ |
+ |        Input:  tensor        - Loss tensor
+ |                filename      - Path of the data pack
+ |
+ |      Returns:  rtn           - SUCCESS or ERROR_PACK__IO
+ |
+ *===========================================================================*/
+int LossTensor_WritePack(const LossTensor* tensor, const char* filename)
+{
+    size_t axis_count = 0;
+    size_t node_count = 1;
+    size_t cell_count = 1;
+    for (int k = 0; k < LOSS_TENSOR__AXIS_COUNT; k++)
+    {
+        axis_count += tensor->n[k];
+        node_count *= tensor->n[k];
+        cell_count *= tensor->n[k] - 1;
+    }
+
+    size_t payload_size = axis_count * 8 + (node_count + cell_count) * 4;
+    unsigned char* bytes = (unsigned char*)malloc(PACK__HEADER_SIZE + payload_size);
+    if (bytes == NULL)
+        return ERROR_PACK__IO;
+
+    // payload
+    unsigned char* payload = bytes + PACK__HEADER_SIZE;
+    unsigned char* next = payload;
+    for (int k = 0; k < LOSS_TENSOR__AXIS_COUNT; k++)
+    {
+        for (int j = 0; j < tensor->n[k]; j++)
+        {
+            unsigned long long value;
+            memcpy(&value, &tensor->axes[k][j], 8);
+            PackU64(next, value);
+            next += 8;
+        }
+    }
+    for (size_t i = 0; i < node_count; i++)
+    {
+        unsigned int value;
+        memcpy(&value, &tensor->A__db[i], 4);
+        PackU32(next, value);
+        next += 4;
+    }
+    for (size_t i = 0; i < cell_count; i++)
+    {
+        unsigned int value;
+        memcpy(&value, &tensor->error__db[i], 4);
+        PackU32(next, value);
+        next += 4;
+    }
+
+    // header
+    memset(bytes, 0, PACK__HEADER_SIZE);
+    memcpy(bytes, PACK__MAGIC, 8);
+    PackU32(bytes + 8, PACK__FORMAT_VERSION);
+    PackU32(bytes + 12, PACK__CONTENT_LOSS_TENSOR);
+    memcpy(bytes + 16, PACK__MODEL_VERSION, strlen(PACK__MODEL_VERSION));
+    PackU32(bytes + 32, tensor->T_pol);
+    for (int k = 0; k < LOSS_TENSOR__AXIS_COUNT; k++)
+        PackU32(bytes + 36 + 4 * k, tensor->n[k]);
+    PackU64(bytes + 56, payload_size);
+    PackU64(bytes + 64, PackChecksum(payload, payload_size));
+
+    FILE* fp = fopen(filename, "wb");
+    if (fp == NULL)
+    {
+        free(bytes);
+        return ERROR_PACK__IO;
+    }
+
+    size_t written = fwrite(bytes, 1, PACK__HEADER_SIZE + payload_size, fp);
+    int closed = fclose(fp);
+    free(bytes);
+
+    if (written != PACK__HEADER_SIZE + payload_size || closed != 0)
+        return ERROR_PACK__IO;
+
+    return SUCCESS;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Opens a loss tensor from a data pack.  The file is mapped
+ |                read-only and, on little-endian hosts, the tensor points
+ |                directly into the mapping with nothing copied or parsed
+ |                beyond the header.  Big-endian hosts decode a private copy
+ |
+ |        Input:  filename      - Path of the data pack
+ |                verify        - If nonzero, check the payload checksum
+ |
+ |      Outputs:  tensor        - Loss tensor, released with LossTensor_Free()
+ |
+ |      Returns:  rtn           - SUCCESS or error code
+ |
+ *===========================================================================*/
+int LossTensor_OpenPack(const char* filename, int verify, LossTensor* tensor)
+{
+    tensor->storage = NULL;
+    tensor->mapping = NULL;
+    tensor->mapping_size = 0;
+
+    size_t size;
+    unsigned char* bytes = (unsigned char*)MapPack(filename, &size);
+    if (bytes == NULL)
+        return ERROR_PACK__IO;
+
+    /////////////////////////////////////////////
+    // Validate the header
+    //
+
+    char model[17] = { 0 };
+    if (size >= PACK__HEADER_SIZE)
+        memcpy(model, bytes + 16, 16);
+
+    if (size < PACK__HEADER_SIZE ||
+        memcmp(bytes, PACK__MAGIC, 8) != 0 ||
+        UnpackU32(bytes + 8) != PACK__FORMAT_VERSION ||
+        UnpackU32(bytes + 12) != PACK__CONTENT_LOSS_TENSOR ||
+        strcmp(model, PACK__MODEL_VERSION) != 0)
+    {
+        UnmapPack(bytes, size);
+        return ERROR_PACK__FORMAT;
+    }
+
+    // the counts are untrusted, so they are checked against overflow before the
+    // payload size is compared with the file
+    unsigned int T_pol = UnpackU32(bytes + 32);
+    size_t axis_count = 0;
+    size_t node_count = 1;
+    size_t cell_count = 1;
+    bool valid = (T_pol == POLARIZATION__HORIZONTAL || T_pol == POLARIZATION__VERTICAL);
+    for (int k = 0; k < LOSS_TENSOR__AXIS_COUNT && valid; k++)
+    {
+        unsigned int n = UnpackU32(bytes + 36 + 4 * k);
+        if (n < 2 || n > INT_MAX || node_count > SIZE_MAX / n)
+        {
+            valid = false;
+            break;
+        }
+
+        tensor->n[k] = (int)n;
+        axis_count += n;
+        node_count *= n;
+        cell_count *= n - 1;
+    }
+
+    size_t payload_size = 0;
+    if (valid)
+    {
+        size_t limit = (axis_count > SIZE_MAX / 8) ? 0 : (SIZE_MAX - axis_count * 8) / 4;
+        valid = (node_count <= limit && cell_count <= limit - node_count);
+        if (valid)
+            payload_size = axis_count * 8 + (node_count + cell_count) * 4;
+    }
+
+    if (!valid || UnpackU64(bytes + 56) != payload_size || size - PACK__HEADER_SIZE != payload_size)
+    {
+        UnmapPack(bytes, size);
+        return ERROR_PACK__FORMAT;
+    }
+
+    const unsigned char* payload = bytes + PACK__HEADER_SIZE;
+    if (verify && PackChecksum(payload, payload_size) != UnpackU64(bytes + 64))
+    {
+        UnmapPack(bytes, size);
+        return ERROR_PACK__CHECKSUM;
+    }
+
+    // as in LossTensor_Build(), the nodes of every axis are finite and strictly increasing
+    const unsigned char* axis = payload;
+    for (int k = 0; k < LOSS_TENSOR__AXIS_COUNT; k++)
+    {
+        double previous = -HUGE_VAL;
+        for (int j = 0; j < tensor->n[k]; j++, axis += 8)
+        {
+            unsigned long long bits = UnpackU64(axis);
+            double node;
+            memcpy(&node, &bits, 8);
+            if (!(node > previous && node < HUGE_VAL))
+            {
+                UnmapPack(bytes, size);
+                return ERROR_PACK__FORMAT;
+            }
+            previous = node;
+        }
+    }
+
+    //
+    // Validate the header
+    /////////////////////////////////////////////
+
+    tensor->T_pol = (int)T_pol;
+
+    unsigned int one = 1;
+    bool little_endian = *(unsigned char*)&one == 1;
+
+    if (little_endian)
+    {
+        // use the payload in place
+        const double* axes = (const double*)payload;
+        for (int k = 0; k < LOSS_TENSOR__AXIS_COUNT; k++)
+        {
+            tensor->axes[k] = axes;
+            axes += tensor->n[k];
+        }
+        tensor->A__db = (const float*)axes;
+        tensor->error__db = tensor->A__db + node_count;
+
+        tensor->mapping = bytes;
+        tensor->mapping_size = size;
+    }
+    else
+    {
+        // decode a private copy, in the same layout as the payload
+        unsigned char* storage = (unsigned char*)malloc(payload_size);
+        if (storage == NULL)
+        {
+            UnmapPack(bytes, size);
+            return ERROR_PACK__IO;
+        }
+
+        for (size_t i = 0; i < axis_count; i++)
+        {
+            unsigned long long value = UnpackU64(payload + 8 * i);
+            memcpy(storage + 8 * i, &value, 8);
+        }
+        for (size_t i = 0; i < node_count + cell_count; i++)
+        {
+            unsigned int value = UnpackU32(payload + 8 * axis_count + 4 * i);
+            memcpy(storage + 8 * axis_count + 4 * i, &value, 4);
+        }
+        UnmapPack(bytes, size);
+
+        const double* axes = (const double*)storage;
+        for (int k = 0; k < LOSS_TENSOR__AXIS_COUNT; k++)
+        {
+            tensor->axes[k] = axes;
+            axes += tensor->n[k];
+        }
+        tensor->A__db = (const float*)axes;
+        tensor->error__db = tensor->A__db + node_count;
+
+        tensor->storage = storage;
+    }
+
+    for (int k = 0; k < LOSS_TENSOR__AXIS_COUNT; k++)
+        tensor->step[k] = TensorAxisStep(tensor->axes[k], tensor->n[k]);
+
+    return SUCCESS;
+}
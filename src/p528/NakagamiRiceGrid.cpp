@@ -0,0 +1,102 @@
+#include "../../include/p528.h"
+
+/*=============================================================================
+ |
+ |  Description:  This function computes the value of the Nakagami-Rice
+ |                distribution for K and p% from the uniform grid in
+ |                data::NakagamiRiceGrid.  The cell is found directly from
+ |                K and p, and the result matches NakagamiRice()
+ |
+ |        Input:  K         - K-value
+ |                p         - Time percentage
+ |
+ |      Returns:  Y_pi__db  - Variability, in dB
+ |
+ *===========================================================================*/
+double NakagamiRiceFast(double K, double p)
+{
+    double x = MIN(MAX(K, NR_GRID__K_MIN), NR_GRID__K_MIN + NR_GRID__K_COUNT - 1) - NR_GRID__K_MIN;
+    double y = MIN(MAX(p, NR_GRID__P_MIN), NR_GRID__P_MIN + NR_GRID__P_COUNT - 1) - NR_GRID__P_MIN;
+
+    int i = MIN((int)x, NR_GRID__K_COUNT - 2);
+    int j = MIN((int)y, NR_GRID__P_COUNT - 2);
+
+    double t = x - i;
+    double u = y - j;
+
+    const double* Y_lower = &data::NakagamiRiceGrid[i * NR_GRID__P_COUNT + j];
+    const double* Y_upper = Y_lower + NR_GRID__P_COUNT;
+
+    return (1 - t) * ((1 - u) * Y_lower[0] + u * Y_lower[1])
+        + t * ((1 - u) * Y_upper[0] + u * Y_upper[1]);
+}
+
+/*=============================================================================
+ |
+ |  Description:  This function returns the K-value of the Nakagami-Rice
+ |                distribution for the given value of Y_pi(99), using the
+ |                bucket index in data::Y_pi_99Index in place of a linear
+ |                search.  The result matches FindKForYpiAt99Percent()
+ |
+ |        Input:  Y_pi_99__db   - Y_pi(99), in dB
+ |
+ |       Returns: K             - K-value
+ |
+ *===========================================================================*/
+double FindKForYpiAt99PercentFast(double Y_pi_99__db)
+{
+    const vector<vector<double>>& Y = data::NakagamiRiceCurves;
+
+    double Y_min__db = Y.front()[Y_pi_99_INDEX];
+    double Y_max__db = Y.back()[Y_pi_99_INDEX];
+
+    if (Y_pi_99__db < Y_min__db)
+        return data::K.front();
+    if (Y_pi_99__db >= Y_max__db)
+        return data::K.back();
+
+    int b = (int)((Y_pi_99__db - Y_min__db) * NR_GRID__Y_PI_99_BUCKETS / (Y_max__db - Y_min__db));
+    int i = data::Y_pi_99Index[MIN(b, NR_GRID__Y_PI_99_BUCKETS - 1)];
+
+    while (Y[i + 1][Y_pi_99_INDEX] <= Y_pi_99__db)
+        i++;
+
+    return (data::K[i + 1] * (Y_pi_99__db - Y[i][Y_pi_99_INDEX]) - data::K[i] * (Y_pi_99__db - Y[i + 1][Y_pi_99_INDEX])) / (Y[i + 1][Y_pi_99_INDEX] - Y[i][Y_pi_99_INDEX]);
+}
+
+/*=============================================================================
+ |
+ |  Description:  Batch form of NakagamiRiceFast()
+ |
+ |        Input:  K         - Array of K-values
+ |                p         - Array of time percentages
+ |                n         - Number of elements
+ |
+ |      Outputs:  Y_pi__db  - Array of variabilities, in dB
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void NakagamiRiceBatch(const double* K, const double* p, int n, double* Y_pi__db)
+{
+    for (int i = 0; i < n; i++)
+        Y_pi__db[i] = NakagamiRiceFast(K[i], p[i]);
+}
+
+/*=============================================================================
+ |
+ |  Description:  Batch form of FindKForYpiAt99PercentFast()
+ |
+ |        Input:  Y_pi_99__db   - Array of Y_pi(99) values, in dB
+ |                n             - Number of elements
+ |
+ |      Outputs:  K             - Array of K-values
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void FindKForYpiAt99PercentBatch(const double* Y_pi_99__db, int n, double* K)
+{
+    for (int i = 0; i < n; i++)
+        K[i] = FindKForYpiAt99PercentFast(Y_pi_99__db[i]);
+}
@@ -0,0 +1,490 @@
+#include <math.h>
+#include "../../include/p528.h"
+#include "../../include/p676.h"
+
+/*=============================================================================
+ |
+ |  Description:  Computes the terminal geometries, the smooth earth
+ |                diffraction line and the line-of-sight terms of the path
+ |                context (Steps 1 through 4 of Annex 2, Section 3 of
+ |                Recommendation ITU-R P.528-5).  None of these depend on
+ |                the path distance or time percentage
+ |
+ |        Input:  h_1__meter        - Height of the low terminal, in meters
+ |                h_2__meter        - Height of the high terminal, in meters
+ |                f__mhz            - Frequency, in MHz
+ |                T_pol             - Code indicating either polarization
+ |
+ |      Outputs:  context           - Path context
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void InitPathGeometry(double h_1__meter, double h_2__meter, double f__mhz, int T_pol, PathContext* context)
+{
+    context->h_1__meter = h_1__meter;
+    context->h_2__meter = h_2__meter;
+    context->f__mhz = f__mhz;
+    context->T_pol = T_pol;
+    context->transhorizon = false;
+    context->warnings = WARNING__NO_WARNINGS;
+
+    Terminal* terminal_1 = &context->terminal_1;
+    Terminal* terminal_2 = &context->terminal_2;
+
+    /////////////////////////////////////////////
+    // Compute terminal geometries
+    //
+
+    // Step 1 for low terminal
+    terminal_1->h_r__km = h_1__meter / 1000;
+    TerminalGeometry(f__mhz, terminal_1);
+
+    // Step 1 for high terminal
+    terminal_2->h_r__km = h_2__meter / 1000;
+    TerminalGeometry(f__mhz, terminal_2);
+
+    //
+    // Compute terminal geometries
+    /////////////////////////////////////////////
+
+    InitPathLine(context);
+}
+
+/*=============================================================================
+ |
+ |  Description:  Computes the smooth earth diffraction line and the
+ |                line-of-sight terms of the path context from its terminal
+ |                geometries (Steps 2 through 4)
+ |
+ | Input/Output:  context           - Path context, with heights, frequency,
+ |                                    polarization and terminal geometries
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void InitPathLine(PathContext* context)
+{
+    double f__mhz = context->f__mhz;
+    int T_pol = context->T_pol;
+
+    Terminal* terminal_1 = &context->terminal_1;
+    Terminal* terminal_2 = &context->terminal_2;
+    Path* path = &context->path;
+
+    // Step 2
+    path->d_ML__km = terminal_1->d_r__km + terminal_2->d_r__km;                     // [Eqn 3-1]
+
+    /////////////////////////////////////////////
+    // Smooth earth diffraction line calculations
+    //
+
+    // Step 3.1
+    double d_3__km = path->d_ML__km + 0.5 * pow(pow(a_e__km, 2) / f__mhz, THIRD);   // [Eqn 3-2]
+    double d_4__km = path->d_ML__km + 1.5 * pow(pow(a_e__km, 2) / f__mhz, THIRD);   // [Eqn 3-3]
+
+    // Step 3.2
+    double A_3__db = SmoothEarthDiffraction(terminal_1->d_r__km, terminal_2->d_r__km, f__mhz, d_3__km, T_pol);
+    double A_4__db = SmoothEarthDiffraction(terminal_1->d_r__km, terminal_2->d_r__km, f__mhz, d_4__km, T_pol);
+
+    // Step 3.3
+    context->M_d = (A_4__db - A_3__db) / (d_4__km - d_3__km);                       // [Eqn 3-4]
+    context->A_d0 = A_4__db - context->M_d * d_4__km;                               // [Eqn 3-5]
+
+    // Step 3.4
+    context->A_dML__db = (context->M_d * path->d_ML__km) + context->A_d0;           // [Eqn 3-6]
+    path->d_d__km = -(context->A_d0 / context->M_d);                                // [Eqn 3-7]
+
+    //
+    // End smooth earth diffraction line calculations
+    /////////////////////////////////////////////////
+
+    // Step 4.  Line-of-sight terms that do not depend on distance
+    LineOfSightInit(path, terminal_1, terminal_2, f__mhz, -context->A_dML__db, T_pol,
+        &context->psi_limit, &context->A_d_0__db);
+}
+
+/*=============================================================================
+ |
+ |  Description:  Computes the transhorizon terms of the path context: the
+ |                line-of-sight K-value near the horizon and the search for
+ |                the diffraction/troposcatter crossover (Steps 5 and 6)
+ |
+ | Input/Output:  context           - Path context, from InitPathGeometry()
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void InitPathTranshorizon(PathContext* context)
+{
+    Path* path = &context->path;
+
+    // get K_LOS
+    PathPoint point;
+    LineOfSightPoint(path, &context->terminal_1, &context->terminal_2, &context->los_params, context->f__mhz,
+        -context->A_dML__db, context->psi_limit, context->A_d_0__db, path->d_ML__km - 1, context->T_pol, &point);
+    context->K_LOS = point.K__db;
+
+    // Step 6.  Search past horizon to find crossover point between Diffraction and Troposcatter models
+    TranshorizonSearch(path, &context->terminal_1, &context->terminal_2, context->f__mhz, context->A_dML__db,
+        &context->M_d, &context->A_d0, &context->d_crx__km, &context->CASE, &context->warnings);
+
+    context->transhorizon = true;
+}
+
+/*=============================================================================
+ |
+ |  Description:  This function computes the distance-dependent terms of the
+ |                transhorizon loss (Step 7 of Annex 2, Section 3)
+ |
+ |        Input:  context       - Path context, with transhorizon terms
+ |                path          - Struct containing path parameters
+ |                terminal_1    - Struct containing low terminal parameters
+ |                terminal_2    - Struct containing high terminal parameters
+ |                d__km         - Path distance, in km
+ |
+ |      Outputs:  tropo         - Troposcatter parameters
+ |                point         - Distance-dependent terms of the result
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void TranshorizonPoint(const PathContext* context, Path* path, Terminal* terminal_1, Terminal* terminal_2,
+    double d__km, TroposcatterParams* tropo, PathPoint* point)
+{
+    double f__mhz = context->f__mhz;
+
+    /////////////////////////////////////////////
+    // Compute terrain attenuation, A_T__db
+    //
+
+    // Step 7.1
+    double A_d__db = context->M_d * d__km + context->A_d0;                          // [Eqn 3-14]
+
+    // Step 7.2
+    Troposcatter(path, terminal_1, terminal_2, d__km, f__mhz, tropo);
+
+    // Step 7.3
+    double A_T__db;
+    if (d__km < context->d_crx__km)
+    {
+        // always in diffraction if less than d_crx
+        A_T__db = A_d__db;
+        point->propagation_mode = PROP_MODE__DIFFRACTION;
+    }
+    else
+    {
+        if (context->CASE == CASE_1)
+        {
+            // select the lower loss mode of propagation
+            if (tropo->A_s__db <= A_d__db)
+            {
+                A_T__db = tropo->A_s__db;
+                point->propagation_mode = PROP_MODE__SCATTERING;
+            }
+            else
+            {
+                A_T__db = A_d__db;
+                point->propagation_mode = PROP_MODE__DIFFRACTION;
+            }
+        }
+        else // CASE_2
+        {
+            A_T__db = tropo->A_s__db;
+            point->propagation_mode = PROP_MODE__SCATTERING;
+        }
+    }
+
+    //
+    // Compute terrain attenuation, A_T__db
+    /////////////////////////////////////////////
+
+    /////////////////////////////////////////////
+    // Compute variability
+    //
+
+    // f_theta_h is unity for transhorizon paths
+    double f_theta_h = 1;
+
+    // compute the 50% of the long-term variability distribution
+    double Y_e_50__db, dummy;
+    LongTermVariability(terminal_1->d_r__km, terminal_2->d_r__km, d__km, f__mhz, 50, f_theta_h, -A_T__db, &Y_e_50__db, &dummy);
+
+    // compute the K-value of the Nakagami-Rice distribution
+    double ANGLE = 0.02617993878;   // 1.5 deg
+    double K_t__db;
+    if (tropo->theta_s >= ANGLE)        // theta_s > 1.5 deg
+        K_t__db = 20;
+    else if (tropo->theta_s <= 0.0)
+        K_t__db = context->K_LOS;
+    else
+        K_t__db = (tropo->theta_s * (20.0 - context->K_LOS) / ANGLE) + context->K_LOS;
+
+    //
+    // Compute variability
+    /////////////////////////////////////////////
+
+    /////////////////////////////////////////////
+    // Atmospheric absorption for transhorizon path
+    //
+
+    SlantPathAttenuationResult result_v;
+    SlantPathAttenuation(f__mhz / 1000, 0, tropo->h_v__km, PI / 2, &result_v);
+
+    point->A_a__db = terminal_1->A_a__db + terminal_2->A_a__db + 2 * result_v.A_gas__db;   // [Eqn 3-17]
+
+    //
+    // Atmospheric absorption for transhorizon path
+    /////////////////////////////////////////////
+
+    /////////////////////////////////////////////
+    // Compute free-space loss
+    //
+
+    double r_fs__km = terminal_1->a__km + terminal_2->a__km + 2 * result_v.a__km;   // [Eqn 3-18]
+    point->A_fs__db = 20.0 * log10(f__mhz) + 20.0 * log10(r_fs__km) + 32.45;        // [Eqn 3-19]
+
+    //
+    // Compute free-space loss
+    /////////////////////////////////////////////
+
+    point->d__km = d__km;
+    point->d_result__km = d__km;
+    point->A_T__db = A_T__db;
+    point->f_theta_h = f_theta_h;
+    point->K__db = K_t__db;
+    point->Y_e_50__db = Y_e_50__db;
+    point->theta_h1__rad = -terminal_1->theta__rad;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Computes the distance-dependent terms of the result for a
+ |                path context.  The context must include the transhorizon
+ |                terms if d__km is beyond the line-of-sight region
+ |
+ |        Input:  context       - Path context
+ |                d__km         - Path distance, in km
+ |
+ |      Outputs:  point         - Distance-dependent terms of the result
+ |                los_params    - Line-of-sight parameters, if in LOS
+ |                tropo         - Troposcatter parameters, if transhorizon
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void PathContextPoint(const PathContext* context, double d__km, PathPoint* point,
+    LineOfSightParams* los_params, TroposcatterParams* tropo)
+{
+    // the model functions take non-const pointers, so work on local copies
+    Path path = context->path;
+    Terminal terminal_1 = context->terminal_1;
+    Terminal terminal_2 = context->terminal_2;
+
+    if (path.d_ML__km - d__km > 0.001)
+        LineOfSightPoint(&path, &terminal_1, &terminal_2, los_params, context->f__mhz, -context->A_dML__db,
+            context->psi_limit, context->A_d_0__db, d__km, context->T_pol, point);
+    else
+        TranshorizonPoint(context, &path, &terminal_1, &terminal_2, d__km, tropo, point);
+}
+
+/*=============================================================================
+ |
+ |  Description:  Applies the time variability to the distance-dependent
+ |                terms of the result, for the time percentage p
+ |
+ |        Input:  terminal_1    - Struct containing low terminal parameters
+ |                terminal_2    - Struct containing high terminal parameters
+ |                f__mhz        - Frequency, in MHz
+ |                point         - Distance-dependent terms of the result
+ |                p             - Time percentage
+ |
+ |      Outputs:  result        - Result structure
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void PathPointResult(const Terminal* terminal_1, const Terminal* terminal_2, double f__mhz,
+    const PathPoint* point, double p, Result* result)
+{
+    // compute the p% of the long-term variability distribution
+    double Y_e__db, dummy;
+    LongTermVariability(terminal_1->d_r__km, terminal_2->d_r__km, point->d__km, f__mhz, p, point->f_theta_h, -point->A_T__db, &Y_e__db, &dummy);
+
+    // compute the p% of the Nakagami-Rice distribution
+    double Y_pi_50__db = 0.0;       //  zero mean
+    double Y_pi__db = NakagamiRice(point->K__db, p);
+
+    // combine the long-term and Nakagami-Rice distributions
+    double Y_total__db = CombineDistributions(point->Y_e_50__db, Y_e__db, Y_pi_50__db, Y_pi__db, p);
+
+    result->propagation_mode = point->propagation_mode;
+    result->d__km = point->d_result__km;
+    result->A_fs__db = point->A_fs__db;
+    result->A_a__db = point->A_a__db;
+    result->A__db = point->A_fs__db + point->A_a__db + point->A_T__db - Y_total__db;     // [Eqn 3-20]
+    result->theta_h1__rad = point->theta_h1__rad;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Builds a path context: everything in P.528 that depends
+ |                only on the terminal heights, frequency and polarization.
+ |                A context can be reused by P528_Context() for any number
+ |                of distances and time percentages
+ |
+ |        Input:  h_1__meter        - Height of the low terminal, in meters
+ |                h_2__meter        - Height of the high terminal, in meters
+ |                f__mhz            - Frequency, in MHz
+ |                T_pol             - Code indicating either polarization
+ |                                      + 0 : POLARIZATION__HORIZONTAL
+ |                                      + 1 : POLARIZATION__VERTICAL
+ |
+ |      Outputs:  context           - Path context
+ |
+ |      Returns:  rtn               - SUCCESS or error code
+ |
+ *===========================================================================*/
+int P528_InitPathContext(double h_1__meter, double h_2__meter, double f__mhz, int T_pol, PathContext* context)
+{
+    // validate with a distance and percentage that are always in range
+    int warnings = WARNING__NO_WARNINGS;
+    int err = ValidateInputs(1, h_1__meter, h_2__meter, f__mhz, T_pol, 50, &warnings);
+    if (err != SUCCESS)
+        return err;
+
+    InitPathGeometry(h_1__meter, h_2__meter, f__mhz, T_pol, context);
+    InitPathTranshorizon(context);
+
+    return SUCCESS;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Initializes the path contexts of several terminal pairs at
+ |                one frequency and polarization, such as the columns of a
+ |                data table.  The geometry of each distinct terminal height
+ |                is computed once and shared by every pair that uses it
+ |
+ |        Input:  h_1__meter        - Height of the low terminal of each pair,
+ |                                    in meters
+ |                h_2__meter        - Height of the high terminal of each
+ |                                    pair, in meters
+ |                n                 - Number of pairs
+ |                f__mhz            - Frequency, in MHz
+ |                T_pol             - Code indicating either polarization
+ |                                      + 0 : POLARIZATION__HORIZONTAL
+ |                                      + 1 : POLARIZATION__VERTICAL
+ |
+ |      Outputs:  contexts          - Path context of each pair, as from
+ |                                    P528_InitPathContext()
+ |
+ |      Returns:  rtn               - SUCCESS or error code
+ |
+ *===========================================================================*/
+int P528_InitPathContexts(const double* h_1__meter, const double* h_2__meter, int n, double f__mhz, int T_pol,
+    PathContext* contexts)
+{
+    for (int i = 0; i < n; i++)
+    {
+        int warnings = WARNING__NO_WARNINGS;
+        int err = ValidateInputs(1, h_1__meter[i], h_2__meter[i], f__mhz, T_pol, 50, &warnings);
+        if (err != SUCCESS)
+            return err;
+    }
+
+    vector<double> heights__meter;
+    vector<Terminal> terminals;
+
+    for (int i = 0; i < n; i++)
+    {
+        PathContext* context = &contexts[i];
+        context->h_1__meter = h_1__meter[i];
+        context->h_2__meter = h_2__meter[i];
+        context->f__mhz = f__mhz;
+        context->T_pol = T_pol;
+        context->transhorizon = false;
+        context->warnings = WARNING__NO_WARNINGS;
+
+        // Step 1, for each terminal height not yet seen
+        for (int j = 0; j < 2; j++)
+        {
+            double h__meter = (j == 0) ? h_1__meter[i] : h_2__meter[i];
+
+            size_t k = 0;
+            while (k < heights__meter.size() && heights__meter[k] != h__meter)
+                k++;
+
+            if (k == heights__meter.size())
+            {
+                Terminal terminal;
+                terminal.h_r__km = h__meter / 1000;
+                TerminalGeometry(f__mhz, &terminal);
+
+                heights__meter.push_back(h__meter);
+                terminals.push_back(terminal);
+            }
+
+            if (j == 0)
+                context->terminal_1 = terminals[k];
+            else
+                context->terminal_2 = terminals[k];
+        }
+
+        InitPathLine(context);
+        InitPathTranshorizon(context);
+    }
+
+    return SUCCESS;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Computes P.528 from a path context.  The results are
+ |                identical to P528() with the same inputs
+ |
+ |        Input:  context           - Path context, from P528_InitPathContext()
+ |                d__km             - Path distance, in km
+ |                p                 - Time percentage
+ |
+ |      Outputs:  result            - Result structure
+ |
+ |      Returns:  rtn               - SUCCESS or error code
+ |
+ *===========================================================================*/
+int P528_Context(const PathContext* context, double d__km, double p, Result* result)
+{
+    // reset Results struct
+    result->A_fs__db = 0;
+    result->A_a__db = 0;
+    result->A__db = 0;
+    result->d__km = 0;
+    result->theta_h1__rad = 0;
+    result->propagation_mode = PROP_MODE__NOT_SET;
+    result->warnings = WARNING__NO_WARNINGS;
+
+    int err = ValidateInputs(d__km, context->h_1__meter, context->h_2__meter, context->f__mhz,
+        context->T_pol, p, &result->warnings);
+    if (err != SUCCESS)
+    {
+        if (err == ERROR_HEIGHT_AND_DISTANCE)
+            return SUCCESS;
+        else
+            return err;
+    }
+
+    PathPoint point;
+    LineOfSightParams los_params;
+    TroposcatterParams tropo;
+    PathContextPoint(context, d__km, &point, &los_params, &tropo);
+
+    if (point.propagation_mode != PROP_MODE__LOS)
+        result->warnings |= context->warnings;
+
+    PathPointResult(&context->terminal_1, &context->terminal_2, context->f__mhz, &point, p, result);
+
+    if (result->warnings == WARNING__NO_WARNINGS)
+        return SUCCESS;
+    else
+        return SUCCESS_WITH_WARNINGS;
+}
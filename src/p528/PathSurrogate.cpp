@@ -0,0 +1,259 @@
+#include <math.h>
+#include "../../include/p528.h"
+
+/*=============================================================================
+ |
+ |  Description:  Evaluates a Chebyshev series using Clenshaw's recurrence
+ |
+ |        Input:  c             - Chebyshev coefficients
+ |                order         - Order of the series
+ |                x             - Point, in [-1, 1]
+ |
+ |      Returns:  Value of the series
+ |
+ *===========================================================================*/
+static double Clenshaw(const double* c, int order, double x)
+{
+    double b_1 = 0;
+    double b_2 = 0;
+    for (int k = order; k >= 1; k--)
+    {
+        double b_0 = 2 * x * b_1 - b_2 + c[k];
+        b_2 = b_1;
+        b_1 = b_0;
+    }
+
+    return x * b_1 - b_2 + c[0];
+}
+
+/*=============================================================================
+ |
+ |  Description:  Evaluates the Chebyshev series of a surrogate segment
+ |
+ |        Input:  segment       - Surrogate segment
+ |                d__km         - Path distance, in km
+ |
+ |      Returns:  A__db         - Loss, in dB
+ |
+ *===========================================================================*/
+double EvaluateChebyshev(const SurrogateSegment* segment, double d__km)
+{
+    double x = (2 * d__km - segment->d_min__km - segment->d_max__km) / (segment->d_max__km - segment->d_min__km);
+
+    return Clenshaw(segment->c, SURROGATE__ORDER, x);
+}
+
+/*=============================================================================
+ |
+ |  Description:  Fits a Chebyshev series to the loss over a range of
+ |                distances.  A fit of twice the order is made at its
+ |                Chebyshev nodes and truncated to SURROGATE__ORDER.  Since
+ |                |T_k| <= 1, the sum of the dropped coefficients bounds the
+ |                difference between the two fits everywhere in the range.
+ |                The error of the higher-order fit itself is sampled on a
+ |                grid between its nodes and added to the bound
+ |
+ |        Input:  context       - Path context
+ |                p             - Time percentage
+ |                d_min__km     - Start of the range, in km
+ |                d_max__km     - End of the range, in km
+ |
+ |      Outputs:  segment       - Surrogate segment
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void FitSurrogateSegment(const PathContext* context, double p, double d_min__km, double d_max__km,
+    SurrogateSegment* segment)
+{
+    const int N = 2 * (SURROGATE__ORDER + 1);
+
+    segment->d_min__km = d_min__km;
+    segment->d_max__km = d_max__km;
+
+    double d_mid__km = (d_min__km + d_max__km) / 2;
+    double d_half__km = (d_max__km - d_min__km) / 2;
+
+    // loss at the Chebyshev nodes of the higher-order fit
+    double A__db[2 * (SURROGATE__ORDER + 1)];
+    for (int j = 0; j < N; j++)
+    {
+        double d__km = d_mid__km + d_half__km * cos(PI * (j + 0.5) / N);
+        EvaluatePathLosses(context, d__km, &p, 1, &A__db[j]);
+    }
+
+    double c[2 * (SURROGATE__ORDER + 1)];
+    for (int k = 0; k < N; k++)
+    {
+        double sum = 0;
+        for (int j = 0; j < N; j++)
+            sum += A__db[j] * cos(PI * k * (j + 0.5) / N);
+
+        c[k] = 2.0 * sum / N;
+    }
+    c[0] /= 2;
+
+    // truncate, and bound what was dropped
+    double tail__db = 0;
+    for (int k = 0; k < N; k++)
+    {
+        if (k <= SURROGATE__ORDER)
+            segment->c[k] = c[k];
+        else
+            tail__db += fabs(c[k]);
+    }
+
+    // sample the error of the higher-order fit.  The end points are left out
+    // so that a segment ending at the horizon is never checked against the
+    // other mode
+    double residual__db = 0;
+    int M = N + 1;
+    for (int i = 0; i < M; i++)
+    {
+        double d__km = d_min__km + (i + 0.5) * (d_max__km - d_min__km) / M;
+
+        double A_direct__db;
+        EvaluatePathLosses(context, d__km, &p, 1, &A_direct__db);
+
+        double x = (d__km - d_mid__km) / d_half__km;
+        residual__db = MAX(residual__db, fabs(Clenshaw(c, N - 1, x) - A_direct__db));
+    }
+
+    segment->error__db = tail__db + residual__db;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Fits a piecewise Chebyshev surrogate of the loss versus
+ |                distance, for a single time percentage, from d_0 out to
+ |                d_max__km.  Breakpoints are placed at d_ML and d_crx, and
+ |                the segment with the largest error is halved until the
+ |                tolerance or the segment limit is met.  The two-ray region
+ |                short of d_0 is not fitted
+ |
+ |        Input:  context       - Path context, from P528_InitPathContext()
+ |                p             - Time percentage
+ |                d_max__km     - End of the surrogate, in km
+ |                tolerance__db - Target maximum error, in dB
+ |
+ |      Outputs:  surrogate     - Surrogate
+ |
+ |      Returns:  rtn           - SUCCESS or error code
+ |
+ *===========================================================================*/
+int P528_InitPathSurrogate(const PathContext* context, double p, double d_max__km,
+    double tolerance__db, PathSurrogate* surrogate)
+{
+    int warnings = WARNING__NO_WARNINGS;
+    int err = ValidateInputs(d_max__km, context->h_1__meter, context->h_2__meter, context->f__mhz,
+        context->T_pol, p, &warnings);
+    if (err != SUCCESS && err != ERROR_HEIGHT_AND_DISTANCE)
+        return err;
+
+    surrogate->p = p;
+    surrogate->segment_count = 0;
+
+    // P528 switches to the transhorizon models within 1 m of d_ML
+    double d_horizon__km = context->path.d_ML__km - 0.001;
+
+    double breakpoints[4] = {
+        context->path.d_0__km,
+        d_horizon__km,
+        MAX(context->d_crx__km, d_horizon__km),
+        d_max__km };
+
+    for (int i = 0; i < 3; i++)
+    {
+        double d_min__km = breakpoints[i];
+        double d_end__km = MIN(breakpoints[i + 1], d_max__km);
+
+        if (d_end__km > d_min__km)
+            FitSurrogateSegment(context, p, d_min__km, d_end__km, &surrogate->segments[surrogate->segment_count++]);
+    }
+
+    // halve the segment with the largest error until every segment is within
+    // tolerance, or the segment limit is reached
+    while (surrogate->segment_count < SURROGATE__MAX_SEGMENTS)
+    {
+        int worst = -1;
+        for (int i = 0; i < surrogate->segment_count; i++)
+        {
+            const SurrogateSegment* segment = &surrogate->segments[i];
+            if (segment->error__db > tolerance__db
+                && segment->d_max__km - segment->d_min__km > 2 * SURROGATE__MIN_LENGTH__KM
+                && (worst < 0 || segment->error__db > surrogate->segments[worst].error__db))
+                worst = i;
+        }
+
+        if (worst < 0)
+            break;
+
+        for (int i = surrogate->segment_count; i > worst + 1; i--)
+            surrogate->segments[i] = surrogate->segments[i - 1];
+        surrogate->segment_count++;
+
+        double d_min__km = surrogate->segments[worst].d_min__km;
+        double d_end__km = surrogate->segments[worst].d_max__km;
+        double d_mid__km = (d_min__km + d_end__km) / 2;
+        FitSurrogateSegment(context, p, d_min__km, d_mid__km, &surrogate->segments[worst]);
+        FitSurrogateSegment(context, p, d_mid__km, d_end__km, &surrogate->segments[worst + 1]);
+    }
+
+    if (surrogate->segment_count > 0)
+    {
+        surrogate->d_min__km = surrogate->segments[0].d_min__km;
+        surrogate->d_max__km = surrogate->segments[surrogate->segment_count - 1].d_max__km;
+    }
+    else
+    {
+        surrogate->d_min__km = 0;
+        surrogate->d_max__km = 0;
+    }
+
+    return SUCCESS;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Computes the loss from a path surrogate.  Distances outside
+ |                of the surrogate are evaluated directly
+ |
+ |        Input:  context       - Path context
+ |                surrogate     - Surrogate, from P528_InitPathSurrogate()
+ |                d__km         - Path distance, in km
+ |
+ |      Outputs:  A__db         - Loss, in dB
+ |                error__db     - Error bound of the segment, in dB
+ |
+ |      Returns:  rtn           - SUCCESS or error code
+ |
+ *===========================================================================*/
+int P528_Surrogate(const PathContext* context, const PathSurrogate* surrogate, double d__km,
+    double* A__db, double* error__db)
+{
+    if (d__km < 0)
+        return ERROR_VALIDATION__D_KM;
+
+    if (surrogate->segment_count == 0 || d__km < surrogate->d_min__km || d__km > surrogate->d_max__km)
+    {
+        *error__db = 0;
+        return EvaluatePathLosses(context, d__km, &surrogate->p, 1, A__db);
+    }
+
+    // segments are contiguous and in order of distance
+    int lower = 0;
+    int upper = surrogate->segment_count - 1;
+    while (lower < upper)
+    {
+        int middle = (lower + upper) / 2;
+        if (d__km > surrogate->segments[middle].d_max__km)
+            lower = middle + 1;
+        else
+            upper = middle;
+    }
+
+    *A__db = EvaluateChebyshev(&surrogate->segments[lower], d__km);
+    *error__db = surrogate->segments[lower].error__db;
+
+    return SUCCESS;
+}
@@ -0,0 +1,258 @@
+#include <math.h>
+#include "../../include/p528.h"
+
+/*=============================================================================
+ |
+ |  Description:  Loss of a path context at a distance
+ |
+ |        Input:  d__km         - Path distance, in km
+ |
+ |      Returns:  A__db         - Loss, in dB
+ |
+ *===========================================================================*/
+double DistanceLoss::operator()(double d__km) const
+{
+    double A__db;
+    EvaluatePathLosses(context, d__km, &p, 1, &A__db);
+
+    return A__db;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Finds where the loss crosses a threshold, between two
+ |                points that bracket the crossing, using the Illinois
+ |                variant of regula falsi
+ |
+ |        Input:  loss          - Loss versus the search variable
+ |                L__db         - Loss threshold, in dB
+ |                x_a           - First point
+ |                A_a__db       - Loss at the first point, in dB
+ |                x_b           - Second point
+ |                A_b__db       - Loss at the second point, in dB
+ |                tolerance     - Width of the final bracket
+ |
+ |      Returns:  x             - The end of the final bracket that meets
+ |                                the threshold
+ |
+ *===========================================================================*/
+template<typename Loss>
+double FindLossCrossing(const Loss& loss, double L__db, double x_a, double A_a__db, double x_b, double A_b__db,
+    double tolerance)
+{
+    double f_a = A_a__db - L__db;
+    double f_b = A_b__db - L__db;
+    int side = 0;
+
+    for (int i = 0; i < 100 && fabs(x_b - x_a) > tolerance; i++)
+    {
+        double x = (f_a == f_b) ? (x_a + x_b) / 2 : x_b - f_b * (x_b - x_a) / (f_b - f_a);
+
+        double f = loss(x) - L__db;
+        if (f == 0)
+            return x;
+
+        if ((f > 0) == (f_b > 0))
+        {
+            x_b = x;
+            f_b = f;
+            if (side == -1)
+                f_a /= 2;
+            side = -1;
+        }
+        else
+        {
+            x_a = x;
+            f_a = f;
+            if (side == 1)
+                f_b /= 2;
+            side = 1;
+        }
+    }
+
+    return (f_a <= 0) ? x_a : x_b;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Computes the maximum distance at which the loss does not
+ |                exceed a threshold.  Short of d_0, the two-ray lobe makes
+ |                the loss non-monotonic, so the region is sampled and every
+ |                crossing is refined.  Beyond d_0 the loss increases with
+ |                distance, so the crossing is bracketed by doubling steps
+ |                and refined once
+ |
+ |        Input:  h_1__meter    - Height of the low terminal, in meters
+ |                h_2__meter    - Height of the high terminal, in meters
+ |                f__mhz        - Frequency, in MHz
+ |                T_pol         - Code indicating either polarization
+ |                                  + 0 : POLARIZATION__HORIZONTAL
+ |                                  + 1 : POLARIZATION__VERTICAL
+ |                p             - Time percentage
+ |                L__db         - Loss threshold, in dB
+ |                d_max__km     - Largest distance of interest, in km
+ |                capacity      - Number of intervals intervals__km can hold
+ |
+ |      Outputs:  d__km         - Maximum distance, in km
+ |                intervals__km - Pairs of start and end distances of the
+ |                                intervals where the loss does not exceed
+ |                                the threshold, in increasing order.  The
+ |                                last interval ends at d__km
+ |                count         - Number of intervals
+ |
+ |      Returns:  rtn           - SUCCESS or error code
+ |
+ *===========================================================================*/
+int P528_RangeForLoss(double h_1__meter, double h_2__meter, double f__mhz, int T_pol, double p,
+    double L__db, double d_max__km, double* d__km, double* intervals__km, int capacity, int* count)
+{
+    *d__km = 0;
+    *count = 0;
+
+    int warnings = WARNING__NO_WARNINGS;
+    int err = ValidateInputs(d_max__km, h_1__meter, h_2__meter, f__mhz, T_pol, p, &warnings);
+    if (err != SUCCESS && err != ERROR_HEIGHT_AND_DISTANCE)
+        return err;
+
+    PathContext context;
+    InitPathGeometry(h_1__meter, h_2__meter, f__mhz, T_pol, &context);
+    InitPathTranshorizon(&context);
+
+    DistanceLoss loss = { &context, p };
+
+    double d_0__km = MIN(context.path.d_0__km, d_max__km);
+
+    /////////////////////////////////////////////
+    // Line-of-sight region, short of d_0
+    //
+
+    // Closer in than psi_limit the loss follows free space, so a few samples
+    // are enough.  Between psi_limit and d_0, the last lobe of the two-ray
+    // model is sampled at even steps of the ray length difference
+    LineOfSightParams params_limit, params_0;
+    RayOptics(&context.terminal_1, &context.terminal_2, context.psi_limit, &params_limit);
+    double d_limit__km = MIN(params_limit.d__km, d_0__km);
+
+    double psi_0 = FindPsiAtDistance(d_0__km, &context.path, &context.terminal_1, &context.terminal_2);
+    RayOptics(&context.terminal_1, &context.terminal_2, psi_0, &params_0);
+
+    double terminate = (0.2997925 / f__mhz) / 1e6;
+
+    vector<double> d_sampled__km;
+    for (int i = 0; i < INVERSE__FREE_SPACE_SAMPLES; i++)
+        d_sampled__km.push_back(i * d_limit__km / INVERSE__FREE_SPACE_SAMPLES);
+
+    if (d_0__km > d_limit__km)
+    {
+        double delta_r_step__km = (params_limit.delta_r__km - params_0.delta_r__km) / INVERSE__TWO_RAY_SAMPLES;
+        for (int i = 0; i < INVERSE__TWO_RAY_SAMPLES; i++)
+        {
+            double delta_r__km = params_limit.delta_r__km - i * delta_r_step__km;
+            double psi = FindPsiAtDeltaR(delta_r__km, &context.path, &context.terminal_1, &context.terminal_2, terminate);
+
+            LineOfSightParams params;
+            RayOptics(&context.terminal_1, &context.terminal_2, psi, &params);
+            d_sampled__km.push_back(MIN(MAX(params.d__km, d_sampled__km.back()), d_0__km));
+        }
+    }
+    d_sampled__km.push_back(d_0__km);
+
+    int N = (int)d_sampled__km.size() - 1;
+    vector<double> A_sampled__db(N + 1);
+    for (int i = 0; i <= N; i++)
+    {
+        err = EvaluatePathLosses(&context, d_sampled__km[i], &p, 1, &A_sampled__db[i]);
+        if (err != SUCCESS)
+            return err;
+    }
+
+    double d_start__km = -1;
+    if (A_sampled__db[0] <= L__db)
+        d_start__km = 0;
+
+    for (int i = 1; i <= N; i++)
+    {
+        bool below_prev = A_sampled__db[i - 1] <= L__db;
+        bool below = A_sampled__db[i] <= L__db;
+        if (below_prev == below)
+            continue;
+
+        double d_cross__km = FindLossCrossing(loss, L__db, d_sampled__km[i - 1], A_sampled__db[i - 1],
+            d_sampled__km[i], A_sampled__db[i], INVERSE__TOLERANCE__KM);
+
+        if (below)
+            d_start__km = d_cross__km;
+        else
+        {
+            if (*count < capacity)
+            {
+                intervals__km[2 * *count] = d_start__km;
+                intervals__km[2 * *count + 1] = d_cross__km;
+            }
+            (*count)++;
+            *d__km = d_cross__km;
+            d_start__km = -1;
+        }
+    }
+
+    //
+    // Line-of-sight region, short of d_0
+    /////////////////////////////////////////////
+
+    /////////////////////////////////////////////
+    // Monotonic region beyond d_0
+    //
+
+    if (d_start__km >= 0)
+    {
+        double d_end__km = d_0__km;
+        double d_prev__km = d_0__km;
+        double A_prev__db = A_sampled__db[N];
+        double d_step__km = CURVE__INITIAL_STEP__KM;
+
+        while (d_end__km < d_max__km)
+        {
+            double d_next__km = MIN(d_prev__km + d_step__km, d_max__km);
+
+            double A_next__db;
+            err = EvaluatePathLosses(&context, d_next__km, &p, 1, &A_next__db);
+            if (err != SUCCESS)
+                return err;
+
+            if (A_next__db > L__db)
+            {
+                d_end__km = FindLossCrossing(loss, L__db, d_prev__km, A_prev__db, d_next__km, A_next__db,
+                    INVERSE__TOLERANCE__KM);
+                break;
+            }
+
+            d_prev__km = d_next__km;
+            A_prev__db = A_next__db;
+            d_end__km = d_next__km;
+            d_step__km *= 2;
+        }
+
+        if (*count < capacity)
+        {
+            intervals__km[2 * *count] = d_start__km;
+            intervals__km[2 * *count + 1] = d_end__km;
+        }
+        (*count)++;
+        *d__km = d_end__km;
+    }
+
+    //
+    // Monotonic region beyond d_0
+    /////////////////////////////////////////////
+
+    if (*count == 0)
+        return ERROR_INVERSE__NO_SOLUTION;
+
+    return SUCCESS;
+}
+
+// Supported loss functions
+template double FindLossCrossing<DistanceLoss>(const DistanceLoss& loss, double L__db, double x_a, double A_a__db,
+    double x_b, double A_b__db, double tolerance);
+template double FindLossCrossing<HeightLoss>(const HeightLoss& loss, double L__db, double x_a, double A_a__db,
+    double x_b, double A_b__db, double tolerance);
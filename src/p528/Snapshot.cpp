@@ -0,0 +1,242 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/p528.h"
+
+/*=============================================================================
+ |
+ |  Description:  Fills the header of a snapshot.  The header keys the
+ |                snapshot on the library version, the record layout and the
+ |                model constants:
+ |
+ |                   0  char[8]   magic, "P528SNAP"
+ |                   8  uint32    format version
+ |                  12  uint32    library version, major << 16 | minor
+ |                  16  uint32    content
+ |                  20  uint32    record size, in bytes
+ |                  24  uint32    byte order marker, in host order
+ |                  28  uint32    reserved
+ |                  32  double    N_s
+ |                  40  double    epsilon_r
+ |                  48  double    sigma
+ |                  56  double    a_0__km
+ |                  64  double    a_e__km
+ |                  72  uint64    number of records
+ |                  80  uint64    FNV-1a checksum of the records
+ |
+ |        Input:  content       - Content code
+ |                record_size   - Size of each record, in bytes
+ |                count         - Number of records
+ |
+ |      Outputs:  header        - Snapshot header
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void SnapshotHeader(int content, size_t record_size, unsigned long long count, unsigned char* header)
+{
+    double constants[5] = { N_s, epsilon_r, sigma, a_0__km, a_e__km };
+
+    memset(header, 0, SNAPSHOT__HEADER_SIZE);
+    memcpy(header, SNAPSHOT__MAGIC, 8);
+    PackU32(header + 8, SNAPSHOT__FORMAT_VERSION);
+    PackU32(header + 12, (P528_VERSION_MAJOR << 16) | P528_VERSION_MINOR);
+    PackU32(header + 16, content);
+    PackU32(header + 20, (unsigned int)record_size);
+
+    unsigned int byte_order = SNAPSHOT__BYTE_ORDER;
+    memcpy(header + 24, &byte_order, 4);
+
+    for (int i = 0; i < 5; i++)
+    {
+        unsigned long long value;
+        memcpy(&value, &constants[i], 8);
+        PackU64(header + 32 + 8 * i, value);
+    }
+
+    PackU64(header + 72, count);
+}
+
+/*=============================================================================
+ |
+ |  Description:  Writes an array of records to a snapshot file
+ |
+ |        Input:  content       - Content code
+ |                record_size   - Size of each record, in bytes
+ |                records       - Array of records
+ |                count         - Number of records
+ |                filename      - Path of the snapshot
+ |
+ |      Returns:  rtn           - SUCCESS or ERROR_PACK__IO
+ |
+ *===========================================================================*/
+int WriteSnapshot(int content, size_t record_size, const void* records, int count, const char* filename)
+{
+    size_t payload_size = record_size * count;
+
+    unsigned char header[SNAPSHOT__HEADER_SIZE];
+    SnapshotHeader(content, record_size, count, header);
+    PackU64(header + 80, PackChecksum((const unsigned char*)records, payload_size));
+
+    FILE* fp = fopen(filename, "wb");
+    if (fp == NULL)
+        return ERROR_PACK__IO;
+
+    size_t written = fwrite(header, 1, SNAPSHOT__HEADER_SIZE, fp);
+    if (payload_size > 0)
+        written += fwrite(records, 1, payload_size, fp);
+    int closed = fclose(fp);
+
+    if (written != SNAPSHOT__HEADER_SIZE + payload_size || closed != 0)
+        return ERROR_PACK__IO;
+
+    return SUCCESS;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Restores an array of records from a snapshot file.  The
+ |                snapshot is rejected unless it was written by the same
+ |                library version, with the same model constants, record
+ |                layout and byte order
+ |
+ |        Input:  filename      - Path of the snapshot
+ |                content       - Content code
+ |                record_size   - Size of each record, in bytes
+ |                capacity      - Number of records the array can hold
+ |
+ |      Outputs:  records       - Array of records
+ |                count         - Number of records in the snapshot
+ |
+ |      Returns:  rtn           - SUCCESS or error code
+ |
+ *===========================================================================*/
+int ReadSnapshot(const char* filename, int content, size_t record_size, void* records, int capacity, int* count)
+{
+    *count = 0;
+
+    size_t size;
+    unsigned char* bytes = (unsigned char*)MapPack(filename, &size);
+    if (bytes == NULL)
+        return ERROR_PACK__IO;
+
+    if (size < SNAPSHOT__HEADER_SIZE ||
+        memcmp(bytes, SNAPSHOT__MAGIC, 8) != 0 ||
+        UnpackU32(bytes + 8) != SNAPSHOT__FORMAT_VERSION ||
+        UnpackU32(bytes + 16) != (unsigned int)content)
+    {
+        UnmapPack(bytes, size);
+        return ERROR_PACK__FORMAT;
+    }
+
+    // everything else in the header must match exactly
+    unsigned long long stored_count = UnpackU64(bytes + 72);
+    unsigned char expected[SNAPSHOT__HEADER_SIZE];
+    SnapshotHeader(content, record_size, stored_count, expected);
+    if (memcmp(bytes, expected, 80) != 0)
+    {
+        UnmapPack(bytes, size);
+        return ERROR_SNAPSHOT__MISMATCH;
+    }
+
+    size_t payload_size = record_size * stored_count;
+    if (size != SNAPSHOT__HEADER_SIZE + payload_size)
+    {
+        UnmapPack(bytes, size);
+        return ERROR_PACK__FORMAT;
+    }
+
+    const unsigned char* payload = bytes + SNAPSHOT__HEADER_SIZE;
+    if (PackChecksum(payload, payload_size) != UnpackU64(bytes + 80))
+    {
+        UnmapPack(bytes, size);
+        return ERROR_PACK__CHECKSUM;
+    }
+
+    *count = (int)stored_count;
+    if (stored_count > (unsigned long long)capacity)
+    {
+        UnmapPack(bytes, size);
+        return ERROR_SNAPSHOT__CAPACITY;
+    }
+
+    if (payload_size > 0)
+        memcpy(records, payload, payload_size);
+    UnmapPack(bytes, size);
+
+    return SUCCESS;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Saves path contexts to a snapshot file, so that a restarted
+ |                process can restore them without recomputing the terminal
+ |                geometries and the transhorizon search
+ |
+ |        Input:  contexts      - Array of path contexts
+ |                count         - Number of path contexts
+ |                filename      - Path of the snapshot
+ |
+ |      Returns:  rtn           - SUCCESS or error code
+ |
+ *===========================================================================*/
+int P528_WriteContextSnapshot(const PathContext* contexts, int count, const char* filename)
+{
+    return WriteSnapshot(SNAPSHOT__CONTENT_PATH_CONTEXTS, sizeof(PathContext), contexts, count, filename);
+}
+
+/*=============================================================================
+ |
+ |  Description:  Restores path contexts from a snapshot file.  If capacity
+ |                is too small, ERROR_SNAPSHOT__CAPACITY is returned with the
+ |                required count
+ |
+ |        Input:  filename      - Path of the snapshot
+ |                capacity      - Number of path contexts the array can hold
+ |
+ |      Outputs:  contexts      - Array of path contexts
+ |                count         - Number of path contexts in the snapshot
+ |
+ |      Returns:  rtn           - SUCCESS or error code
+ |
+ *===========================================================================*/
+int P528_ReadContextSnapshot(const char* filename, PathContext* contexts, int capacity, int* count)
+{
+    return ReadSnapshot(filename, SNAPSHOT__CONTENT_PATH_CONTEXTS, sizeof(PathContext), contexts, capacity, count);
+}
+
+/*=============================================================================
+ |
+ |  Description:  Saves path surrogates to a snapshot file
+ |
+ |        Input:  surrogates    - Array of path surrogates
+ |                count         - Number of path surrogates
+ |                filename      - Path of the snapshot
+ |
+ |      Returns:  rtn           - SUCCESS or error code
+ |
+ *===========================================================================*/
+int P528_WriteSurrogateSnapshot(const PathSurrogate* surrogates, int count, const char* filename)
+{
+    return WriteSnapshot(SNAPSHOT__CONTENT_PATH_SURROGATES, sizeof(PathSurrogate), surrogates, count, filename);
+}
+
+/*=============================================================================
+ |
+ |  Description:  Restores path surrogates from a snapshot file.  If
+ |                capacity is too small, ERROR_SNAPSHOT__CAPACITY is returned
+ |                with the required count
+ |
+ |        Input:  filename      - Path of the snapshot
+ |                capacity      - Number of path surrogates the array can hold
+ |
+ |      Outputs:  surrogates    - Array of path surrogates
+ |                count         - Number of path surrogates in the snapshot
+ |
+ |      Returns:  rtn           - SUCCESS or error code
+ |
+ *===========================================================================*/
+int P528_ReadSurrogateSnapshot(const char* filename, PathSurrogate* surrogates, int capacity, int* count)
+{
+    return ReadSnapshot(filename, SNAPSHOT__CONTENT_PATH_SURROGATES, sizeof(PathSurrogate), surrogates, capacity, count);
+}
@@ -0,0 +1,248 @@
+#include <map>
+#include <math.h>
+#include "../../include/p528.h"
+#include "../../include/p676.h"
+
+// Path context of one high terminal height of a trajectory, with the ray
+// trace layers of its line-of-sight slant path once they are needed
+struct TrajectoryHeight
+{
+    PathContext context;
+    RayLayers layers;
+};
+
+// Heights cached by a trajectory.  Consecutive samples usually share a
+// height, so the last one is checked before the map
+struct TrajectoryCache
+{
+    map<double, TrajectoryHeight> heights;
+    TrajectoryHeight* last = NULL;
+};
+
+/*=============================================================================
+ |
+ |  Description:  Finds the cached height of a trajectory, or computes its
+ |                path context: the high terminal geometry and the terms of
+ |                Steps 2 through 4.  The transhorizon terms are left until
+ |                a sample needs them.  The cache is cleared when full
+ |
+ |        Input:  trajectory    - Trajectory
+ |                h_2__meter    - Height of the high terminal, in meters
+ |
+ |      Returns:  Cached height
+ |
+ *===========================================================================*/
+static TrajectoryHeight* TrajectoryHeightFor(Trajectory* trajectory, double h_2__meter)
+{
+    TrajectoryCache* cache = (TrajectoryCache*)trajectory->storage;
+    if (cache->last != NULL && cache->last->context.h_2__meter == h_2__meter)
+        return cache->last;
+
+    map<double, TrajectoryHeight>::iterator it = cache->heights.find(h_2__meter);
+    if (it != cache->heights.end())
+    {
+        cache->last = &it->second;
+        return cache->last;
+    }
+
+    if (cache->heights.size() >= TRAJECTORY__CACHE_HEIGHTS)
+        cache->heights.clear();
+
+    TrajectoryHeight* height = &cache->heights[h_2__meter];
+    PathContext* context = &height->context;
+    context->h_1__meter = trajectory->h_1__meter;
+    context->h_2__meter = h_2__meter;
+    context->f__mhz = trajectory->f__mhz;
+    context->T_pol = trajectory->T_pol;
+    context->transhorizon = false;
+    context->warnings = WARNING__NO_WARNINGS;
+
+    // Step 1, for the high terminal only
+    context->terminal_1 = trajectory->terminal_1;
+    context->terminal_2.h_r__km = h_2__meter / 1000;
+    TerminalGeometry(trajectory->f__mhz, &context->terminal_2);
+
+    InitPathLine(context);
+
+    cache->last = height;
+    return height;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Rounds a valid high terminal height to a multiple of the
+ |                height quantum.  The rounded height is kept within the
+ |                limits that the given height met: no lower than the low
+ |                terminal or 1.5 m, and no higher than 20 000 m unless the
+ |                given height was already above it
+ |
+ |        Input:  h_1__meter        - Height of the low terminal, in meters
+ |                h_2__meter        - Height of the high terminal, in meters
+ |                h_quantum__meter  - Height quantum, in meters, or 0 to
+ |                                    keep the height as given
+ |
+ |      Returns:  h_2__meter        - Rounded height, in meters
+ |
+ *===========================================================================*/
+double QuantizeHeight(double h_1__meter, double h_2__meter, double h_quantum__meter)
+{
+    if (!(h_quantum__meter > 0))
+        return h_2__meter;
+
+    double h_rounded__meter = round(h_2__meter / h_quantum__meter) * h_quantum__meter;
+    double h_max__meter = (h_2__meter <= 20000) ? 20000 : 80000;
+
+    return MIN(MAX(h_rounded__meter, MAX(h_1__meter, 1.5)), h_max__meter);
+}
+
+/*=============================================================================
+ |
+ |  Description:  Starts a trajectory against a fixed low terminal
+ |
+ |        Input:  h_1__meter        - Height of the low terminal, in meters
+ |                f__mhz            - Frequency, in MHz
+ |                T_pol             - Code indicating either polarization
+ |                                      + 0 : POLARIZATION__HORIZONTAL
+ |                                      + 1 : POLARIZATION__VERTICAL
+ |                h_quantum__meter  - High terminal heights are rounded to
+ |                                    a multiple of this, so that nearby
+ |                                    samples share a path context, or 0 to
+ |                                    use each height as given
+ |
+ |      Outputs:  trajectory        - Trajectory, to be freed with
+ |                                    P528_FreeTrajectory()
+ |
+ |      Returns:  rtn               - SUCCESS or error code
+ |
+ *===========================================================================*/
+int P528_InitTrajectory(double h_1__meter, double f__mhz, int T_pol, double h_quantum__meter,
+    Trajectory* trajectory)
+{
+    trajectory->storage = NULL;
+
+    // validate with a distance, high terminal and percentage that are always in range
+    int warnings = WARNING__NO_WARNINGS;
+    int err = ValidateInputs(1, h_1__meter, h_1__meter, f__mhz, T_pol, 50, &warnings);
+    if (err != SUCCESS)
+        return err;
+
+    trajectory->h_1__meter = h_1__meter;
+    trajectory->f__mhz = f__mhz;
+    trajectory->T_pol = T_pol;
+    trajectory->h_quantum__meter = MAX(h_quantum__meter, 0);
+    trajectory->psi = 0;
+
+    // Step 1 for low terminal
+    trajectory->terminal_1.h_r__km = h_1__meter / 1000;
+    TerminalGeometry(f__mhz, &trajectory->terminal_1);
+
+    trajectory->storage = new TrajectoryCache();
+
+    return SUCCESS;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Computes P.528 for the next sample of a trajectory.  The
+ |                path context of the sample's height is reused from the
+ |                cache, line-of-sight samples trace their slant path
+ |                through the cached layers, and the psi search starts from
+ |                the previous line-of-sight sample.  Results match P528()
+ |                for the rounded height, to within the 1 m distance
+ |                tolerance of the psi search.  Inputs are validated before
+ |                the height is rounded, see QuantizeHeight()
+ |
+ |        Input:  trajectory    - Trajectory, from P528_InitTrajectory()
+ |                d__km         - Path distance, in km
+ |                h_2__meter    - Height of the high terminal, in meters
+ |                p             - Time percentage
+ |
+ |      Outputs:  result        - Result structure
+ |
+ |      Returns:  rtn           - SUCCESS or error code
+ |
+ *===========================================================================*/
+int P528_Trajectory(Trajectory* trajectory, double d__km, double h_2__meter, double p, Result* result)
+{
+    // reset Results struct
+    result->A_fs__db = 0;
+    result->A_a__db = 0;
+    result->A__db = 0;
+    result->d__km = 0;
+    result->theta_h1__rad = 0;
+    result->propagation_mode = PROP_MODE__NOT_SET;
+    result->warnings = WARNING__NO_WARNINGS;
+
+    int err = ValidateInputs(d__km, trajectory->h_1__meter, h_2__meter, trajectory->f__mhz, trajectory->T_pol, p,
+        &result->warnings);
+    if (err != SUCCESS)
+    {
+        if (err == ERROR_HEIGHT_AND_DISTANCE)
+            return SUCCESS;
+        else
+            return err;
+    }
+
+    h_2__meter = QuantizeHeight(trajectory->h_1__meter, h_2__meter, trajectory->h_quantum__meter);
+
+    // rounding onto the low terminal at zero distance puts both at the same point
+    if (h_2__meter == trajectory->h_1__meter && d__km == 0)
+        return SUCCESS;
+
+    TrajectoryHeight* height = TrajectoryHeightFor(trajectory, h_2__meter);
+    PathContext* context = &height->context;
+
+    // the model functions take non-const pointers, so work on local copies
+    Path path = context->path;
+    Terminal terminal_1 = context->terminal_1;
+    Terminal terminal_2 = context->terminal_2;
+
+    PathPoint point;
+    if (path.d_ML__km - d__km > 0.001)
+    {
+        if (height->layers.n.empty())
+            InitRayLayers<GlobalAtmosphere>(context->f__mhz / 1000, terminal_1.h_r__km, terminal_2.h_r__km,
+                GlobalAtmosphere(), &height->layers);
+
+        double psi = (trajectory->psi > 0)
+            ? FindPsiNearDistance(d__km, trajectory->psi, &terminal_1, &terminal_2)
+            : FindPsiAtDistance(d__km, &path, &terminal_1, &terminal_2);
+        trajectory->psi = psi;
+
+        LineOfSightParams los_params;
+        LineOfSightPsiPoint(&path, &terminal_1, &terminal_2, &los_params, context->f__mhz, -context->A_dML__db,
+            context->psi_limit, context->A_d_0__db, d__km, psi, context->T_pol, &height->layers, &point);
+    }
+    else
+    {
+        if (!context->transhorizon)
+            InitPathTranshorizon(context);
+
+        TroposcatterParams tropo;
+        TranshorizonPoint(context, &path, &terminal_1, &terminal_2, d__km, &tropo, &point);
+
+        result->warnings |= context->warnings;
+    }
+
+    PathPointResult(&context->terminal_1, &context->terminal_2, context->f__mhz, &point, p, result);
+
+    if (result->warnings == WARNING__NO_WARNINGS)
+        return SUCCESS;
+    else
+        return SUCCESS_WITH_WARNINGS;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Frees the heights cached by a trajectory
+ |
+ |        Input:  trajectory    - Trajectory, from P528_InitTrajectory()
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void P528_FreeTrajectory(Trajectory* trajectory)
+{
+    delete (TrajectoryCache*)trajectory->storage;
+    trajectory->storage = NULL;
+}
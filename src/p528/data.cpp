@@ -98,4 +98,91 @@ const vector<int> data::K =
 
 // Percentages for interpolation and data tables
 const vector<double> data::P = { 1, 2, 5, 10, 15, 20, 30, 40, 50,
-    60, 70, 80, 85, 90, 95, 98, 99 };
\ No newline at end of file
+    60, 70, 80, 85, 90, 95, 98, 99 };
+
+/*=============================================================================
+ |
+ |  Description:  Resamples the Nakagami-Rice curves onto the uniform (K, p)
+ |                grid used by NakagamiRiceFast(), by bilinear interpolation
+ |                of the tables: between curves in K at the tabulated
+ |                percentages on either side of p, then in p.  K and p
+ |                outside of the tables take the nearest curve or
+ |                percentage.  Since the grid nodes include every tabulated
+ |                K and p, bilinear interpolation of the grid reproduces the
+ |                tables exactly
+ |
+ |      Returns:  grid      - Y_pi__db values, K-major
+ |
+ *===========================================================================*/
+static vector<double> ResampleNakagamiRiceCurves()
+{
+    vector<double> grid(NR_GRID__K_COUNT * NR_GRID__P_COUNT);
+
+    int n_K = (int)data::K.size();
+    int n_P = (int)data::P.size();
+
+    for (int i = 0; i < NR_GRID__K_COUNT; i++)
+    {
+        double K = NR_GRID__K_MIN + i;
+
+        // curves k_0 and k_1 = k_0 + 1 bracket K, with weight t_K on k_1
+        int k_0 = 0;
+        while (k_0 < n_K - 2 && data::K[k_0 + 1] <= K)
+            k_0++;
+        double t_K = MIN(MAX((K - data::K[k_0]) / (data::K[k_0 + 1] - data::K[k_0]), 0.0), 1.0);
+
+        for (int j = 0; j < NR_GRID__P_COUNT; j++)
+        {
+            double p = NR_GRID__P_MIN + j;
+
+            int p_0 = 0;
+            while (p_0 < n_P - 2 && data::P[p_0 + 1] <= p)
+                p_0++;
+            double t_p = MIN(MAX((p - data::P[p_0]) / (data::P[p_0 + 1] - data::P[p_0]), 0.0), 1.0);
+
+            double Y_0__db = data::NakagamiRiceCurves[k_0][p_0]
+                + t_K * (data::NakagamiRiceCurves[k_0 + 1][p_0] - data::NakagamiRiceCurves[k_0][p_0]);
+            double Y_1__db = data::NakagamiRiceCurves[k_0][p_0 + 1]
+                + t_K * (data::NakagamiRiceCurves[k_0 + 1][p_0 + 1] - data::NakagamiRiceCurves[k_0][p_0 + 1]);
+
+            grid[i * NR_GRID__P_COUNT + j] = Y_0__db + t_p * (Y_1__db - Y_0__db);
+        }
+    }
+
+    return grid;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Splits the range of Y_pi(99) into uniform buckets and
+ |                records the curve at or below the start of each bucket,
+ |                for use by FindKForYpiAt99PercentFast().  The buckets are
+ |                narrower than the closest pair of curves, so a lookup
+ |                needs at most one step past the recorded curve
+ |
+ |      Returns:  index     - Index into data::K for each bucket
+ |
+ *===========================================================================*/
+static vector<int> IndexYpiAt99Percent()
+{
+    double Y_min__db = data::NakagamiRiceCurves.front()[Y_pi_99_INDEX];
+    double Y_max__db = data::NakagamiRiceCurves.back()[Y_pi_99_INDEX];
+    double h__db = (Y_max__db - Y_min__db) / NR_GRID__Y_PI_99_BUCKETS;
+
+    vector<int> index(NR_GRID__Y_PI_99_BUCKETS);
+
+    int i = 0;
+    for (int b = 0; b < NR_GRID__Y_PI_99_BUCKETS; b++)
+    {
+        while (i < (int)data::K.size() - 2 && data::NakagamiRiceCurves[i + 1][Y_pi_99_INDEX] <= Y_min__db + b * h__db)
+            i++;
+
+        index[b] = i;
+    }
+
+    return index;
+}
+
+// Built at load time, after the tables above
+const vector<double> data::NakagamiRiceGrid = ResampleNakagamiRiceCurves();
+const vector<int> data::Y_pi_99Index = IndexYpiAt99Percent();
\ No newline at end of file
@@ -1,3 +1,4 @@
+#include <math.h>
 #include "../../include/p676.h"
 #include "../../include/p835.h"
 
@@ -21,41 +22,81 @@ double LayerThickness(double m, int i)
 
 /*=============================================================================
  |
- |  Description:  Traces the ray from terminal h_1 to terminal h_2 and
- |                computes results such as atmospheric absorption loss and
- |                ray path length.
+ |  Description:  Computes the layers of the ray trace between terminal h_1
+ |                and terminal h_2: their heights and the refractive index
+ |                and specific attenuation of each.  None of these depend on
+ |                the elevation angle, so the layers can be traced at any
+ |                number of angles
  |
  |        Input:  f__ghz        - Frequency, in GHz
  |                h_1__km       - Height of the low terminal, in km
  |                h_2__km       - Height of the high terminal, in km
- |                beta_1__rad   - Elevation angle (from zenith), in rad
- |                config        - Structure containing atmospheric params
+ |                atmosphere    - Atmosphere policy providing GetState()
  |
- |       Output:  result        - Ray trace result structure
+ |       Output:  layers        - Ray trace layers
  |
  |      Returns:  [void]
  |
  *===========================================================================*/
-void RayTrace(double f__ghz, double h_1__km, double h_2__km, double beta_1__rad,
-    RayTraceConfig config, SlantPathAttenuationResult* result)
+template<typename Atmosphere>
+void InitRayLayers(double f__ghz, double h_1__km, double h_2__km, const Atmosphere& atmosphere,
+    RayLayers* layers)
 {
     // Equations 16(a)-(c)
     int i_lower = floor(100 * log(1e4 * h_1__km * (exp(1. / 100.) - 1) + 1) + 1);
     int i_upper = ceil(100 * log(1e4 * h_2__km * (exp(1. / 100.) - 1) + 1) + 1);
     double m = ((exp(2. / 100.) - exp(1. / 100.)) / (exp(i_upper / 100.) - exp(i_lower / 100.))) * (h_2__km - h_1__km);
 
-    double gamma_i;
-    double gamma_ii;
+    layers->i_lower = i_lower;
+    layers->i_upper = i_upper;
+    layers->m = m;
+
+    int count = MAX(i_upper - i_lower + 1, 1);
+    layers->h__km.resize(count);
+    layers->n.resize(count);
+    layers->gamma.resize(count);
+
+    // starting layer
+    layers->h__km[0] = h_1__km + m * ((exp((i_lower - 1) / 100.) - exp((i_lower - 1) / 100.)) / (exp(1 / 100.) - 1));
+    GetLayerProperties<Atmosphere>(f__ghz, layers->h__km[0] + LayerThickness(m, i_lower) / 2, atmosphere,
+        &layers->n[0], &layers->gamma[0]);
+
+    for (int i = i_lower + 1; i <= i_upper; i++)
+    {
+        int k = i - i_lower;
+        layers->h__km[k] = h_1__km + m * ((exp((i - 1) / 100.) - exp((i_lower - 1) / 100.)) / (exp(1 / 100.) - 1));
+        GetLayerProperties<Atmosphere>(f__ghz, layers->h__km[k] + LayerThickness(m, i) / 2, atmosphere,
+            &layers->n[k], &layers->gamma[k]);
+    }
+}
+
+/*=============================================================================
+ |
+ |  Description:  Traces the ray through precomputed layers and computes
+ |                results such as atmospheric absorption loss and ray path
+ |                length.
+ |
+ |        Input:  layers        - Ray trace layers, from InitRayLayers()
+ |                beta_1__rad   - Elevation angle (from zenith), in rad
+ |
+ |       Output:  result        - Ray trace result structure
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+void TraceRayLayers(const RayLayers* layers, double beta_1__rad, SlantPathAttenuationResult* result)
+{
+    int i_lower = layers->i_lower;
+    int i_upper = layers->i_upper;
+    double m = layers->m;
+
     double n_i;
     double n_ii;
     double r_i__km;
     double r_ii__km;
-    double h_i__km;
-    double h_ii__km;
     double a_i__km;
     double alpha_i__rad = beta_1__rad;
     double delta_i__km;
-    double delta_ii__km;
     double beta_i__rad;
     double beta_ii__rad = beta_1__rad;
 
@@ -66,10 +107,8 @@ void RayTrace(double f__ghz, double h_1__km, double h_2__km, double beta_1__rad,
     result->delta_L__km = 0;
 
     // initialize starting layer
-    delta_i__km = LayerThickness(m, i_lower);
-    h_i__km = h_1__km + m * ((exp((i_lower - 1) / 100.) - exp((i_lower - 1) / 100.)) / (exp(1 / 100.) - 1));
-    GetLayerProperties(f__ghz, h_i__km + delta_i__km / 2, config, &n_i, &gamma_i);
-    r_i__km = a_0__km + h_i__km;
+    n_i = layers->n[0];
+    r_i__km = a_0__km + layers->h__km[0];
 
     // record bottom layer properties for alpha and beta calculations
     double r_1__km = r_i__km;
@@ -78,12 +117,10 @@ void RayTrace(double f__ghz, double h_1__km, double h_2__km, double beta_1__rad,
     // summation from Equation 13
     for (int i = i_lower; i <= i_upper - 1; i++)
     {
-        delta_ii__km = LayerThickness(m, i + 1);
-        h_ii__km = h_1__km + m * ((exp((i + 1 - 1) / 100.) - exp((i_lower - 1) / 100.)) / (exp(1 / 100.) - 1));
+        int k = i - i_lower;
 
-        GetLayerProperties(f__ghz, h_ii__km + delta_ii__km / 2, config, &n_ii, &gamma_ii);
-
-        r_ii__km = a_0__km + h_ii__km;
+        n_ii = layers->n[k + 1];
+        r_ii__km = a_0__km + layers->h__km[k + 1];
 
         delta_i__km = LayerThickness(m, i);
 
@@ -97,7 +134,7 @@ void RayTrace(double f__ghz, double h_1__km, double h_2__km, double beta_1__rad,
         a_i__km = -r_i__km * cos(beta_i__rad) + sqrt(pow(r_i__km, 2) * pow(cos(beta_i__rad), 2) + 2 * r_i__km * delta_i__km + pow(delta_i__km, 2));
 
         result->a__km += a_i__km;
-        result->A_gas__db += a_i__km * gamma_i;
+        result->A_gas__db += a_i__km * layers->gamma[k];
         result->delta_L__km += a_i__km * (n_i - 1);     // summation, Equation 23
 
         beta_ii__rad = asin(n_i / n_ii * sin(alpha_i__rad));
@@ -108,22 +145,58 @@ void RayTrace(double f__ghz, double h_1__km, double h_2__km, double beta_1__rad,
             result->bending__rad += beta_ii__rad - alpha_i__rad;
 
         // shift for next loop
-        h_i__km = h_ii__km;
         n_i = n_ii;
-        gamma_i = gamma_ii;
         r_i__km = r_ii__km;
     }
 
     result->angle__rad = alpha_i__rad;
 }
 
+/*=============================================================================
+ |
+ |  Description:  Traces the ray from terminal h_1 to terminal h_2 and
+ |                computes results such as atmospheric absorption loss and
+ |                ray path length.
+ |
+ |        Input:  f__ghz        - Frequency, in GHz
+ |                h_1__km       - Height of the low terminal, in km
+ |                h_2__km       - Height of the high terminal, in km
+ |                beta_1__rad   - Elevation angle (from zenith), in rad
+ |                atmosphere    - Atmosphere policy providing GetState()
+ |
+ |       Output:  result        - Ray trace result structure
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+template<typename Atmosphere>
+void RayTrace(double f__ghz, double h_1__km, double h_2__km, double beta_1__rad,
+    const Atmosphere& atmosphere, SlantPathAttenuationResult* result)
+{
+    RayLayers layers;
+    InitRayLayers<Atmosphere>(f__ghz, h_1__km, h_2__km, atmosphere, &layers);
+    TraceRayLayers(&layers, beta_1__rad, result);
+}
+
+/*=============================================================================
+ |
+ |  Description:  Traces the ray through a custom atmosphere given as
+ |                function pointers.  See the templated RayTrace()
+ |
+ *===========================================================================*/
+void RayTrace(double f__ghz, double h_1__km, double h_2__km, double beta_1__rad,
+    RayTraceConfig config, SlantPathAttenuationResult* result)
+{
+    RayTrace<RayTraceConfig>(f__ghz, h_1__km, h_2__km, beta_1__rad, config, result);
+}
+
 /*=============================================================================
  |
  |  Description:  Determine the parameters for the ith layer
  |
  |        Input:  f__ghz        - Frequency, in GHz
  |                h_i__km       - Height of the ith layer, in km
- |                config        - Structure containing atmospheric params
+ |                atmosphere    - Atmosphere policy providing GetState()
  |
  |       Output:  n             - Refractive index
  |                gamma         - Specific attenuation, in dB/km
@@ -131,17 +204,38 @@ void RayTrace(double f__ghz, double h_1__km, double h_2__km, double beta_1__rad,
  |      Returns:  [void]
  |
  *===========================================================================*/
-void GetLayerProperties(double f__ghz, double h_i__km, RayTraceConfig config,
+template<typename Atmosphere>
+void GetLayerProperties(double f__ghz, double h_i__km, const Atmosphere& atmosphere,
     double* n, double* gamma)
 {
-    // use function pointers to get atmospheric parameters
-    double T__kelvin = config.temperature(h_i__km);
-    double p__hPa = config.dry_pressure(h_i__km);
-    double e__hPa = config.wet_pressure(h_i__km);
+    double T__kelvin, p__hPa, e__hPa;
+    atmosphere.GetState(h_i__km, &T__kelvin, &p__hPa, &e__hPa);
 
     // compute the refractive index for the current layer
     *n = RefractiveIndex(p__hPa, T__kelvin, e__hPa);
 
     // specific attenuation of layer
     *gamma = SpecificAttenuation(f__ghz, T__kelvin, e__hPa, p__hPa);
-}
\ No newline at end of file
+}
+
+/*=============================================================================
+ |
+ |  Description:  Determine the parameters for the ith layer of a custom
+ |                atmosphere given as function pointers
+ |
+ *===========================================================================*/
+void GetLayerProperties(double f__ghz, double h_i__km, RayTraceConfig config,
+    double* n, double* gamma)
+{
+    GetLayerProperties<RayTraceConfig>(f__ghz, h_i__km, config, n, gamma);
+}
+
+// Supported atmosphere policies
+template void RayTrace<GlobalAtmosphere>(double f__ghz, double h_1__km, double h_2__km, double beta_1__rad,
+    const GlobalAtmosphere& atmosphere, SlantPathAttenuationResult* result);
+template void RayTrace<RayTraceConfig>(double f__ghz, double h_1__km, double h_2__km, double beta_1__rad,
+    const RayTraceConfig& atmosphere, SlantPathAttenuationResult* result);
+template void InitRayLayers<GlobalAtmosphere>(double f__ghz, double h_1__km, double h_2__km,
+    const GlobalAtmosphere& atmosphere, RayLayers* layers);
+template void InitRayLayers<RayTraceConfig>(double f__ghz, double h_1__km, double h_2__km,
+    const RayTraceConfig& atmosphere, RayLayers* layers);
\ No newline at end of file
@@ -1,15 +1,27 @@
+#include <math.h>
 #include "../../include/p676.h"
 #include "../../include/p835.h"
 
-// Calculation the slant path attenuation due to atmospheric gases
+/*=============================================================================
+ |
+ |  Description:  Calculation the slant path attenuation due to atmospheric
+ |                gases
+ |
+ |        Input:  f__ghz        - Frequency, in GHz
+ |                h_1__km       - Height of the low terminal, in km
+ |                h_2__km       - Height of the high terminal, in km
+ |                beta_1__rad   - Elevation angle (from zenith), in rad
+ |                atmosphere    - Atmosphere policy providing GetState()
+ |
+ |       Output:  result        - Ray trace result structure
+ |
+ |      Returns:  0
+ |
+ *===========================================================================*/
+template<typename Atmosphere>
 int SlantPathAttenuation(double f__ghz, double h_1__km, double h_2__km, double beta_1__rad,
-    SlantPathAttenuationResult* result)
+    const Atmosphere& atmosphere, SlantPathAttenuationResult* result)
 {
-    RayTraceConfig config;
-    config.temperature = GlobalTemperature;
-    config.dry_pressure = GlobalPressure;
-    config.wet_pressure = GlobalWetPressure;
-
     if (beta_1__rad > PI / 2)
     {
         // negative elevation angle
@@ -17,57 +29,96 @@ int SlantPathAttenuation(double f__ghz, double h_1__km, double h_2__km, double b
         // see Section 2.2.2
 
         // compute refractive index at h_1
-        double p__hPa = config.dry_pressure(h_1__km);
-        double T__kelvin = config.temperature(h_1__km);
-        double e__hPa = config.wet_pressure(h_1__km);
+        double p__hPa, T__kelvin, e__hPa;
+        atmosphere.GetState(h_1__km, &T__kelvin, &p__hPa, &e__hPa);
 
         double n_1 = RefractiveIndex(p__hPa, T__kelvin, e__hPa);
 
-        // set initial h_G at mid-point between h_1 and surface of the earth
-        // then binary search to converge
+        double start_term = n_1 * (a_0__km + h_1__km) * sin(beta_1__rad);
+
+        // Newton's method on diff = n_G * (a_0 + h_G) - start_term, safeguarded by
+        // bisection within the bracket [0, h_1].  The state at h_1 is already known,
+        // so the search starts from the upper end of the bracket.  As with the
+        // original bisection, at least one step is always taken and the search stops
+        // once |diff| <= 0.001
+        double h_lower__km = 0;
+        double h_upper__km = h_1__km;
         double h_G__km = h_1__km;
-        double delta = h_1__km / 2;
-        double diff = 100;
+        double diff = n_1 * (a_0__km + h_1__km) - start_term;
+        double step__km = 1e-4;     // forward difference step for the derivative
 
-        double n_G;
-        double grazing_term;
-        double start_term;
+        int ITERATION_LIMIT = 100;
+        int iterations = 0;
         do
         {
-            if (diff > 0)
-                h_G__km -= delta;
-            else
-                h_G__km += delta;
-            delta /= 2;
+            atmosphere.GetState(h_G__km + step__km, &T__kelvin, &p__hPa, &e__hPa);
+            double n_step = RefractiveIndex(p__hPa, T__kelvin, e__hPa);
+            double slope = (n_step * (a_0__km + h_G__km + step__km) - start_term - diff) / step__km;
 
-            p__hPa = config.dry_pressure(h_G__km);
-            T__kelvin = config.temperature(h_G__km);
-            e__hPa = config.wet_pressure(h_G__km);
+            h_G__km -= diff / slope;
 
-            n_G = RefractiveIndex(p__hPa, T__kelvin, e__hPa);
+            // if the Newton step passes through the surface of the earth, try the surface
+            // itself; otherwise fall back to bisection if the step leaves the bracket
+            if (h_G__km <= 0 && h_lower__km == 0)
+                h_G__km = 0;
+            else if (!(h_G__km > h_lower__km && h_G__km <= h_upper__km))
+                h_G__km = (h_lower__km + h_upper__km) / 2;
 
-            grazing_term = n_G * (a_0__km + h_G__km);
-            start_term = n_1 * (a_0__km + h_1__km) * sin(beta_1__rad);
+            atmosphere.GetState(h_G__km, &T__kelvin, &p__hPa, &e__hPa);
+            double n_G = RefractiveIndex(p__hPa, T__kelvin, e__hPa);
+
+            diff = n_G * (a_0__km + h_G__km) - start_term;
+
+            if (diff > 0)
+                h_upper__km = h_G__km;
+            else
+                h_lower__km = h_G__km;
 
-            diff = grazing_term - start_term;
-        } while (abs(diff) > 0.001);
+            iterations++;
+        } while (abs(diff) > 0.001 && iterations < ITERATION_LIMIT && h_upper__km - h_lower__km > 1e-12);
 
         // converged on h_G.  Now call RayTrace in both directions with grazing angle
         SlantPathAttenuationResult result_1, result_2;
         double beta_graze__rad = PI / 2;
-        RayTrace(f__ghz, h_G__km, h_1__km, beta_graze__rad, config, &result_1);
-        RayTrace(f__ghz, h_G__km, h_2__km, beta_graze__rad, config, &result_2);
+        RayTrace<Atmosphere>(f__ghz, h_G__km, h_1__km, beta_graze__rad, atmosphere, &result_1);
+        RayTrace<Atmosphere>(f__ghz, h_G__km, h_2__km, beta_graze__rad, atmosphere, &result_2);
 
         result->angle__rad = result_2.angle__rad;
         result->A_gas__db = result_1.A_gas__db + result_2.A_gas__db;
         result->a__km = result_1.a__km + result_2.a__km;
         result->bending__rad = result_1.bending__rad + result_2.bending__rad;
         result->delta_L__km = result_1.delta_L__km + result_2.delta_L__km;
+        result->h_G__km = h_G__km;
+        result->iterations = iterations;
     }
     else
     {
-        RayTrace(f__ghz, h_1__km, h_2__km, beta_1__rad, config, result);
+        RayTrace<Atmosphere>(f__ghz, h_1__km, h_2__km, beta_1__rad, atmosphere, result);
+        result->h_G__km = h_1__km;
+        result->iterations = 0;
     }
 
     return 0;
-}
\ No newline at end of file
+}
+
+// Calculation the slant path attenuation due to atmospheric gases, using the
+// P.835 mean annual global reference atmosphere
+int SlantPathAttenuation(double f__ghz, double h_1__km, double h_2__km, double beta_1__rad,
+    SlantPathAttenuationResult* result)
+{
+    return SlantPathAttenuation<GlobalAtmosphere>(f__ghz, h_1__km, h_2__km, beta_1__rad, GlobalAtmosphere(), result);
+}
+
+// Calculation the slant path attenuation due to atmospheric gases, using a
+// custom atmosphere given as function pointers
+int SlantPathAttenuation(double f__ghz, double h_1__km, double h_2__km, double beta_1__rad,
+    RayTraceConfig config, SlantPathAttenuationResult* result)
+{
+    return SlantPathAttenuation<RayTraceConfig>(f__ghz, h_1__km, h_2__km, beta_1__rad, config, result);
+}
+
+// Supported atmosphere policies
+template int SlantPathAttenuation<GlobalAtmosphere>(double f__ghz, double h_1__km, double h_2__km, double beta_1__rad,
+    const GlobalAtmosphere& atmosphere, SlantPathAttenuationResult* result);
+template int SlantPathAttenuation<RayTraceConfig>(double f__ghz, double h_1__km, double h_2__km, double beta_1__rad,
+    const RayTraceConfig& atmosphere, SlantPathAttenuationResult* result);
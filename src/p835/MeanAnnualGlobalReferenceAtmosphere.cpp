@@ -229,4 +229,87 @@ double GlobalWaterVapourPressure(double h__km, double rho_0)
         T__kelvin = GlobalTemperature_Regime2(h__km);
     
     return WaterVapourDensityToPressure(rho, T__kelvin);
-}
\ No newline at end of file
+}
+
+/*=============================================================================
+ |
+ |  Description:  The mean annual global reference atmospheric temperature,
+ |                dry air pressure and water vapour pressure, evaluated
+ |                together.  The geopotential height is computed once and
+ |                shared by all three quantities.  The water vapour density
+ |                is floored at a mixing ratio of 2e-6.
+ |
+ |        Input:  h__km         - Geometric height, in km
+ |
+ |      Outputs:  T__kelvin     - Temperature, in Kelvin
+ |                p__hPa        - Dry air pressure, in hPa
+ |                e__hPa        - Water vapour pressure, in hPa
+ |
+ |      Returns:  0, or error code (negative number).  On error, all
+ |                outputs are set to the error code
+ |
+ *===========================================================================*/
+int GlobalAtmosphereState(double h__km, double* T__kelvin, double* p__hPa, double* e__hPa)
+{
+    int rtn = 0;
+    if (h__km < 0)
+        rtn = ERROR_HEIGHT_TOO_SMALL;
+    else if (h__km > 100)
+        rtn = ERROR_HEIGHT_TOO_LARGE;
+    else if (h__km < 86)
+    {
+        // Equations (2a-g) and (3a-g), from one geopotential height
+        double h_prime__km = ConvertToGeopotentialHeight(h__km);
+        *T__kelvin = GlobalTemperature_Regime1(h_prime__km);
+        *p__hPa = GlobalPressure_Regime1(h_prime__km);
+        if (*T__kelvin < 0)
+            rtn = (int)*T__kelvin;
+    }
+    else
+    {
+        // Equations (4a-b) and (5)
+        *T__kelvin = GlobalTemperature_Regime2(h__km);
+        *p__hPa = GlobalPressure_Regime2(h__km);
+    }
+
+    if (rtn != 0)
+    {
+        *T__kelvin = rtn;
+        *p__hPa = rtn;
+        *e__hPa = rtn;
+        return rtn;
+    }
+
+    // Equation (6), floored at a mixing ratio of 2e-6, then Equation (8)
+    double rho__g_m3 = MAX(GlobalWaterVapourDensity(h__km, RHO_0__M_KG), 2 * pow(10, -6) * 216.7 * *p__hPa / *T__kelvin);
+    *e__hPa = WaterVapourDensityToPressure(rho__g_m3, *T__kelvin);
+
+    return 0;
+}
+
+/*=============================================================================
+ |
+ |  Description:  Batch form of GlobalAtmosphereState()
+ |
+ |        Input:  h__km         - Array of geometric heights, in km
+ |                n             - Number of elements
+ |
+ |      Outputs:  T__kelvin     - Array of temperatures, in Kelvin
+ |                p__hPa        - Array of dry air pressures, in hPa
+ |                e__hPa        - Array of water vapour pressures, in hPa
+ |
+ |      Returns:  0, or the first error code encountered
+ |
+ *===========================================================================*/
+int GlobalAtmosphereStateBatch(const double* h__km, int n, double* T__kelvin, double* p__hPa, double* e__hPa)
+{
+    int rtn = 0;
+    for (int i = 0; i < n; i++)
+    {
+        int err = GlobalAtmosphereState(h__km[i], &T__kelvin[i], &p__hPa[i], &e__hPa[i]);
+        if (err != 0 && rtn == 0)
+            rtn = err;
+    }
+
+    return rtn;
+}
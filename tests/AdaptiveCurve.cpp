@@ -0,0 +1,42 @@
+#include <stdio.h>
+#include <vector>
+#include "../include/p528.h"
+
+/*=============================================================================
+ |
+ |  Description:  Builds an adaptive curve with too few samples to reach
+ |                its tolerance, which must return ERROR_CURVE__TOLERANCE
+ |                with every sample still returned, and with enough samples,
+ |                which must return SUCCESS
+ |
+ |        Usage:  p528_test_adaptive_curve
+ |
+ |      Returns:  0 if both curves return as expected, else 1
+ |
+ *===========================================================================*/
+
+#define CAPACITY                            100000
+
+int main()
+{
+    std::vector<double> d__km(CAPACITY);
+    std::vector<Result> results(CAPACITY);
+    int failures = 0;
+    int count;
+
+    // room for the initial samples and their midpoints, but not for refinement
+    int capacity = 2 * (1000 / CURVE__INITIAL_STEP__KM) + 8;
+    int rtn = P528_AdaptiveCurve(15, 10000, 1000, POLARIZATION__HORIZONTAL, 50, 1000, 0.01, capacity,
+        d__km.data(), results.data(), &count);
+    printf("capacity %d: %d, %d samples\n", capacity, rtn, count);
+    if (rtn != ERROR_CURVE__TOLERANCE || count < capacity - 2 || count > capacity)
+        failures++;
+
+    rtn = P528_AdaptiveCurve(15, 10000, 1000, POLARIZATION__HORIZONTAL, 50, 1000, 0.01, CAPACITY,
+        d__km.data(), results.data(), &count);
+    printf("capacity %d: %d, %d samples\n", CAPACITY, rtn, count);
+    if (rtn != SUCCESS)
+        failures++;
+
+    return (failures == 0) ? 0 : 1;
+}
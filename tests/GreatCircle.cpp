@@ -0,0 +1,129 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/p528.h"
+
+/*=============================================================================
+ |
+ |  Description:  Compares the polynomial great-circle distances with the
+ |                haversine formula on the standard library.  Random points,
+ |                with longitudes beyond +/-180 degrees, nearly coincident
+ |                points and nearly antipodal points, are run through
+ |                GreatCircleDistanceBatch() in lengths that are not a
+ |                multiple of GEODESIC__CHUNK, with the output in place of
+ |                the latitudes, and through GreatCircleDistance()
+ |
+ |        Usage:  p528_test_great_circle
+ |
+ |      Returns:  0 if every distance matches within tolerance, else 1
+ |
+ *===========================================================================*/
+
+#define TOLERANCE__KM                       1e-9
+#define ANTIPODAL_TOLERANCE__KM             1e-3    // Within 100 km of the antipode, where asin is ill-conditioned
+
+#define POINTS                              1000
+
+/*=============================================================================
+ |
+ |  Description:  Haversine formula on the standard library, as the
+ |                reference
+ |
+ |        Input:  lat_1__deg    - Latitude of the first point, in degrees
+ |                lon_1__deg    - Longitude of the first point, in degrees
+ |                lat_2__deg    - Latitude of the second point, in degrees
+ |                lon_2__deg    - Longitude of the second point, in degrees
+ |
+ |      Returns:  d__km         - Great-circle distance, in km
+ |
+ *===========================================================================*/
+static double Reference(double lat_1__deg, double lon_1__deg, double lat_2__deg, double lon_2__deg)
+{
+    const double deg_to_rad = PI / 180;
+
+    double sin_dlat = sin((lat_2__deg - lat_1__deg) * deg_to_rad / 2);
+    double sin_dlon = sin((lon_2__deg - lon_1__deg) * deg_to_rad / 2);
+    double h = sin_dlat * sin_dlat + cos(lat_1__deg * deg_to_rad) * cos(lat_2__deg * deg_to_rad) * sin_dlon * sin_dlon;
+
+    return 2 * a_0__km * asin(MIN(sqrt(h), 1.0));
+}
+
+/*=============================================================================
+ |
+ |  Description:  Uniform random number
+ |
+ |        Input:  a             - Lower limit
+ |                b             - Upper limit
+ |
+ |      Returns:  Random number in [a, b]
+ |
+ *===========================================================================*/
+static double Uniform(double a, double b)
+{
+    return a + (b - a) * rand() / RAND_MAX;
+}
+
+int main()
+{
+    static double lat__deg[POINTS], lon__deg[POINTS], d__km[POINTS];
+    long long failures = 0;
+    long long count = 0;
+    double error_max = 0;
+
+    srand(528);
+    for (int trial = 0; trial < 50; trial++)
+    {
+        double lat_1__deg = Uniform(-90, 90);
+        double lon_1__deg = Uniform(-360, 360);
+        int n = POINTS - trial;
+
+        for (int i = 0; i < n; i++)
+        {
+            if (i % 7 == 0)
+            {
+                lat__deg[i] = lat_1__deg + Uniform(-1e-6, 1e-6);
+                lon__deg[i] = lon_1__deg + Uniform(-1e-6, 1e-6);
+            }
+            else if (i % 11 == 0)
+            {
+                lat__deg[i] = -lat_1__deg;
+                lon__deg[i] = lon_1__deg + 180 + Uniform(-1e-3, 1e-3);
+            }
+            else
+            {
+                lat__deg[i] = Uniform(-90, 90);
+                lon__deg[i] = Uniform(-540, 540);
+            }
+        }
+
+        // odd trials write the distances over the latitudes
+        double* d = (trial % 2 == 0) ? d__km : lat__deg;
+        static double lat_copy__deg[POINTS];
+        memcpy(lat_copy__deg, lat__deg, sizeof(lat__deg));
+
+        GreatCircleDistanceBatch(lat_1__deg, lon_1__deg, lat__deg, lon__deg, n, d);
+
+        for (int i = 0; i < n; i++, count++)
+        {
+            double reference__km = Reference(lat_1__deg, lon_1__deg, lat_copy__deg[i], lon__deg[i]);
+            double tolerance__km = (reference__km < PI * a_0__km - 100) ? TOLERANCE__KM : ANTIPODAL_TOLERANCE__KM;
+
+            double error = fabs(d[i] - reference__km);
+            double error_scalar = fabs(GreatCircleDistance(lat_1__deg, lon_1__deg, lat_copy__deg[i], lon__deg[i]) - d[i]);
+            if (!(error <= tolerance__km) || !(error_scalar <= TOLERANCE__KM))
+            {
+                if (failures < 10)
+                    printf("GreatCircleDistanceBatch(%.17g, %.17g, %.17g, %.17g) = %.17g, reference %.17g\n",
+                        lat_1__deg, lon_1__deg, lat_copy__deg[i], lon__deg[i], d[i], reference__km);
+                failures++;
+            }
+            if (tolerance__km == TOLERANCE__KM && error > error_max)
+                error_max = error;
+        }
+    }
+
+    printf("%lld distances, largest difference %.3g km, %lld failures\n", count, error_max, failures);
+
+    return (failures == 0) ? 0 : 1;
+}
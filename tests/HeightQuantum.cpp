@@ -0,0 +1,100 @@
+#include <math.h>
+#include <stdio.h>
+#include "../include/p528.h"
+
+/*=============================================================================
+ |
+ |  Description:  Checks the rounding of high terminal heights to a height
+ |                quantum, by P528_Trajectory() and
+ |                P528_AggregateInterference().  Heights are validated as
+ |                given, so that rounding across the low terminal, below
+ |                1.5 m or above 20 000 m never rejects a valid input, and
+ |                the result is that of P528() at the rounded height
+ |
+ |        Usage:  p528_test_height_quantum
+ |
+ |      Returns:  0 if every case passes, else 1
+ |
+ *===========================================================================*/
+
+#define TOLERANCE__DB                       0.01
+
+// Low terminal, high terminal as given, quantum, and the height it rounds to
+static const double cases[][4] = {
+    // h_1__meter, h_2__meter, h_quantum__meter, h_rounded__meter
+    { 1003, 1004, 10, 1003 },       // rounds below the low terminal
+    { 1003, 1003, 10, 1003 },
+    { 1003, 1006, 10, 1010 },
+    {  1.5,    2, 10,  1.5 },       // rounds to 0 m
+    {  1.5,  4.9, 10,  1.5 },
+    {   10, 19996, 30, 20000 },     // rounds above 20 000 m
+    {   10, 19990, 10, 19990 },
+    {   10, 25004, 10, 25000 },     // above 20 000 m already, with a warning
+};
+
+static const double distances__km[] = { 0, 0.5, 5, 50, 400 };
+
+int main()
+{
+    int failures = 0;
+
+    /////////////////////////////////////////////
+    // P528_Trajectory() against P528() at the rounded height
+    //
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+    {
+        double h_1__meter = cases[c][0];
+        double h_2__meter = cases[c][1];
+
+        Trajectory trajectory;
+        int rtn = P528_InitTrajectory(h_1__meter, 1000, 0, cases[c][2], &trajectory);
+        if (rtn != SUCCESS)
+        {
+            printf("P528_InitTrajectory(%g) returned %i\n", h_1__meter, rtn);
+            failures++;
+            continue;
+        }
+
+        for (size_t k = 0; k < sizeof(distances__km) / sizeof(distances__km[0]); k++)
+        {
+            double d__km = distances__km[k];
+
+            Result result, expected;
+            int rtn_expected = P528(d__km, h_1__meter, h_2__meter, 1000, 0, 50, &expected);
+            int rtn_rounded = P528(d__km, h_1__meter, cases[c][3], 1000, 0, 50, &expected);
+            rtn = P528_Trajectory(&trajectory, d__km, h_2__meter, 50, &result);
+
+            // the return code is that of the height as given, the loss that of the rounded height
+            if (rtn != rtn_expected || fabs(result.A__db - expected.A__db) > TOLERANCE__DB)
+            {
+                printf("P528_Trajectory(d = %g, h_1 = %g, h_2 = %g, quantum %g) = %i, %.3f dB; "
+                    "P528() = %i, rounded height %i, %.3f dB\n", d__km, h_1__meter, h_2__meter, cases[c][2], rtn,
+                    result.A__db, rtn_expected, rtn_rounded, expected.A__db);
+                failures++;
+            }
+        }
+
+        P528_FreeTrajectory(&trajectory);
+    }
+
+    /////////////////////////////////////////////
+    // P528_AggregateInterference() with an emitter rounding across the low terminal
+    //
+
+    double d__km[] = { 50, 50 };
+    double h_2__meter[] = { 1004, 5000 };
+    double eirp__dbw[] = { 10, 10 };
+    Interference interference;
+    int rtn = P528_AggregateInterference(1003, 1000, 0, 50, d__km, h_2__meter, eirp__dbw, 2, 10, 10, 0,
+        &interference);
+    if (rtn != SUCCESS || interference.evaluated != 2)
+    {
+        printf("P528_AggregateInterference() returned %i, with %i emitters evaluated\n", rtn, interference.evaluated);
+        failures++;
+    }
+
+    printf("%i failures\n", failures);
+
+    return (failures > 0) ? 1 : 0;
+}
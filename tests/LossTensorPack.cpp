@@ -0,0 +1,130 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "../include/p528.h"
+
+/*=============================================================================
+ |
+ |  Description:  Opens damaged copies of a small loss tensor pack.  The
+ |                header counts, axes and polarization of a pack are
+ |                untrusted, so a copy with an invalid polarization, an axis
+ |                size above INT_MAX, axis sizes whose node count wraps, or
+ |                axis nodes that are not strictly increasing must be
+ |                rejected with ERROR_PACK__FORMAT, even when the checksum
+ |                is not verified
+ |
+ |        Usage:  p528_test_loss_tensor_pack [directory]
+ |
+ |      Returns:  0 if every copy is handled as expected, else 1
+ |
+ *===========================================================================*/
+
+/*=============================================================================
+ |
+ |  Description:  Writes a copy of the pack and opens it without verifying
+ |                the checksum
+ |
+ |        Input:  name          - Name of the damage
+ |                filename      - Path of the copy
+ |                bytes         - Contents of the copy
+ |                expected      - Expected return code
+ |
+ |      Returns:  1 if the return code is not the expected one, else 0
+ |
+ *===========================================================================*/
+static int Check(const char* name, const char* filename, const std::vector<unsigned char>& bytes, int expected)
+{
+    FILE* file = fopen(filename, "wb");
+    if (file == NULL || fwrite(bytes.data(), 1, bytes.size(), file) != bytes.size() || fclose(file) != 0)
+    {
+        printf("%s: could not write %s\n", name, filename);
+        return 1;
+    }
+
+    LossTensor tensor;
+    int rtn = LossTensor_OpenPack(filename, 0, &tensor);
+    if (rtn == SUCCESS)
+        LossTensor_Free(&tensor);
+
+    printf("%s: %d\n", name, rtn);
+    if (rtn != expected)
+    {
+        printf("%s: expected %d\n", name, expected);
+        return 1;
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    const char* directory = (argc > 1) ? argv[1] : ".";
+    char filename[1024];
+    snprintf(filename, sizeof(filename), "%s/p528_test_loss_tensor.pack", directory);
+
+    double d__km[] = { 10, 100 };
+    double h_1__meter[] = { 10, 100 };
+    double h_2__meter[] = { 1000, 2000 };
+    double f__mhz[] = { 500, 1000 };
+    double p[] = { 10, 50 };
+
+    LossTensor tensor;
+    int rtn = LossTensor_Build(d__km, 2, h_1__meter, 2, h_2__meter, 2, f__mhz, 2, p, 2, POLARIZATION__HORIZONTAL, &tensor);
+    if (rtn == SUCCESS)
+        rtn = LossTensor_WritePack(&tensor, filename);
+    LossTensor_Free(&tensor);
+    if (rtn != SUCCESS)
+    {
+        printf("pack: %d\n", rtn);
+        return 1;
+    }
+
+    FILE* file = fopen(filename, "rb");
+    std::vector<unsigned char> pack;
+    int c;
+    while (file != NULL && (c = fgetc(file)) != EOF)
+        pack.push_back((unsigned char)c);
+    if (file != NULL)
+        fclose(file);
+    if (pack.size() <= PACK__HEADER_SIZE)
+    {
+        printf("pack: could not read %s\n", filename);
+        return 1;
+    }
+
+    int failures = Check("intact", filename, pack, SUCCESS);
+
+    std::vector<unsigned char> copy = pack;
+    PackU32(&copy[32], 2);
+    failures += Check("polarization", filename, copy, ERROR_PACK__FORMAT);
+
+    copy = pack;
+    PackU32(&copy[36], 0x80000002u);
+    failures += Check("axis size above INT_MAX", filename, copy, ERROR_PACK__FORMAT);
+
+    // 2^16 nodes on every axis wraps a 64-bit node count to 0
+    copy = pack;
+    for (int k = 0; k < LOSS_TENSOR__AXIS_COUNT; k++)
+        PackU32(&copy[36 + 4 * k], 0x10000u);
+    failures += Check("wrapped node count", filename, copy, ERROR_PACK__FORMAT);
+
+    // swap the two nodes of the first axis
+    copy = pack;
+    for (int i = 0; i < 8; i++)
+    {
+        unsigned char byte = copy[PACK__HEADER_SIZE + i];
+        copy[PACK__HEADER_SIZE + i] = copy[PACK__HEADER_SIZE + 8 + i];
+        copy[PACK__HEADER_SIZE + 8 + i] = byte;
+    }
+    failures += Check("decreasing axis", filename, copy, ERROR_PACK__FORMAT);
+
+    copy = pack;
+    PackU64(&copy[PACK__HEADER_SIZE + 8], 0x7FF8000000000000ull);
+    failures += Check("NaN node", filename, copy, ERROR_PACK__FORMAT);
+
+    remove(filename);
+
+    return (failures == 0) ? 0 : 1;
+}
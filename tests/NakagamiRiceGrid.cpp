@@ -0,0 +1,129 @@
+#include <math.h>
+#include <stdio.h>
+#include "../include/p528.h"
+
+/*=============================================================================
+ |
+ |  Description:  Compares the uniform-grid Nakagami-Rice lookups with the
+ |                reference functions they replace.  NakagamiRiceFast() is
+ |                swept over K in [-45, 25] and p in [1, 99], and
+ |                FindKForYpiAt99PercentFast() over Y_pi(99) in [-1, 20],
+ |                each on a fine grid plus every tabulated node.  The batch
+ |                forms are checked against the scalar ones
+ |
+ |        Usage:  p528_test_nakagami_rice_grid
+ |
+ |      Returns:  0 if every lookup matches within TOLERANCE__DB, else 1
+ |
+ *===========================================================================*/
+
+#define TOLERANCE__DB                       1e-12
+
+// Tabulated K-values and percentages, from data::K and data::P
+static const double K_nodes[] = { -40, -25, -20, -18, -16, -14, -12, -10, -8, -6, -4, -2, 0, 2, 4, 6, 20 };
+static const double p_nodes[] = { 1, 2, 5, 10, 15, 20, 30, 40, 50, 60, 70, 80, 85, 90, 95, 98, 99 };
+
+/*=============================================================================
+ |
+ |  Description:  Records the difference between a lookup and its reference
+ |
+ |        Input:  name          - Name of the lookup
+ |                x             - First input of the lookup
+ |                y             - Second input of the lookup, or NAN
+ |                fast          - Value of the lookup
+ |                reference     - Value of the reference function
+ |
+ |      Outputs:  error_max     - Largest difference so far
+ |                failures      - Number of differences above TOLERANCE__DB
+ |
+ |      Returns:  [void]
+ |
+ *===========================================================================*/
+static void Check(const char* name, double x, double y, double fast, double reference,
+    double* error_max, long long* failures)
+{
+    double error = fabs(fast - reference);
+    if (!(error <= TOLERANCE__DB))
+    {
+        if (*failures < 10)
+            printf("%s(%.17g, %.17g) = %.17g, reference %.17g\n", name, x, y, fast, reference);
+        (*failures)++;
+    }
+    if (error > *error_max)
+        *error_max = error;
+}
+
+int main()
+{
+    long long failures = 0;
+    long long count = 0;
+    double error_max;
+
+    /////////////////////////////////////////////
+    // NakagamiRiceFast() against NakagamiRice()
+    //
+
+    std::vector<double> K;
+    std::vector<double> p;
+    for (int i = 0; i <= 1400; i++)
+        K.push_back(-45 + 0.05 * i);
+    for (int j = 0; j <= 4900; j++)
+        p.push_back(1 + 0.02 * j);
+    K.insert(K.end(), K_nodes, K_nodes + sizeof(K_nodes) / sizeof(K_nodes[0]));
+    p.insert(p.end(), p_nodes, p_nodes + sizeof(p_nodes) / sizeof(p_nodes[0]));
+
+    error_max = 0;
+    std::vector<double> K_row(p.size());
+    std::vector<double> Y_pi__db(p.size());
+    for (size_t i = 0; i < K.size(); i++)
+    {
+        for (size_t j = 0; j < p.size(); j++)
+        {
+            Check("NakagamiRiceFast", K[i], p[j], NakagamiRiceFast(K[i], p[j]), NakagamiRice(K[i], p[j]),
+                &error_max, &failures);
+            K_row[j] = K[i];
+        }
+
+        NakagamiRiceBatch(K_row.data(), p.data(), (int)p.size(), Y_pi__db.data());
+        for (size_t j = 0; j < p.size(); j++)
+            Check("NakagamiRiceBatch", K[i], p[j], Y_pi__db[j], NakagamiRiceFast(K[i], p[j]),
+                &error_max, &failures);
+
+        count += p.size();
+    }
+    printf("NakagamiRiceFast: %lld points, largest difference %g dB\n", count, error_max);
+
+    /////////////////////////////////////////////
+    // FindKForYpiAt99PercentFast() against FindKForYpiAt99Percent()
+    //
+
+    std::vector<double> Y_pi_99__db;
+    for (int i = 0; i <= 2100000; i++)
+        Y_pi_99__db.push_back(-1 + 1e-5 * i);
+
+    // every tabulated Y_pi(99), and its neighbors
+    for (size_t i = 0; i < sizeof(K_nodes) / sizeof(K_nodes[0]); i++)
+    {
+        double Y__db = NakagamiRice(K_nodes[i], 99);
+        Y_pi_99__db.push_back(Y__db);
+        Y_pi_99__db.push_back(nextafter(Y__db, -INFINITY));
+        Y_pi_99__db.push_back(nextafter(Y__db, INFINITY));
+    }
+
+    error_max = 0;
+    std::vector<double> K_batch(Y_pi_99__db.size());
+    FindKForYpiAt99PercentBatch(Y_pi_99__db.data(), (int)Y_pi_99__db.size(), K_batch.data());
+    for (size_t i = 0; i < Y_pi_99__db.size(); i++)
+    {
+        double K_fast = FindKForYpiAt99PercentFast(Y_pi_99__db[i]);
+        Check("FindKForYpiAt99PercentFast", Y_pi_99__db[i], NAN, K_fast, FindKForYpiAt99Percent(Y_pi_99__db[i]),
+            &error_max, &failures);
+        Check("FindKForYpiAt99PercentBatch", Y_pi_99__db[i], NAN, K_batch[i], K_fast, &error_max, &failures);
+    }
+    printf("FindKForYpiAt99PercentFast: %zu points, largest difference %g\n", Y_pi_99__db.size(), error_max);
+
+    if (failures > 0)
+        printf("%lld lookups differ by more than %g\n", failures, TOLERANCE__DB);
+
+    return (failures > 0) ? 1 : 0;
+}
@@ -0,0 +1,34 @@
+#include <math.h>
+#include <stdio.h>
+#include "../include/p528.h"
+
+/*=============================================================================
+ |
+ |  Description:  Regression test for the Nakagami-Rice variability at a
+ |                time percentage between the tabulated ones.  Up to release
+ |                5.1, the lower-percentage curve was read 1 dB off, which
+ |                gave 86.699130 dB for this path
+ |
+ |        Usage:  p528_test_off_table_percentage
+ |
+ |      Returns:  0 if the loss matches within TOLERANCE__DB, else 1
+ |
+ *===========================================================================*/
+
+#define TOLERANCE__DB                       1e-6
+
+int main()
+{
+    const double A_expected__db = 87.145805;
+
+    Result result;
+    int rtn = P528(5, 1.5, 1000, 125, POLARIZATION__HORIZONTAL, 3, &result);
+
+    printf("P528(5, 1.5, 1000, 125, 0, 3) = %.6f dB, return %d, expected %.6f dB\n",
+        result.A__db, rtn, A_expected__db);
+
+    if (rtn != SUCCESS || !(fabs(result.A__db - A_expected__db) <= TOLERANCE__DB))
+        return 1;
+
+    return 0;
+}